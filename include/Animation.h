@@ -0,0 +1,107 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+#include <SDL.h>
+#include <string>
+#include <vector>
+#include "Atlas.h"
+#include "SoftBlit.h"
+
+class LTexture;
+class SoftImage;
+
+//Where the clips of the sprite sheets are described, next to the images
+const char* const ANIMATION_MANIFEST = "animations.txt";
+
+//One animation of a sprite sheet that is in the atlas: frameCount frames of frameWidth x frameHeight, from left to right
+//and from top to bottom in rows of columns frames. Each frame is shown ticksPerFrame ticks, and then it loops or stays on the last one
+struct AnimationClip{
+    std::string name;
+    std::string image;
+    int frameWidth;
+    int frameHeight;
+    int columns;
+    int frameCount;
+    int ticksPerFrame;
+    bool loop;
+
+    //Where its frames start in the frames of the library, once it is resolved
+    int firstFrame;
+};
+
+//Every clip of the manifest, with the rectangles of its frames in the atlas
+class AnimationLibrary
+{
+    public:
+        //Reads the manifest. Each line is "name image frameWidth frameHeight columns frames ticksPerFrame loop|once",
+        //where image is the region of the atlas. Empty lines and lines that start with # are skipped
+        bool load(std::string path);
+
+        //Adds a clip by hand, for the ones the game can't do without
+        void addClip(const AnimationClip& clip);
+
+        //Finds the frames of every clip in the regions of the atlas. A clip whose image isn't there, or doesn't fit in it,
+        //is left out with a message. Returns false if none is left
+        bool resolve(const std::vector<AtlasRegion>& regions);
+
+        //Returns the index of a clip, or -1 if there isn't one
+        int find(std::string name) const;
+
+        int getClipCount() const { return (int)mClips.size(); }
+        const AnimationClip& getClip(int clip) const { return mClips[clip]; }
+
+        //The frame that shows ticks after the clip started
+        int getFrame(int clip, double ticks) const;
+
+        //Where a frame of a clip is in the atlas
+        const SDL_Rect& getFrameRect(int clip, int frame) const { return mFrames[mClips[clip].firstFrame + frame]; }
+
+    private:
+        std::vector<AnimationClip> mClips;
+        std::vector<SDL_Rect> mFrames;
+};
+
+//Many animated sprites of one atlas. Each field of the sprites is an array of its own, so update goes through the
+//times alone and draw reads them in order, and a sprite takes 20 bytes. The sprites are drawn in the order they were added,
+//all of them from the same texture with LTexture::renderBatch: one draw with SDL 2.0.18 or newer, one copy each before
+class SpriteBatch
+{
+    public:
+        //Adds a sprite that plays clip with the top left corner of its frames at (x, y), turned by angle degrees
+        //around their center, ticks into the clip. Returns its index
+        int add(int clip, int x, int y, float angle = 0, float ticks = 0);
+
+        //The last sprite takes the index of the one that goes
+        void remove(int sprite);
+        void clear();
+        int getCount() const { return (int)mClips.size(); }
+
+        void setPosition(int sprite, int x, int y);
+        void setAngle(int sprite, float angle);
+        void setTime(int sprite, float ticks);
+
+        //Moves every clip forward, in one pass
+        void update(float ticks);
+
+        //Draws every sprite with the renderer, from the atlas texture, with alpha for all of them
+        void draw(SDL_Renderer* renderer, LTexture& atlas, const AnimationLibrary& library, Uint8 alpha = 0xFF);
+
+        //The same with the software blitter, from the atlas in memory. It can't turn and fade at once,
+        //so see-through sprites are drawn straight
+        void blit(const PixelView& canvas, const SoftImage& atlas, const AnimationLibrary& library, BlitKernel kernel, Uint8 alpha = 0xFF);
+
+        //The part of the screen that a sprite can cover, turned any way
+        SDL_Rect getBounds(int sprite, const AnimationLibrary& library) const;
+
+    private:
+        std::vector<int> mClips;
+        std::vector<float> mTimes;
+        std::vector<float> mAngles;
+        std::vector<int> mX;
+        std::vector<int> mY;
+
+        //Filled by draw for the renderer. They only grow, so drawing doesn't allocate
+        std::vector<SDL_Rect> mSources;
+        std::vector<SDL_Rect> mDestinations;
+};
+
+#endif // ANIMATION_H
@@ -0,0 +1,64 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+#include <SDL.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+
+//Decodes assets on the workers of a pool and gives the results back to the render thread,
+//which is the only one allowed to create textures
+class AssetLoader
+{
+    public:
+        //Makes a surface. It runs on a worker, so it must not touch the renderer
+        typedef std::function<SDL_Surface*()> DecodeFunction;
+
+        //Turns the surface into textures on the render thread. It owns the surface (which is NULL if the decode failed)
+        typedef std::function<bool(SDL_Surface*)> UploadFunction;
+
+        AssetLoader(ThreadPool& pool);
+
+        //Waits for the decodes that are still running and frees what was never uploaded
+        ~AssetLoader();
+
+        //Queues an asset. name is only for the report
+        void add(std::string name, DecodeFunction decode, UploadFunction upload);
+
+        //Uploads every asset that has been decoded since the last call. Returns false if any of them failed
+        bool update();
+
+        int getFinished();
+        int getTotal();
+        bool isDone();
+
+        //Prints how long each asset took to decode and to upload, and the whole loading time
+        void printReport();
+
+    private:
+        struct Job{
+            std::string name;
+            DecodeFunction decode;
+            UploadFunction upload;
+            SDL_Surface* surface;
+            double decodeMs;
+            double uploadMs;
+            bool uploaded;
+            bool failed;
+        };
+
+        ThreadPool& mPool;
+
+        //Every job, and the ones that are decoded but not uploaded yet (guarded by mMutex)
+        std::vector<Job*> mJobs;
+        std::vector<Job*> mDecoded;
+        std::mutex mMutex;
+
+        int mFinished;
+        Uint64 mStart;
+        Uint64 mEnd;
+};
+
+#endif // ASSETLOADER_H
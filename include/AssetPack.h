@@ -0,0 +1,104 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+#include <SDL.h>
+#include <string>
+#include <vector>
+#include "Atlas.h"
+
+//Made by the AssetPacker tool. When it is there the game doesn't decode any png or read the font file
+const char* const ASSET_PACK = "assets.pack";
+
+//The font of the game. It goes in the pack as it is, only parsing it is left for the game
+const char* const FONT_FILE = "University.ttf";
+
+const Uint32 ASSET_PACK_VERSION = 1;
+
+//Every block of data in the pack starts at a multiple of this, so the pixels can be used right from the mapping
+const Uint32 ASSET_PACK_ALIGN = 64;
+
+//The layout of the file. Numbers are stored as the machine that packed it has them, the pack is made on the same machine that plays it.
+//  PackHeader, then entryCount PackEntry, then regionCount PackRegion, then the data of every entry
+struct PackHeader{
+    char magic[4];
+    Uint32 version;
+    Uint32 entryCount;
+    Uint32 regionCount;
+};
+
+struct PackEntry{
+    char name[32];
+    //SDL_PIXELFORMAT_* of the pixels, or SDL_PIXELFORMAT_UNKNOWN if it is just bytes (like the font)
+    Uint32 format;
+    Uint32 width;
+    Uint32 height;
+    Uint32 pitch;
+    Uint32 offset;
+    Uint32 size;
+    //The named regions of the image, when it is an atlas
+    Uint32 firstRegion;
+    Uint32 regionCount;
+};
+
+struct PackRegion{
+    char name[32];
+    Sint32 x;
+    Sint32 y;
+    Sint32 w;
+    Sint32 h;
+};
+
+//Something to write in a pack: a surface (with its regions, if any) or some bytes
+struct AssetPackItem{
+    std::string name;
+    SDL_Surface* surface;
+    std::vector<AtlasRegion> regions;
+    std::vector<char> bytes;
+};
+
+//Writes the items in a new pack. The surfaces are written as they are, so convert them to the format the renderer wants first
+bool writeAssetPack(std::string path, const std::vector<AssetPackItem>& items);
+
+//A pack mapped in memory. Nothing is copied out of it: textures are made from the mapped pixels,
+//and the font reads from the mapped bytes, so the pack has to stay open while they are in use
+class AssetPack
+{
+    public:
+        AssetPack();
+        ~AssetPack();
+
+        //Maps the file and checks its tables. Returns false if it isn't there or it isn't a valid pack
+        bool open(std::string path);
+        void close();
+        bool isOpen();
+
+        //Returns the entry with that name, or NULL if there isn't one
+        const PackEntry* find(std::string name) const;
+
+        //Where the data of an entry starts in the mapping
+        const void* getData(const PackEntry* entry) const;
+
+        //A surface over the mapped pixels of an image, without copying them. Free it with SDL_FreeSurface, the pixels stay in the pack
+        SDL_Surface* getSurface(std::string name) const;
+
+        //An SDL_RWops over the mapped bytes of an entry, for TTF_OpenFontRW and friends
+        SDL_RWops* getRW(std::string name) const;
+
+        //The regions of an image, as the atlas manifest would give them
+        std::vector<AtlasRegion> getRegions(std::string name) const;
+
+    private:
+        //The whole file, read only
+        const char* mData;
+        size_t mSize;
+
+        const PackHeader* mHeader;
+        const PackEntry* mEntries;
+        const PackRegion* mRegions;
+
+#ifdef _WIN32
+        void* mFile;
+        void* mMapping;
+#endif
+};
+
+#endif // ASSETPACK_H
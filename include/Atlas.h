@@ -0,0 +1,52 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+//Where the packer tool writes the atlas, and where the game looks for it
+const char* const ATLAS_IMAGE = "atlas.png";
+const char* const ATLAS_MANIFEST = "atlas.txt";
+
+//Width of the atlas. The sun and the floor are 1600px wide, so they fit with their padding
+const int ATLAS_WIDTH = 1608;
+
+//Empty pixels around every region, so the linear filtering of the rotated egg doesn't pick its neighbours
+const int ATLAS_PADDING = 2;
+
+//The images that go into the game atlas. Each region is named like its file, without the extension
+const int GAME_IMAGE_COUNT = 6;
+extern const char* const GAME_IMAGES[GAME_IMAGE_COUNT];
+
+struct PixelMasks;
+
+//A named rectangle inside an atlas
+struct AtlasRegion{
+    std::string name;
+    SDL_Rect rect;
+};
+
+//Loads an image as 32 bit ARGB with the red color key already turned into transparent pixels
+SDL_Surface* loadKeyedSurface(std::string path);
+
+//Packs the images in a new surface of maxWidth pixels wide and as tall as needed.
+//regions gets the place of every image, with its name
+SDL_Surface* packAtlas(const std::vector<SDL_Surface*>& images, const std::vector<std::string>& names, int maxWidth, std::vector<AtlasRegion>& regions);
+
+//Packs the images of the game, already loaded in the order of GAME_IMAGES
+SDL_Surface* packGameAtlas(const std::vector<SDL_Surface*>& images, std::vector<AtlasRegion>& regions);
+
+//Loads and packs sun.png, floor.png, pipe.png, spritedPlayer.png, frame.png and spritedmonigote.png
+SDL_Surface* buildGameAtlas(std::vector<AtlasRegion>& regions);
+
+//The collision masks of the egg and the pipe, from an atlas of any format with the regions of the game
+bool buildGameMasks(SDL_Surface* atlas, const std::vector<AtlasRegion>& regions, PixelMasks& masks);
+
+//The manifest has one line per region: "name x y w h"
+bool saveAtlasManifest(std::string path, const std::vector<AtlasRegion>& regions);
+bool loadAtlasManifest(std::string path, std::vector<AtlasRegion>& regions);
+
+//Returns the region with that name, or NULL if there isn't one
+const AtlasRegion* findAtlasRegion(const std::vector<AtlasRegion>& regions, std::string name);
+
+#endif // ATLAS_H
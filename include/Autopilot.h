@@ -0,0 +1,116 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "World.h"
+#include "ThreadPool.h"
+
+//The longest search, in ticks
+const int AUTOPILOT_MAX_HORIZON = 240;
+
+//The simple player of the benchmark: it flaps when the egg is under the middle of the hole of the next pipe
+bool heuristicFlap(const World& world);
+
+//A player that never stops. Every tick it copies the world (a World is a plain struct, so a copy doesn't allocate)
+//and steps the copies with the real rules to find flaps that keep the egg alive for the next horizon ticks.
+//It only decides every DECISION_TICKS ticks of the game, flap or not, on the same ticks whenever it searches,
+//so what it planned on the previous tick still falls on a decision and is tried first.
+//The pipes move the same whatever the egg does, so two copies at the same tick with the same egg are the same node:
+//the egg of every node that can't reach the horizon is kept, and the search doesn't go through it twice.
+//The first decisions are split in PREFIX_COUNT branches that the pool searches at the same time: the first one that
+//survives in the order of a plain search wins, so within the budget it decides the same whatever the threads.
+//When the budget runs out it takes the branch that lived longest
+class Autopilot
+{
+    public:
+        //horizon is in ticks, the budget is the wall time of one decision. 0 threads uses one per core.
+        //A budget of 0 has no limit: the decisions don't depend on the clock, so a game always plays the same
+        Autopilot(int horizon = 150, double budgetMicroseconds = 4000, int threads = 0);
+
+        //Whether to flap on the next step of world
+        bool decide(const World& world);
+
+        //Forgets the plan, for a new game
+        void reset();
+
+        int getThreadCount() { return mPool.getThreadCount(); }
+        long long getDecisions() const { return mDecisions; }
+
+        //Every step of a copied world is a node
+        long long getNodes() const { return mNodes; }
+        double getSearchSeconds() const { return mSearchSeconds; }
+        double getNodesPerSecond() const { return mSearchSeconds > 0 ? mNodes / mSearchSeconds : 0; }
+        double getWorstMicroseconds() const { return mWorstMicroseconds; }
+
+        //Decisions that ran out of budget before finding a way through the whole horizon,
+        //and decisions where every way dies before it (the egg was already lost)
+        long long getTimeouts() const { return mTimeouts; }
+        long long getDeadEnds() const { return mDeadEnds; }
+
+        //Decisions where the first branch, the one that follows the plan of the previous tick, survived
+        long long getCarriedPlans() const { return mCarriedPlans; }
+
+        void printStats(FILE* file);
+        void writeJson(FILE* file);
+
+    private:
+        static const int DECISION_TICKS = 3;
+        static const int PREFIX_DECISIONS = 3;
+        static const int PREFIX_COUNT = 1 << PREFIX_DECISIONS;
+
+        //The nodes that a branch has seen fail, as hashes of their tick and egg. The table is made once, and a new
+        //decision just changes the stamp that the entries need to count
+        static const int FAILED_SLOTS = 1 << 14;
+        static const int FAILED_PROBES = 8;
+
+        //What one branch found: whether it got to the horizon, how far it lived and the flaps it took
+        struct Branch{
+            bool survived;
+            bool timedOut;
+            int depth;
+            long long nodes;
+            bool plan[AUTOPILOT_MAX_HORIZON];
+            std::vector<uint64_t> failedKeys;
+            std::vector<unsigned int> failedStamps;
+            unsigned int stamp;
+        };
+
+        static uint64_t nodeKey(const World& world, int tick);
+        static bool hasFailed(const Branch& branch, uint64_t key);
+        static void addFailed(Branch& branch, uint64_t key);
+
+        //The search of one branch, on any thread
+        void searchBranch(int index, const World& world, Branch& branch);
+        bool searchFrom(const World& world, int tick, Branch& branch, bool* plan, int index);
+
+        //The action tried first on a tick: the one of the previous plan, or the simple player past its end
+        bool preferred(int tick, const World& world) const;
+
+        ThreadPool mPool;
+        int mHorizon;
+        double mBudget;
+
+        //Read by every branch while they search, and only written between decisions
+        bool mPlan[AUTOPILOT_MAX_HORIZON];
+        int mPlanLength;
+        //Ticks since the last tick of the decision grid, counting from the start of the game
+        int mPhase;
+        std::chrono::steady_clock::time_point mDeadline;
+
+        //The first branch that has survived, so the ones after it stop
+        std::atomic<int> mWinner;
+
+        Branch mBranches[PREFIX_COUNT];
+        long long mDecisions;
+        long long mNodes;
+        long long mTimeouts;
+        long long mDeadEnds;
+        long long mCarriedPlans;
+        double mSearchSeconds;
+        double mWorstMicroseconds;
+};
+
+#endif // AUTOPILOT_H
@@ -0,0 +1,177 @@
+#ifndef BROADCAST_H
+#define BROADCAST_H
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "World.h"
+
+//The port that --broadcast and --ghost use when none is given
+const int BROADCAST_PORT = 27960;
+
+//How many ticks back a snapshot can be the base of a delta. Older acks get a whole snapshot
+const int GHOST_HISTORY = 64;
+
+//The smallest budget of a server: a whole egg always fits, the pipes are what a budget cuts
+const int GHOST_MIN_BUDGET = 32;
+const int GHOST_MAX_PACKET = 512;
+
+//What the viewers get of a remote game every tick: the egg, the points and the pipes, all as integers.
+//The angle goes in hundredths of a degree. Tick 0 is the empty state that whole snapshots are a delta of
+struct GhostState{
+    unsigned int tick;
+    int posY;
+    int centidegrees;
+    int frame;
+    int points;
+    bool dead;
+    int pipeCount;
+    int pipeX[MAX_PIPES];
+    int pipeGap[MAX_PIPES];
+};
+
+GhostState makeGhostState(const World& world, unsigned int tick);
+GhostState emptyGhostState();
+bool sameGhostState(const GhostState& a, const GhostState& b);
+
+//The packets are deltas of the state against one that the viewer has acknowledged (or against the empty state):
+//  'G', tick (32 bit little endian), ticks back to the base (LEB128, 0 for the empty state), a byte with which fields changed,
+//  then each changed field as a zigzag LEB128 difference. The pipes only move left all together, so they go as how many
+//  left the screen, how far the rest moved, and the new ones in full: about 12 bytes a tick once the viewer is in sync.
+//The egg always goes, and then the pipes only if they fit in budget bytes: new pipes that don't fit are left for the next tick,
+//and sent gets what the viewer will really have, which is what the next deltas have to be based on. Below GHOST_MIN_BUDGET
+//the egg alone can go over the budget, and below about 16 bytes the pipes, which move every tick, never catch up.
+//Returns the bytes of the packet
+int encodeGhost(const GhostState& base, const GhostState& current, uint8_t* packet, int budget, GhostState& sent);
+
+//The tick of a packet and the tick of its base (0 for the empty state). Returns false if it isn't a ghost packet
+bool readGhostHeader(const uint8_t* packet, int size, unsigned int& tick, unsigned int& baseTick);
+
+//Applies the delta of a packet to its base. Returns false if the packet is broken
+bool decodeGhost(const uint8_t* packet, int size, const GhostState& base, GhostState& state);
+
+//A non-blocking UDP socket. The addresses are IPv4 in network order
+struct NetAddress{
+    uint32_t host;
+    uint16_t port;
+};
+
+class UdpSocket
+{
+    public:
+        UdpSocket();
+        ~UdpSocket();
+
+        //Listens on port, or any free one with 0
+        bool open(int port);
+        void close();
+        bool isOpen() const { return mHandle != INVALID; }
+
+        //Returns false if the packet couldn't be sent now. UDP can lose it anyway
+        bool sendTo(const NetAddress& address, const uint8_t* data, int size);
+
+        //Takes one packet that has arrived, or returns -1 if there isn't any
+        int receive(uint8_t* data, int capacity, NetAddress& from);
+
+        //"host:port" or "host", with the default port
+        static bool resolve(const std::string& text, int defaultPort, NetAddress& address);
+        static std::string toString(const NetAddress& address);
+
+    private:
+        static const intptr_t INVALID = -1;
+        intptr_t mHandle;
+};
+
+//Sends the ghost of this game to every viewer that has asked for it in the last seconds. publish goes after every tick,
+//on the thread that steps the world, and it also reads the acks: nothing waits for the network
+class GhostServer
+{
+    public:
+        GhostServer();
+
+        bool start(int port, int budget);
+        void stop();
+        bool isRunning() const { return mSocket.isOpen(); }
+
+        void publish(const World& world, unsigned int tick);
+
+        //Only after the thread that publishes has stopped
+        void printStats(FILE* file) const;
+
+        //Everything that it has sent, for the tools
+        long long getPackets() const { return mPackets; }
+        long long getBytes() const { return mBytes; }
+
+    private:
+        static const int MAX_VIEWERS = 8;
+
+        //A viewer, the last tick it has acknowledged, and what it was sent for each of the last ticks
+        struct Viewer{
+            NetAddress address;
+            unsigned int acked;
+            std::chrono::steady_clock::time_point lastHeard;
+            std::vector<GhostState> sent;
+        };
+
+        void readAcks();
+        Viewer* findViewer(const NetAddress& address);
+
+        UdpSocket mSocket;
+        int mBudget;
+        std::vector<Viewer> mViewers;
+
+        long long mTicks;
+        long long mPackets;
+        long long mBytes;
+        int mMaxBytes;
+        long long mWholeSnapshots;
+        long long mTrimmed;
+        double mEncodeSeconds;
+        int mMostViewers;
+};
+
+//Receives the ghost of one remote game. poll takes every packet that has arrived and acknowledges the newest tick
+class GhostClient
+{
+    public:
+        GhostClient();
+
+        //address is "host:port"
+        bool connect(const std::string& address);
+        void close();
+
+        //Returns true if there is a newer state
+        bool poll();
+
+        bool hasState() const { return mLatest.tick != 0; }
+        const GhostState& getState() const { return mLatest; }
+        const std::string& getName() const { return mName; }
+
+        //Drops this percent of the packets that arrive, to test a bad network over loopback
+        void setSimulatedLoss(int percent) { mLoss = percent; }
+
+        void printStats(FILE* file) const;
+
+    private:
+        void sendAck();
+
+        UdpSocket mSocket;
+        NetAddress mServer;
+        std::string mName;
+        std::vector<GhostState> mHistory;
+        GhostState mLatest;
+        std::chrono::steady_clock::time_point mLastAck;
+        int mLoss;
+        unsigned int mLossSeed;
+
+        long long mPackets;
+        long long mBytes;
+        long long mLost;
+        long long mNoBase;
+        long long mBroken;
+        long long mDecoded;
+        double mDecodeSeconds;
+};
+
+#endif // BROADCAST_H
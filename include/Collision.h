@@ -0,0 +1,61 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+#include "World.h"
+
+//Every pipe collides as two boxes: the pipe above the hole and the pipe below it.
+//The slots of a span are only 5px apart and the egg is 60px tall, so one box per span hits exactly when one of its slots does
+const int SEGMENTS_PER_PIPE = 2;
+
+//Room for the segments of every pipe of a world, rounded up to whole 8-wide vectors
+const int MAX_SEGMENTS = (SEGMENTS_PER_PIPE * MAX_PIPES + 7) / 8 * 8;
+
+//Where the bottom span of every pipe ends, whatever its hole
+const int PIPE_BOTTOM_SPAN_END = (PIPE_SLOTS - 2) * PIPE_TILE_HEIGHT + FREE_SPACE + PIPE_COLLISION_HEIGHT;
+
+//Where the top span ends and the bottom span starts for a pipe with the hole at slot freeSpot
+inline int pipeTopSpanEnd(int freeSpot){
+    return (freeSpot - 1) * PIPE_TILE_HEIGHT + PIPE_COLLISION_HEIGHT;
+}
+
+inline int pipeBottomSpanStart(int freeSpot){
+    return freeSpot * PIPE_TILE_HEIGHT + FREE_SPACE;
+}
+
+//The collision boxes of one world, one array per coordinate so we can test several of them at once.
+//A box covers [x0, x1] x [y0, y1] with the edges included, like collisionWithCharacter. Unused slots never collide
+struct SegmentList{
+    int x0[MAX_SEGMENTS];
+    int x1[MAX_SEGMENTS];
+    int y0[MAX_SEGMENTS];
+    int y1[MAX_SEGMENTS];
+    int count;
+};
+
+//The different ways we have to test the segments
+enum CollisionKernel{
+    COLLISION_SCALAR,
+    COLLISION_SSE2,
+    COLLISION_AVX2
+};
+
+//Turns the alive pipes into their top and bottom spans. The last one reads the pipes of a WorldBatch
+void buildPipeSegments(const Pipe* pipes, int totalPipe, SegmentList& segments);
+void buildPipeSegments(const PipeRing& pipes, SegmentList& segments);
+void buildPipeSegments(const int* xPosition, const int* freeSpotPosition, int totalPipe, SegmentList& segments);
+
+//True when the egg at posY touches any segment, using the best kernel this CPU has
+bool segmentsHitCharacter(const SegmentList& segments, int posY);
+
+//Same test for a batch: world w has segments[w] and its egg at posY[w]; hits[w] gets the result
+void segmentsHitCharacters(const SegmentList* segments, const int* posY, int count, unsigned char* hits);
+
+//Each kernel on its own, for the benchmarks. Only call the SIMD ones when collisionKernelSupported says so
+bool segmentsHitCharacterScalar(const SegmentList& segments, int posY);
+bool segmentsHitCharacterSSE2(const SegmentList& segments, int posY);
+bool segmentsHitCharacterAVX2(const SegmentList& segments, int posY);
+
+bool collisionKernelSupported(CollisionKernel kernel);
+CollisionKernel getCollisionKernel();
+const char* getCollisionKernelName(CollisionKernel kernel);
+
+#endif // COLLISION_H
@@ -0,0 +1,59 @@
+#ifndef COLLISIONMASK_H
+#define COLLISIONMASK_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "World.h"
+#include "SoftBlit.h"
+
+//The opaque pixels of an image, one bit each: bit i of word k of a row is the column 64 * k + i.
+//It is cut down to the box around its opaque pixels, and (x, y) is where that box starts in the image it was made from
+struct CollisionMask{
+    int x;
+    int y;
+    int width;
+    int height;
+    int words;
+    std::vector<uint64_t> bits;
+
+    const uint64_t* row(int r) const { return &bits[r * words]; }
+};
+
+//A pixel is opaque when its alpha is at least this. It is the middle of the bilinear filter, so a mask covers what is drawn
+const uint8_t MASK_ALPHA_THRESHOLD = 128;
+
+//The mask of an image as it is
+void buildCollisionMask(const PixelView& image, CollisionMask& mask, uint8_t threshold = MASK_ALPHA_THRESHOLD);
+
+//The mask of an image rotated like blitRotated and SDL_RenderCopyEx do it: clockwise around its center, with bilinear sampling.
+//(x, y) can be negative, because the corners go out of the image
+void buildRotatedCollisionMask(const PixelView& image, double degrees, CollisionMask& mask, uint8_t threshold = MASK_ALPHA_THRESHOLD);
+
+//True when the masks share an opaque pixel, with the images of a and b at (ax, ay) and (bx, by).
+//The boxes of the masks are compared first, and only the rows where they meet are ANDed, a whole word at a time
+bool masksOverlap(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by);
+
+//Every mask the world needs: the egg for each frame of the animation and each angle it can have, and each pipe column (hole at 1 to 4).
+//The egg is drawn at (CHARACTER_X_POS, posY) and a pipe column at (xPosition, 0), so the masks are placed the same way
+struct PixelMasks{
+    int eggFrames;
+    int angleCount;
+    double minDegrees;
+    double step;
+    std::vector<CollisionMask> egg;
+    CollisionMask pipeColumns[4];
+
+    const CollisionMask& getEgg(int frame, double degrees) const;
+    size_t getMemoryBytes() const;
+};
+
+//eggSheet is spritedPlayer.png, 2x2 frames of CHARACTER_SIZE, and pipe is one slot of pipe.png.
+//The egg angles go from EGG_FLAP_DEGREES to EGG_MAX_DEGREES every step degrees, and any other angle takes the nearest one
+void buildPixelMasks(PixelMasks& masks, const PixelView& eggSheet, const PixelView& pipe, double step = EGG_TURN_DEGREES);
+
+//True when the egg touches any of the pipes. The pipes are given as in buildPipeSegments
+bool pixelsHitCharacter(const PixelMasks& masks, const PipeRing& pipes, int frame, double degrees, int posY);
+bool pixelsHitCharacter(const PixelMasks& masks, const int* xPosition, const int* freeSpotPosition, int totalPipe,
+                        int frame, double degrees, int posY);
+
+#endif // COLLISIONMASK_H
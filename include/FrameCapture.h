@@ -0,0 +1,102 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscQueue.h"
+
+//The most frames that can wait for the writer
+const int CAPTURE_MAX_BUFFERS = 16;
+
+//Records the presented frames as video without slowing the game. The renderer reads each frame back into a free buffer
+//of a pool that is made once, and hands it to a thread that converts it to YUV 4:2:0 and writes it. The buffers go
+//back and forth in two SpscQueues, so neither side takes a lock or allocates. When the writer is behind and no buffer
+//is free the frame is dropped and counted, the renderer never waits for it.
+//Every frame comes with its place in the video, so the video keeps the speed of the game whatever the rate of the presents:
+//the places that got no frame repeat the one before, and a second frame for the same place is left out.
+//The output is a Y4M file, or the raw YUV 4:2:0 frames without headers for a command that reads them from a pipe
+class FrameCapture
+{
+    public:
+        FrameCapture();
+
+        //Stops like stop()
+        ~FrameCapture();
+
+        //Starts writing frames of width x height to path as Y4M, at fps frames per second.
+        //If path starts with '|' the rest is a command that gets the raw frames on its standard input
+        bool start(const std::string& path, int width, int height, int fps, int buffers = 8);
+
+        //Writes the frames that are still waiting, and closes the file
+        void stop();
+
+        bool isCapturing() const { return mWriting; }
+        int getWidth() const { return mWidth; }
+        int getHeight() const { return mHeight; }
+
+        //A free buffer for the next frame, of getWidth() x getHeight() ARGB8888 pixels, or NULL if every buffer
+        //is still waiting for the writer: then the frame is counted as dropped. Only the thread that captures calls it
+        uint32_t* beginFrame();
+
+        //Hands the buffer of the last beginFrame to the writer, for the place position of the video (in frames at the fps of start)
+        void endFrame(long long position);
+
+        //The place in the video of a frame presented at time, by the time since start
+        long long getPosition(std::chrono::steady_clock::time_point time) const;
+
+        long long getCaptured() const { return mCaptured; }
+        long long getDropped() const { return mDropped; }
+        long long getWritten() const { return mWritten; }
+        long long getRepeated() const { return mRepeated; }
+
+        //Only after stop
+        void printStats(FILE* file) const;
+
+    private:
+        void run();
+        void writeFrame(const uint32_t* pixels, long long position);
+
+        //Writes mYuv once more. Returns false after a write error
+        bool writeYuv();
+
+        //BT.601 with the limited range, which is what a Y4M file means when it doesn't say
+        void convert(const uint32_t* pixels);
+
+        int mWidth;
+        int mHeight;
+        int mFps;
+        std::chrono::steady_clock::time_point mStart;
+        bool mPipe;
+        FILE* mFile;
+
+        //The buffers, and their indexes: the free ones go from the writer to the renderer and the full ones the other way
+        std::vector< std::vector<uint32_t> > mBuffers;
+        std::vector<long long> mPositions;
+        SpscQueue<int, CAPTURE_MAX_BUFFERS> mFree;
+        SpscQueue<int, CAPTURE_MAX_BUFFERS> mFull;
+        int mCurrent;
+        std::thread mThread;
+        std::atomic<bool> mRunning;
+        bool mWriting;
+
+        //The planes of the last converted frame, and the place that comes after it. Only the writer uses them
+        std::vector<uint8_t> mYuv;
+        long long mNextPosition;
+
+        long long mCaptured;
+        long long mDropped;
+
+        //Belong to the writer until stop
+        long long mWritten;
+        long long mRepeated;
+        long long mLeftOut;
+        bool mFailed;
+        double mConvertSeconds;
+        double mWriteSeconds;
+};
+
+#endif // FRAMECAPTURE_H
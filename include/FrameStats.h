@@ -0,0 +1,73 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+#include <stdio.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "Profiler.h"
+
+//Times the phases of every frame in histograms, so we can get the percentiles without keeping every sample.
+//The buckets grow with the value (32 per power of two), which keeps every percentile within about 3%
+class FrameStats
+{
+    public:
+        FrameStats(const char* const* phaseNames, int phaseCount);
+
+        //Adds one sample of the phase, in microseconds
+        void add(int phase, double microseconds);
+
+        //Forgets every sample, for example after warming up
+        void reset();
+
+        int getPhaseCount();
+        const char* getPhaseName(int phase);
+        long long getCount(int phase);
+        double getMean(int phase);
+        double getMax(int phase);
+
+        //The value under which the given fraction of the samples are (0.5 for the median), in microseconds
+        double getPercentile(int phase, double fraction);
+
+        //A table with count, mean, p50, p95, p99 and max of every phase
+        void print(FILE* file);
+
+        //The same as a JSON object with one member per phase, for the tools that track them
+        void writeJson(FILE* file);
+
+        static std::chrono::steady_clock::time_point now(){ return std::chrono::steady_clock::now(); }
+
+    private:
+        static const int SUB_BUCKETS = 32;
+        //Up to 2^27 us (more than two minutes), anything longer goes to the last bucket
+        static const int BUCKET_COUNT = 2 * SUB_BUCKETS + 21 * SUB_BUCKETS;
+
+        static int bucketOf(long long microseconds);
+        static long long bucketLowerBound(int bucket);
+
+        struct Phase{
+            const char* name;
+            std::vector<long long> buckets;
+            long long count;
+            double total;
+            double max;
+        };
+        std::vector<Phase> mPhases;
+};
+
+//Adds the time from its construction to its destruction to one phase. While profiling it is also a zone, named like the phase
+class PhaseTimer
+{
+    public:
+        PhaseTimer(FrameStats& stats, int phase) : mStats(stats), mPhase(phase), mStart(FrameStats::now()), mZone(stats.getPhaseName(phase)) {}
+        ~PhaseTimer(){
+            mStats.add(mPhase, std::chrono::duration<double, std::micro>(FrameStats::now() - mStart).count());
+        }
+
+    private:
+        FrameStats& mStats;
+        int mPhase;
+        std::chrono::steady_clock::time_point mStart;
+        ProfileZone mZone;
+};
+
+#endif // FRAMESTATS_H
@@ -0,0 +1,70 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <vector>
+
+
+//All the printable characters of a font rasterized once into a single texture.
+//Drawing a string only reads the cached glyph rectangles, so there is no TTF work and no new texture per frame
+class GlyphAtlas
+{
+    public:
+        //Initializes variables
+        GlyphAtlas();
+
+        //Deallocates memory
+        ~GlyphAtlas();
+
+        //Rasterizes every printable ASCII character of the font into the atlas
+        bool loadFromFont(TTF_Font* gFont, SDL_Renderer* gRenderer);
+
+        //The same in two steps: rasterize doesn't need the renderer, so it can run on another thread,
+        //and loadFromSurface creates the texture from its result (the surface is not freed)
+        SDL_Surface* rasterize(TTF_Font* gFont);
+        bool loadFromSurface(SDL_Surface* atlasSurface, SDL_Renderer* gRenderer);
+
+        //Deallocates texture
+        void free();
+
+        //Renders the text with its top left corner at x, y. Characters that are not in the atlas are skipped
+        void render(SDL_Renderer* gRenderer, const char* text, int x, int y, SDL_Color color);
+
+        //Gets the size that the text would take on screen
+        int getTextWidth(const char* text);
+        int getHeight();
+
+        SDL_Texture* getTexture() const { return mTexture; }
+
+    private:
+        static const int FIRST_GLYPH = 32;
+        static const int LAST_GLYPH = 126;
+
+        //Maximum width of the atlas; the glyphs go on rows that never pass it
+        static const int ATLAS_WIDTH = 1024;
+
+        struct Glyph{
+            SDL_Rect clip;
+            int advance;
+        };
+
+        //Returns the glyph of a character, or NULL if we don't have it
+        const Glyph* getGlyph(char character);
+
+        Glyph mGlyphs[LAST_GLYPH - FIRST_GLYPH + 1];
+
+        //The texture with every glyph
+        SDL_Texture* mTexture;
+
+        //Height of a line of text
+        int mHeight;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        //Quads of the text being drawn, sent in a single SDL_RenderGeometry.
+        //They keep their memory, so drawing doesn't allocate once they are big enough
+        std::vector<SDL_Vertex> mVertices;
+        std::vector<int> mIndices;
+#endif
+};
+
+#endif // GLYPHATLAS_H
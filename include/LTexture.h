@@ -6,6 +6,9 @@
 #include <string>
 #include <SDL_ttf.h>
 #include <cmath>
+#include <vector>
+#include "Atlas.h"
+#include "AssetPack.h"
 
 
 class LTexture
@@ -20,6 +23,12 @@ class LTexture
         //Loads image at specified path
         bool loadFromFile( std::string path, SDL_Renderer* gRenderer);
 
+        //Creates the texture from a surface we already have in memory. The surface is not freed
+        bool loadFromSurface( SDL_Surface* surface, SDL_Renderer* gRenderer );
+
+        //Creates the texture straight from the pixels of an image of the pack, with its regions. The colors are already keyed
+        bool loadFromPack( const AssetPack& pack, std::string name, SDL_Renderer* gRenderer );
+
         //Creates image from font string
         bool loadFromRenderedText( std::string textureText, SDL_Color textColor, TTF_Font* gFont, SDL_Renderer* gRenderer );
 
@@ -28,15 +37,34 @@ class LTexture
 
         void setColor(Uint8 red, Uint8 green, Uint8 blue);
 
-        //Renders texture
+        //Renders texture. Without rotation or flip it takes the plain SDL_RenderCopy path
         void render(SDL_Renderer* gRenderer, int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
 
+        //Renders count pieces of the texture, each one turned by its angle around its center. With SDL 2.0.18 or newer
+        //they are all quads of one SDL_RenderGeometry, a single draw. Before that it is one copy per piece
+        void renderBatch(SDL_Renderer* gRenderer, const SDL_Rect* sources, const SDL_Rect* destinations, const float* angles, int count);
+
+        //Gives the texture the named regions of an atlas. Call it after loading, free() forgets them
+        void setRegions(const std::vector<AtlasRegion>& regions);
+
+        //Returns the index of a named region, or -1 if there isn't one
+        int getRegion(std::string name);
+
+        //Renders a named region of the texture. clip, if any, is relative to the region
+        void renderRegion(SDL_Renderer* gRenderer, int x, int y, int region, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE);
+
+        int getRegionWidth(int region);
+        int getRegionHeight(int region);
+
         void setBlendMode(SDL_BlendMode blending);
         void setAlpha(Uint8 alpha);
         //Gets image dimensions
         int getWidth();
         int getHeight();
 
+        //Bytes of texture memory that it takes, 0 without a texture
+        size_t getMemoryBytes();
+
 
     private:
         //The actual hardware texture
@@ -45,6 +73,18 @@ class LTexture
         //Image dimensions
         int mWidth;
         int mHeight;
+
+        //Named pieces of the texture when it is an atlas
+        std::vector<AtlasRegion> mRegions;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        //The quads of renderBatch. They keep their memory, so drawing doesn't allocate once they are big enough
+        std::vector<SDL_Vertex> mVertices;
+        std::vector<int> mIndices;
+#endif
 };
 
+//Bytes of texture memory of any texture, 0 for NULL
+size_t getTextureMemoryBytes(SDL_Texture* texture);
+
 #endif // LTEXTURE_H
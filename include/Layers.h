@@ -0,0 +1,115 @@
+#ifndef LAYERS_H
+#define LAYERS_H
+#include <SDL.h>
+#include <functional>
+#include <vector>
+
+//Something that never changes, drawn once into a texture of the size of the screen. Drawing it again is just one copy,
+//of all of it or of a piece. If the renderer can't draw into textures, it draws it from scratch every time
+class StaticLayer
+{
+    public:
+        //Draws the layer with whatever is the render target, in screen coordinates
+        typedef std::function<void(SDL_Renderer*)> DrawFunction;
+
+        StaticLayer();
+        ~StaticLayer();
+
+        //Renders the layer into its texture. opaque layers are copied without blending, which is much cheaper in software
+        bool build(SDL_Renderer* gRenderer, int width, int height, bool opaque, DrawFunction draw);
+
+        //The texture has to be drawn again when the renderer loses its targets (SDL_RENDER_TARGETS_RESET)
+        bool rebuild();
+
+        void free();
+
+        //The whole layer, or only the area of the screen inside rect
+        void render();
+        void render(const SDL_Rect& rect);
+
+        SDL_Texture* getTexture() const { return mTexture; }
+
+    private:
+        //Where the given pixels of the texture go on the screen
+        SDL_Rect stretch(const SDL_Rect& source) const;
+
+        SDL_Renderer* mRenderer;
+        SDL_Texture* mTexture;
+        int mWidth;
+        int mHeight;
+        bool mOpaque;
+        DrawFunction mDraw;
+};
+
+//The areas of the screen that have changed, to composite only them. An area has to be drawn again on the frame it is used
+//and on the next one, so the background comes back where the thing was
+class DirtyRegions
+{
+    public:
+        DirtyRegions(int width, int height);
+
+        //Something is drawn in rect this frame
+        void add(const SDL_Rect& rect);
+
+        //Every rect that is added grows this much on each side. Drawn scaled, the edges of two rects that touch can round
+        //to different pixels, and this keeps the background from leaving a line behind
+        void setPadding(int pixels);
+
+        //The next frame that asks for its regions has to be drawn whole (after something that isn't tracked has been drawn over the screen)
+        void invalidate();
+
+        //The areas that have to be drawn this frame, merged where they overlap.
+        //Returns false if it is cheaper to draw the whole screen (then regions is empty)
+        bool getRegions(std::vector<SDL_Rect>& regions);
+
+        //Forgets the areas of the previous frame and keeps the ones of this one for the next
+        void endFrame();
+
+    private:
+        SDL_Rect mScreen;
+        int mPadding;
+        std::vector<SDL_Rect> mPrevious;
+        std::vector<SDL_Rect> mCurrent;
+        bool mInvalidated;
+};
+
+//The screen drawn at a lower resolution into a texture, and stretched to the window at the end of the frame, so the
+//renderer fills fewer pixels. Between begin() and end() everything is still drawn in screen coordinates, the renderer scale
+//takes them to the texture. The texture keeps what was drawn on the previous frames, like the screen of the software renderer
+class ScaledTarget
+{
+    public:
+        ScaledTarget();
+        ~ScaledTarget();
+
+        //width x height is the screen
+        void create(SDL_Renderer* gRenderer, int width, int height);
+        void free();
+
+        //Changes the resolution: 1 draws straight to the screen, without any texture. Whatever the texture had is lost.
+        //Returns false if the renderer can't draw into a texture of that size, and then it stays at 1
+        bool setScale(double scale);
+        double getScale() const { return mScale; }
+        bool isScaled() const { return mTexture != NULL; }
+        SDL_Texture* getTexture() const { return mTexture; }
+
+        //Sends the drawing to the texture, if it is scaled
+        void begin();
+
+        //Stretches the areas of the screen that have changed, or all of it without regions, to the window
+        void end(const std::vector<SDL_Rect>* regions = NULL);
+
+    private:
+        //Where the given pixels of the texture go on the screen
+        SDL_Rect stretch(const SDL_Rect& source) const;
+
+        SDL_Renderer* mRenderer;
+        SDL_Texture* mTexture;
+        int mWidth;
+        int mHeight;
+        int mTextureWidth;
+        int mTextureHeight;
+        double mScale;
+};
+
+#endif // LAYERS_H
@@ -0,0 +1,38 @@
+#ifndef OBSTACLERING_H
+#define OBSTACLERING_H
+
+//The obstacles of a world, oldest first, in a fixed array used as a ring. New ones come in at the back with push
+//and old ones go out at the front with popFront, so nothing moves in memory. It has no constructor, so a World that
+//holds one can still be copied as plain data
+template <typename T, int CAPACITY>
+struct ObstacleRing{
+    T items[CAPACITY];
+    int first;
+    int count;
+
+    void clear(){
+        first = 0;
+        count = 0;
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    //The i-th oldest obstacle
+    T& operator[](int i){ return items[(first + i) % CAPACITY]; }
+    const T& operator[](int i) const { return items[(first + i) % CAPACITY]; }
+
+    //Room for a new obstacle at the back. If the ring is full the oldest one is dropped to make it
+    T& push(){
+        if (count == CAPACITY) popFront();
+        count++;
+        return (*this)[count - 1];
+    }
+
+    void popFront(){
+        first = (first + 1) % CAPACITY;
+        count--;
+    }
+};
+
+#endif // OBSTACLERING_H
@@ -0,0 +1,56 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+
+//Every zone that runs while profiling is on is kept with its start and end, in a ring of its own thread, so we can look
+//at the single frames that went wrong and not only at the percentiles. writeChromeTrace dumps them for chrome://tracing or Perfetto.
+//Writing to the ring takes no lock: only the thread that owns it writes, and the dump just reads what was published.
+//When a ring is full the oldest zones go. Off, a zone only reads one flag. Built with NO_PROFILER, zones are not even compiled
+extern std::atomic<bool> gProfiling;
+
+inline bool isProfiling(){ return gProfiling.load(std::memory_order_relaxed); }
+void setProfiling(bool enabled);
+
+//How the thread that calls it is shown in the trace. name is copied
+void setProfileThreadName(const char* name);
+
+//A zone that was timed some other way, from start to end
+void addProfileZone(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+//Writes every zone that the rings still have as Chrome trace JSON. Returns false if the file can't be written
+bool writeChromeTrace(const char* path);
+
+//Times its scope. name has to be a string that lives forever, like a literal. detail (a file name, a text...) is copied
+//at the end of the zone, so it only has to live as long as the zone
+class ProfileZone
+{
+    public:
+        ProfileZone(const char* name, const char* detail = NULL) : mName(NULL) {
+            if (isProfiling()) begin(name, detail);
+        }
+        ~ProfileZone(){
+            if (mName != NULL) end();
+        }
+
+    private:
+        void begin(const char* name, const char* detail);
+        void end();
+
+        const char* mName;
+        const char* mDetail;
+        long long mStart;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#ifdef NO_PROFILER
+#define PROFILE_ZONE(name)
+#define PROFILE_ZONE_DETAIL(name, detail)
+#else
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_ZONE_DETAIL(name, detail) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name, detail)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,60 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+#include <string>
+#include <vector>
+#include "World.h"
+
+//A checksum of the world is kept every this many ticks, so a replay that doesn't play the same is caught near where it went wrong
+const int REPLAY_CHECKSUM_INTERVAL = TICK_RATE;
+
+//One game, as the seed of its world and the ticks where the player flapped. The world is deterministic,
+//so stepping a new world with them plays exactly the same game again.
+//
+//The file is little endian: "FLRP", version, seed, tick count, checksum interval, collision (0 for the boxes, 1 for the pixel masks)
+//and flap count as 32 bit numbers, then the flap ticks as the distance to the previous one in LEB128 (one byte most of the time),
+//and then one 32 bit checksum every checksum interval
+class Replay
+{
+    public:
+        Replay();
+
+        //Forgets everything and starts recording a game that began with World::restart(seed),
+        //with the pixel masks or with the boxes
+        void start(unsigned int seed, bool pixelCollision);
+
+        //Records one tick. Call it after stepping the world with the same input
+        void record(const WorldInput& input, const World& world);
+
+        bool save(std::string path) const;
+        bool load(std::string path);
+
+        unsigned int getSeed() const;
+        int getTickCount() const;
+        int getFlapCount() const;
+
+        //The game has to be played again with the same collision, or it won't be the same game
+        bool usesPixelCollision() const;
+
+        //What the player did on a tick. Going forward tick by tick it is O(1)
+        WorldInput getInput(int tick);
+
+        //Checks the world after stepping the given tick. Returns false if a checksum was kept for it and it differs
+        bool check(int tick, const World& world) const;
+
+        //Steps the given ticks, or the whole replay if -1, on the world restarted with the seed of the replay and with the collision masks it has.
+        //Nothing is drawn. Returns the tick where it stopped playing the same, or -1 if every checksum matched
+        int play(World& world, int ticks = -1);
+
+    private:
+        unsigned int mSeed;
+        int mTicks;
+        int mChecksumInterval;
+        bool mPixelCollision;
+        std::vector<int> mFlapTicks;
+        std::vector<unsigned int> mChecksums;
+
+        //Where getInput is looking in mFlapTicks
+        size_t mCursor;
+};
+
+#endif // REPLAY_H
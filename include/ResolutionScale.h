@@ -0,0 +1,61 @@
+#ifndef RESOLUTIONSCALE_H
+#define RESOLUTIONSCALE_H
+
+//The resolutions the game can be drawn at, as a fraction of the screen in each direction. Level 0 is the whole screen
+const int RESOLUTION_LEVEL_COUNT = 5;
+extern const double RESOLUTION_LEVELS[RESOLUTION_LEVEL_COUNT];
+
+//Chooses the resolution from how long the frames take to draw. It goes down as soon as the average is over the target,
+//and only goes up when the bigger resolution, costing as much more as it has more pixels, would still be under it with some margin.
+//After going down it waits longer before trying to go up again, so it doesn't keep jumping between two levels
+class ResolutionController
+{
+    public:
+        ResolutionController();
+
+        //How long drawing a frame should take
+        void setTarget(double targetMicroseconds);
+        double getTarget() const { return mTarget; }
+
+        //Without auto the level only changes with setLevel
+        void setAuto(bool enabled);
+        bool isAuto() const { return mAuto; }
+
+        void setLevel(int level);
+        int getLevel() const { return mLevel; }
+        double getScale() const { return RESOLUTION_LEVELS[mLevel]; }
+
+        //Adds how long a frame took to draw at the current level. Returns true if the level has changed,
+        //and then the next frames have to be drawn at the new scale
+        bool addFrame(double microseconds);
+
+        //How many times it has changed, and the lowest resolution it went down to
+        int getChangeCount() const { return mChanges; }
+        int getLowestLevel() const { return mLowest; }
+
+    private:
+        //Frames that aren't counted after a change, while the new target texture settles
+        static const int SETTLE_FRAMES = 10;
+
+        //Frames averaged before going down, and before going up
+        static const int DOWN_FRAMES = 15;
+        static const int UP_FRAMES = 60;
+
+        void changeLevel(int level);
+
+        double mTarget;
+        bool mAuto;
+        int mLevel;
+        int mSettle;
+        int mSamples;
+        double mAverage;
+
+        //Frames to wait before going up, doubled every time we have to go down right after going up
+        int mUpFrames;
+        bool mWentUp;
+
+        int mChanges;
+        int mLowest;
+};
+
+#endif // RESOLUTIONSCALE_H
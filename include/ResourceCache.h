@@ -0,0 +1,110 @@
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+#include <SDL.h>
+#include <stdio.h>
+#include <functional>
+#include <map>
+#include <string>
+#include "LTexture.h"
+
+struct ResourceEntry;
+
+//A texture of a ResourceCache. Copies share the texture, and the cache counts them: while there is one, the texture stays
+//in the cache. If the cache has evicted the texture to stay in its budget, it is loaded again the next time it is used
+class TextureHandle
+{
+    public:
+        TextureHandle();
+        TextureHandle(const TextureHandle& other);
+        TextureHandle& operator=(const TextureHandle& other);
+        ~TextureHandle();
+
+        //The texture, loaded again if it had been evicted. Only call it on a valid handle
+        LTexture* get() const;
+        LTexture* operator->() const { return get(); }
+
+        bool isValid() const { return mEntry != NULL; }
+
+        //Lets go of the texture, the handle becomes empty
+        void reset();
+
+    private:
+        friend class ResourceCache;
+        explicit TextureHandle(ResourceEntry* entry);
+
+        ResourceEntry* mEntry;
+};
+
+//Every texture of the game, by key (the path and whatever else changes how it is made). Loading a key twice gives the same texture.
+//It counts the bytes of texture memory of each one, and above the budget it evicts the textures that can be loaded again,
+//the least recently used first
+class ResourceCache
+{
+    public:
+        //Makes the texture. It has to leave it ready to draw (regions, blend mode), because a reload starts from an empty one
+        typedef std::function<bool(LTexture&)> LoadFunction;
+
+        ResourceCache();
+        ~ResourceCache();
+
+        //The texture of key, loading it with load if it isn't in the cache. With reload the texture can be evicted and
+        //loaded again with it; without it, it stays until nothing uses it. Returns an empty handle if the load fails
+        TextureHandle load(const std::string& key, LoadFunction load, LoadFunction reload = LoadFunction());
+
+        //The current texture of something that makes and frees its own, or NULL while it has none
+        typedef std::function<SDL_Texture*()> TextureSource;
+
+        //Counts a texture that is not made by the cache (render targets, streaming textures): it is never evicted,
+        //but it is in the report, it takes its part of the budget, and it is a leak if it still exists at shutdown
+        void track(const std::string& key, TextureSource texture);
+
+        //0 is no budget
+        void setBudget(size_t bytes);
+
+        //The textures of the cache and the tracked ones
+        size_t getBytesInUse() const;
+
+        //Every texture with its bytes and handles, and how the cache has done
+        void printReport(FILE* file) const;
+
+        //Frees every texture, before the renderer is destroyed. The ones that still have handles are leaks:
+        //it prints them and returns how many there are
+        int shutdown();
+
+    private:
+        friend class TextureHandle;
+
+        //Loads the texture of the entry again, if it was evicted
+        bool ensureLoaded(ResourceEntry* entry);
+        void touch(ResourceEntry* entry);
+        void release(ResourceEntry* entry);
+        void unload(ResourceEntry* entry);
+
+        //Evicts until the budget is met, never keep
+        void enforceBudget(ResourceEntry* keep);
+
+        size_t getTrackedBytes() const;
+
+        std::map<std::string, ResourceEntry*> mEntries;
+        std::map<std::string, TextureSource> mTracked;
+        size_t mBudget;
+        size_t mBytes;
+        unsigned long long mClock;
+        int mLoads;
+        int mHits;
+        int mEvictions;
+};
+
+//What the cache knows of each texture
+struct ResourceEntry{
+    ResourceCache* cache;
+    std::string key;
+    LTexture texture;
+    ResourceCache::LoadFunction reload;
+    bool loaded;
+    int handles;
+    size_t bytes;
+    unsigned long long lastUse;
+};
+
+#endif // RESOURCECACHE_H
@@ -0,0 +1,67 @@
+#ifndef ROTATIONCACHE_H
+#define ROTATIONCACHE_H
+#include <SDL.h>
+#include <functional>
+#include <vector>
+
+//The frames of a sprite already turned, rounded to a step of degrees, so drawing a turned frame is a plain copy.
+//Each one is drawn into a cell of one texture the first time it is needed (or all of them at once if they fit),
+//and when the cells run out the one that was used the longest ago is drawn again with the new frame
+class RotationCache
+{
+    public:
+        //Draws a frame turned by degrees around its center, with the top left corner of the unturned frame at (x, y).
+        //The pixels have to be copied as they are (SDL_BLENDMODE_NONE), so they don't get blended twice
+        typedef std::function<void(SDL_Renderer*, int frame, double degrees, int x, int y)> DrawFunction;
+
+        RotationCache();
+        ~RotationCache();
+
+        //frameCount frames of frameWidth x frameHeight, turned from minDegrees to maxDegrees every step degrees,
+        //in a texture of at most budget bytes. Returns false (and draws nothing) without render targets or budget
+        bool build(SDL_Renderer* gRenderer, int frameCount, int frameWidth, int frameHeight, double minDegrees, double maxDegrees,
+                   double step, size_t budget, DrawFunction draw);
+
+        void free();
+
+        //Forgets every turned frame, when the renderer has lost its targets (SDL_RENDER_TARGETS_RESET)
+        void invalidate();
+
+        //Draws the frame turned by degrees, like the draw function would. Returns false if it isn't cached,
+        //for example out of the range of degrees, and then the caller has to draw it itself
+        bool render(int frame, double degrees, int x, int y);
+
+        bool isBuilt() const { return mTexture != NULL; }
+        SDL_Texture* getTexture() const { return mTexture; }
+        int getCellCount() const { return (int)mCellKeys.size(); }
+        int getBakeCount() const { return mBakes; }
+
+    private:
+        //Draws one frame and angle into a cell
+        void bake(int key, int cell);
+
+        SDL_Renderer* mRenderer;
+        SDL_Texture* mTexture;
+        DrawFunction mDraw;
+
+        int mFrameCount;
+        int mFrameWidth;
+        int mFrameHeight;
+        double mMinDegrees;
+        double mStep;
+        int mAngleCount;
+
+        //Cells are big enough for a frame turned any way. The frame goes in the middle
+        int mCellWidth;
+        int mCellHeight;
+        int mColumns;
+
+        //Key (frame * mAngleCount + angle) in each cell and cell of each key, -1 when empty
+        std::vector<int> mCellKeys;
+        std::vector<int> mKeyCells;
+        std::vector<unsigned int> mCellLastUse;
+        unsigned int mUses;
+        int mBakes;
+};
+
+#endif // ROTATIONCACHE_H
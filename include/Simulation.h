@@ -0,0 +1,143 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "World.h"
+#include "Replay.h"
+#include "CollisionMask.h"
+#include "Autopilot.h"
+#include "Broadcast.h"
+#include "SpscQueue.h"
+#include "TripleBuffer.h"
+
+//The world steps TICK_RATE times per second whatever the screen does, and every frame is drawn between the last two ticks.
+//After a stall we drop the time over MAX_FRAME_SECONDS instead of stepping a lot of ticks to catch up
+const double TICK_SECONDS = 1.0 / TICK_RATE;
+const double MAX_FRAME_SECONDS = 0.25;
+const std::chrono::steady_clock::duration TICK_DURATION =
+    std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(TICK_SECONDS));
+
+enum SimCommandType{
+    COMMAND_FLAP,
+    COMMAND_RESTART
+};
+
+//Something the player did and when. A flap goes to the first tick that is due at that time or after it,
+//so it lands on the same tick however late the simulation sees it. A restart starts a new game with seed right away
+struct SimCommand{
+    SimCommandType type;
+    unsigned int seed;
+    std::chrono::steady_clock::time_point time;
+};
+
+//What the renderer draws: the last two ticks, to draw in between them, and the time the last one was due
+struct WorldSnapshot{
+    World previous;
+    World current;
+    std::chrono::steady_clock::time_point time;
+
+    //Counts the games, so the renderer sees a new one even if it missed some snapshots. 0 is before the first one
+    int game;
+
+    //The egg is dead, or the replay being watched has no more ticks
+    bool ended;
+
+    //The ticks stepped so far, counting every game
+    long long tick;
+};
+
+//A flap of the player that went into a tick: when the key was pressed, when the tick was stepped, and which tick it was.
+//The renderer takes it back once it presents a snapshot with that tick, to know how long the key took to show up
+struct AppliedInput{
+    std::chrono::steady_clock::time_point time;
+    std::chrono::steady_clock::time_point stepped;
+    long long tick;
+};
+
+//Steps the world at a steady TICK_RATE, on its own thread after start(). The renderer sends it commands and reads
+//its snapshots, and neither of them ever waits for the other: a slow present doesn't delay a tick, and a slow tick
+//doesn't delay a frame. Without start(), advance() does the same from the thread that calls it.
+//Only one thread may send commands and read snapshots
+class Simulation
+{
+    public:
+        Simulation();
+        ~Simulation();
+
+        //Every game is recorded in replay, and saved to recordPath (if it isn't NULL) when it ends.
+        //New games collide with masks (NULL for the boxes)
+        void setRecording(Replay* replay, const char* recordPath);
+        void setCollision(const PixelMasks* masks);
+
+        //The autopilot plays instead of the keys, from the next game on. NULL gives the keys back
+        void setAutopilot(Autopilot* autopilot);
+
+        //Every tick is published to the viewers of broadcast, on the thread that steps. NULL stops it. Call it before start
+        void setBroadcast(GhostServer* broadcast);
+
+        //Plays replay from tick on, with world as it was after stepping tick - 1, instead of what the player does.
+        //The collision has to be set for the replay already. Call it before start
+        void watchReplay(Replay* replay, int tick, const World& world);
+
+        void start();
+
+        //Stops the thread. A recorded game left in the middle is saved too
+        void stop();
+
+        //Returns false if too many commands are waiting
+        bool send(const SimCommand& command);
+
+        //Steps every tick that is due at now, with the commands that came before it, and publishes a snapshot if something changed
+        void advance(std::chrono::steady_clock::time_point now);
+
+        //Takes the newest snapshot. Returns true if it is new since the last call
+        bool update();
+        const WorldSnapshot& getSnapshot() const { return mSnapshots.getFront(); }
+
+        //Takes the oldest flap that went into tick or an earlier one. Returns false if there isn't any
+        bool takeAppliedInput(long long tick, AppliedInput& input);
+
+        //How steady the ticks were. Only after stop, or without the thread
+        void printStats(FILE* file) const;
+
+    private:
+        void run();
+        void restartGame(unsigned int seed, std::chrono::steady_clock::time_point now);
+        void endGame();
+        void publish();
+
+        SpscQueue<SimCommand, 256> mCommands;
+        TripleBuffer<WorldSnapshot> mSnapshots;
+        SpscQueue<AppliedInput, 256> mApplied;
+        std::thread mThread;
+        std::atomic<bool> mRunning;
+
+        //Everything below belongs to the thread that steps
+        World mWorld;
+        World mPrevious;
+        bool mPlaying;
+        bool mEnded;
+        int mGame;
+        std::chrono::steady_clock::time_point mNextTick;
+        std::chrono::steady_clock::time_point mTickTime;
+
+        Replay* mRecording;
+        const char* mRecordPath;
+        const PixelMasks* mMasks;
+        Autopilot* mAutopilot;
+        bool mPiloting;
+        GhostServer* mBroadcast;
+
+        //The replay being watched and its next tick, or NULL
+        Replay* mWatching;
+        int mWatchTick;
+
+        long long mTicks;
+        long long mLateTicks;
+        long long mDroppedTicks;
+        double mWorstLateness;
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,47 @@
+#ifndef SOFTBLIT_H
+#define SOFTBLIT_H
+#include <stdint.h>
+
+//32 bit ARGB pixels (0xAARRGGBB, SDL_PIXELFORMAT_ARGB8888) that the blitter reads or writes. pitch is counted in pixels
+struct PixelView{
+    uint32_t* pixels;
+    int width;
+    int height;
+    int pitch;
+};
+
+//The rectangle (x, y, w, h) of a view, sharing its pixels. It must be inside the view
+inline PixelView subView(const PixelView& view, int x, int y, int w, int h){
+    PixelView sub = { view.pixels + y * view.pitch + x, w, h, view.pitch };
+    return sub;
+}
+
+//The blend is the one of SDL's generic blitter for SDL_BLENDMODE_BLEND, with every product divided by 255 rounding down:
+//  srcA = srcA * alphaMod / 255,  dst = src * srcA / 255 + dst * (255 - srcA) / 255,  dstA = srcA + dstA * (255 - srcA) / 255
+//Every kernel gives exactly the same pixels, the SIMD ones just do 4 or 8 of them at once
+enum BlitKernel{
+    BLIT_SCALAR,
+    BLIT_SSE2,
+    BLIT_AVX2
+};
+
+bool blitKernelSupported(BlitKernel kernel);
+BlitKernel getBlitKernel();
+const char* getBlitKernelName(BlitKernel kernel);
+
+//Every blit puts the top left corner of src at (x, y) of dst, and only touches the pixels inside dst
+
+//Plain copy, for opaque images
+void blitCopy(const PixelView& dst, int x, int y, const PixelView& src);
+
+//Copies every pixel whose color (not alpha) isn't the key
+void blitColorKey(const PixelView& dst, int x, int y, const PixelView& src, uint32_t key, BlitKernel kernel = getBlitKernel());
+
+//Blends src over dst, with alphaMod for all of src (like SDL_SetTextureAlphaMod)
+void blitBlend(const PixelView& dst, int x, int y, const PixelView& src, uint8_t alphaMod = 255, BlitKernel kernel = getBlitKernel());
+
+//Blends src rotated by degrees (clockwise, like SDL_RenderCopyEx) around its center, with bilinear sampling.
+//Outside of src everything is transparent, so the corners go as far as the rotation takes them
+void blitRotated(const PixelView& dst, int x, int y, const PixelView& src, double degrees, BlitKernel kernel = getBlitKernel());
+
+#endif // SOFTBLIT_H
@@ -0,0 +1,57 @@
+#ifndef SOFTCANVAS_H
+#define SOFTCANVAS_H
+#include <SDL.h>
+#include <vector>
+#include "SoftBlit.h"
+
+//An image kept in memory as ARGB8888, so the software blitter can read it
+class SoftImage
+{
+    public:
+        SoftImage();
+
+        //Copies the pixels of a surface of any format. The surface is not freed
+        bool loadFromSurface(SDL_Surface* surface);
+
+        //An image of width x height filled with one color
+        void create(int width, int height, Uint32 argb);
+
+        void free();
+
+        const PixelView& getView() const { return mView; }
+
+        //A piece of the image, sharing its pixels
+        PixelView getRect(const SDL_Rect& rect) const;
+
+    private:
+        std::vector<Uint32> mPixels;
+        PixelView mView;
+};
+
+//The screen drawn by the CPU with the software blitter. It is sent to a streaming texture and copied to the renderer
+//in one go, so the renderer only has to do one copy per frame (or one per area that changed)
+class SoftCanvas
+{
+    public:
+        SoftCanvas();
+        ~SoftCanvas();
+
+        bool create(SDL_Renderer* gRenderer, int width, int height);
+        void free();
+
+        bool isCreated() const { return mTexture != NULL; }
+        SDL_Texture* getTexture() const { return mTexture; }
+
+        //Where to draw. It keeps what was drawn on the previous frames
+        const PixelView& getView() const { return mCanvas.getView(); }
+
+        //Uploads the areas that have changed, or all of it without regions, and copies them to the renderer
+        void render(const std::vector<SDL_Rect>* regions = NULL);
+
+    private:
+        SDL_Renderer* mRenderer;
+        SDL_Texture* mTexture;
+        SoftImage mCanvas;
+};
+
+#endif // SOFTCANVAS_H
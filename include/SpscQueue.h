@@ -0,0 +1,45 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+#include <atomic>
+
+//A queue for exactly one thread that pushes and one thread that pops, without locks. The counters only grow
+//(wrapping around), and each of them is written by one side only, so a push never waits for a pop or the other way around
+template <typename T, unsigned int CAPACITY>
+class SpscQueue
+{
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "the capacity of a SpscQueue has to be a power of two");
+
+    public:
+        SpscQueue() : mHead(0), mTail(0) {}
+
+        //Returns false if the queue is full
+        bool push(const T& item){
+            unsigned int tail = mTail.load(std::memory_order_relaxed);
+            if (tail - mHead.load(std::memory_order_acquire) == CAPACITY) return false;
+            mItems[tail % CAPACITY] = item;
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        //The oldest item, without taking it out. Returns false if the queue is empty
+        bool peek(T& item) const{
+            unsigned int head = mHead.load(std::memory_order_relaxed);
+            if (head == mTail.load(std::memory_order_acquire)) return false;
+            item = mItems[head % CAPACITY];
+            return true;
+        }
+
+        //Takes out the oldest item. Only after a peek that returned true
+        void pop(){
+            mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        T mItems[CAPACITY];
+
+        //On their own cache lines, so the two threads don't fight over them
+        alignas(64) std::atomic<unsigned int> mHead;
+        alignas(64) std::atomic<unsigned int> mTail;
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,61 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//A pool of worker threads. Every worker has its own queue of tasks; when it runs out of work it steals
+//from the back of the other queues, so uneven tasks still keep all the cores busy
+class ThreadPool
+{
+    public:
+        //Starts the workers. With 0 threads we use one per core
+        ThreadPool(int threads = 0);
+
+        //Finishes the queued tasks and joins the workers
+        ~ThreadPool();
+
+        //Queues a task on the next worker
+        void submit(std::function<void()> task);
+
+        //Blocks until every submitted task is done. The calling thread runs tasks too while it waits
+        void wait();
+
+        //Splits [0, count) in chunks of grain items, runs body(begin, end) for each one and waits for all of them
+        void parallelFor(int count, int grain, const std::function<void(int, int)>& body);
+
+        int getThreadCount();
+
+    private:
+        struct Worker{
+            std::deque< std::function<void()> > tasks;
+            std::mutex mutex;
+        };
+
+        //Takes a task from the front of our own queue, or steals one from the back of another queue
+        bool popTask(int index, std::function<void()>& task);
+
+        void finishTask();
+        void workerLoop(int index);
+
+        std::vector<Worker*> mWorkers;
+        std::vector<std::thread> mThreads;
+
+        //Workers sleep here when every queue is empty, and wait() sleeps on mDone
+        std::mutex mSleepMutex;
+        std::condition_variable mSleep;
+        std::condition_variable mDone;
+
+        //Tasks sitting in a queue, and tasks submitted but not finished yet
+        std::atomic<int> mQueued;
+        std::atomic<int> mPending;
+        std::atomic<unsigned int> mNextWorker;
+        bool mQuit;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,42 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+#include <atomic>
+
+//Hands whole values from one writer thread to one reader thread, without locks and without either of them waiting.
+//The writer fills its own slot and the reader reads its own slot; the third one holds the newest value the reader
+//hasn't taken yet, and each side swaps its slot with that one in a single atomic exchange. The reader may skip values,
+//but it always gets the newest one, and never one that is half written
+template <typename T>
+class TripleBuffer
+{
+    public:
+        TripleBuffer() : mMiddle(1), mBack(0), mFront(2) {}
+
+        //The slot the writer fills. It is only seen after publish
+        T& getBack(){ return mSlots[mBack]; }
+
+        void publish(){
+            mBack = mMiddle.exchange(mBack | FRESH, std::memory_order_acq_rel) & INDEX;
+        }
+
+        //Takes the newest published value, if there is one the reader hasn't taken. Returns whether it did
+        bool update(){
+            if (!(mMiddle.load(std::memory_order_relaxed) & FRESH)) return false;
+            mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        //The value the reader took last
+        const T& getFront() const { return mSlots[mFront]; }
+
+    private:
+        static const int INDEX = 3;
+        static const int FRESH = 4;
+
+        T mSlots[3];
+        std::atomic<int> mMiddle;
+        int mBack;
+        int mFront;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,125 @@
+#ifndef WORLD_H
+#define WORLD_H
+#include "ObstacleRing.h"
+
+struct PixelMasks;
+
+//Screen dimension constants, the frames that we need to do the animation, the time between pipes and the hole space of the pipe in pixels.
+const int SCREEN_WIDTH = 1600;
+const int SCREEN_HEIGHT = 900;
+const int MAXIMUN_FRAMES = 4;
+const int MAX_TIME_PIPE = SCREEN_WIDTH / 21;
+const int FREE_SPACE = 180;
+const int CHARACTER_X_POS = SCREEN_WIDTH / 4;
+const int PIPE_MOVEMENT = 1;
+const int CHARACTER_MOVEMENT = 5;
+
+//Sizes that the simulation needs without asking the textures: the egg is a 60x60 square, the floor is 85px tall,
+//each pipe is 80px wide and made of 10 slots of 105px (one of them is the hole) and every solid slot collides as a 75x100 box
+const int CHARACTER_SIZE = 60;
+const int FLOOR_HEIGHT = 85;
+const int PIPE_SLOTS = 10;
+const int PIPE_TILE_HEIGHT = 105;
+const int PIPE_COLLISION_WIDTH = 75;
+const int PIPE_COLLISION_HEIGHT = 100;
+const int PIPE_WIDTH = 80;
+
+//The egg points up this much when it flaps, and then turns down a few degrees every tick, never past the maximum
+const double EGG_FLAP_DEGREES = -45;
+const double EGG_TURN_DEGREES = 3;
+const double EGG_MAX_DEGREES = 83;
+
+//Falling, the egg goes faster every tick by this factor until it passes this speed, in pixels per tick
+const double EGG_FALL_ACCELERATION = 1.1112;
+const double EGG_MAX_FALL_SPEED = 15;
+
+//Every speed above is counted in ticks. The game was made on a 60 Hz screen, with one tick per frame
+const int TICK_RATE = 60;
+
+//Every solid slot of a pipe used to move the pipe one step, so a pipe moves this much per tick
+const int PIPE_SPEED = PIPE_MOVEMENT * (PIPE_SLOTS - 1);
+
+//The most pipes a world can have: a new one comes every MAX_TIME_PIPE ticks and is retired once it has crossed the whole screen.
+//One more for the tick where a pipe has just come and the oldest one hasn't gone yet
+const int MAX_PIPES = (SCREEN_WIDTH + PIPE_WIDTH) / (PIPE_SPEED * MAX_TIME_PIPE) + 2;
+
+//This is how we handle the current position of each pipe
+struct Pipe{
+    int xPosition;
+    int freeSpotPosition;
+    bool pointCounted;
+};
+
+//The pipes of a world from left to right. Only the ones on the screen are kept
+typedef ObstacleRing<Pipe, MAX_PIPES> PipeRing;
+
+//What the player did since the previous tick
+struct WorldInput{
+    bool flap;
+};
+
+//Same linear congruential generator as the classic rand(), but keeping its state outside.
+//Returns a random hole position for a new pipe (1 to 4)
+inline int nextFreeSpot(unsigned int& seed){
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) & 0x7FFF) % 4 + 1;
+}
+
+//Our hand-made collisionDetector, for an egg whose top is at posY. It is a box around the whole egg, corners and all:
+//a world with masks (CollisionMask.h) collides with the pixels instead
+inline bool collisionWithCharacter(int posY, int posXObj, int posYObj, int widthObj, int heightObj){
+    bool collision = false;
+
+    if (posXObj <= CHARACTER_X_POS+CHARACTER_SIZE and posXObj + widthObj >= CHARACTER_X_POS){
+        if (posYObj <= posY + CHARACTER_SIZE and posYObj + heightObj >= posY ) collision = true;
+    }
+
+    return collision;
+}
+
+//The whole state of one game. There is no SDL in here, so a World can be copied around and stepped headless;
+//the SDL build only reads it to draw
+struct World{
+    //This is going to handle the movement
+    int frame;
+
+    //This is going to rotate our character, enhancing the animation
+    double degrees;
+
+    //This tell us when we need to do the flying(> 0) or falling (< 0) animation and the movement
+    double flying;
+
+    //Handler of the character's Y position
+    int posY;
+
+    //This is how we handle the spawns of out pipes
+    int timingPipe;
+
+    //Here we are going to save the points
+    int points;
+
+    //True once the egg has hit a pipe or the floor. A dead world doesn't step anymore
+    bool dead;
+
+    //State of our own random generator, so every world has its own pipe sequence
+    unsigned int seed;
+
+    PipeRing pipes;
+
+    //The pixel masks that the egg collides with, or NULL for the boxes. It starts as NULL and restart keeps it,
+    //so every copy of the world collides the same way as the world it came from
+    const PixelMasks* masks;
+
+    World();
+
+    //Puts the world in the starting position, using newSeed for the pipe holes
+    void restart(unsigned int newSeed);
+
+    //Advances the game exactly one tick
+    void step(const WorldInput& input);
+
+    //A hash of the whole state. Two worlds that played the same ticks from the same seed have the same one
+    unsigned int checksum() const;
+};
+
+#endif // WORLD_H
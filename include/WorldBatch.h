@@ -0,0 +1,71 @@
+#ifndef WORLDBATCH_H
+#define WORLDBATCH_H
+#include <vector>
+#include "World.h"
+#include "ThreadPool.h"
+#include "Collision.h"
+
+
+//Many independent worlds stepped together. Every field of World is kept in its own array (one value per world),
+//and the pipes of world w are a ring in the MAX_PIPES entries starting at w * MAX_PIPES: pipeCount[w] of them from
+//slot pipeFirst[w] on, wrapping around. Every world of a batch collides the same way, with its masks or with the boxes
+class WorldBatch
+{
+    public:
+        //masks are the pixel masks of CollisionMask.h, or NULL for the boxes
+        WorldBatch(int worldCount, const PixelMasks* masks = NULL);
+
+        //Puts one world, or all of them, in the starting position. restartAll gives world w the seed firstSeed + w
+        void restart(int index, unsigned int seed);
+        void restartAll(unsigned int firstSeed);
+
+        //Advances the worlds in [begin, end) exactly one tick. inputs has one entry per world, or is NULL for no flaps
+        void stepRange(int begin, int end, const WorldInput* inputs);
+
+        //The slot of the i-th pipe of world w, from the left
+        int pipeSlot(int w, int i) const { return w * MAX_PIPES + (pipeFirst[w] + i) % MAX_PIPES; }
+
+        //Advances every world one tick, spreading the batch over the pool
+        void step(const WorldInput* inputs, ThreadPool& pool);
+
+        //Copies one world out of the batch, with the masks of the batch, or writes one into it (its masks are not kept)
+        World getWorld(int index) const;
+        void setWorld(int index, const World& world);
+
+        int size() const;
+        const PixelMasks* getMasks() const { return mMasks; }
+
+        //World-ticks per second over every step() since the batch was created
+        double getTicksPerSecond() const;
+        long long getTotalTicks() const;
+
+        std::vector<int> frame;
+        std::vector<double> degrees;
+        std::vector<double> flying;
+        std::vector<int> posY;
+        std::vector<int> timingPipe;
+        std::vector<int> points;
+        std::vector<unsigned char> dead;
+        std::vector<unsigned int> seed;
+
+        std::vector<int> pipeFirst;
+        std::vector<int> pipeCount;
+        std::vector<int> pipeX;
+        std::vector<int> pipeFree;
+        std::vector<unsigned char> pipeCounted;
+
+    private:
+        //How many worlds a single task of the pool steps
+        static const int GRAIN = 256;
+
+        //Scratch space for the collision pass: the pipe segments of every world and whether its egg hit them
+        std::vector<SegmentList> mSegments;
+        std::vector<unsigned char> mHits;
+
+        const PixelMasks* mMasks;
+        int mCount;
+        long long mTotalTicks;
+        double mTotalSeconds;
+};
+
+#endif // WORLDBATCH_H
@@ -0,0 +1,172 @@
+#include "Animation.h"
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include "LTexture.h"
+#include "SoftCanvas.h"
+
+bool AnimationLibrary::load(std::string path){
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == NULL){
+        printf("Unable to read the animations of %s\n", path.c_str());
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    bool success = true;
+    while (fgets(line, sizeof(line), file) != NULL){
+        lineNumber++;
+        char name[64], image[64], mode[16];
+        AnimationClip clip;
+        int fields = sscanf(line, "%63s %63s %d %d %d %d %d %15s", name, image, &clip.frameWidth, &clip.frameHeight,
+                            &clip.columns, &clip.frameCount, &clip.ticksPerFrame, mode);
+        if (fields <= 0 or name[0] == '#') continue;
+        if (fields != 8 or clip.frameWidth <= 0 or clip.frameHeight <= 0 or clip.columns <= 0 or clip.frameCount <= 0 or clip.ticksPerFrame <= 0
+            or (strcmp(mode, "loop") != 0 and strcmp(mode, "once") != 0)){
+            printf("%s:%d is not a valid animation\n", path.c_str(), lineNumber);
+            success = false;
+            continue;
+        }
+        clip.name = name;
+        clip.image = image;
+        clip.loop = strcmp(mode, "loop") == 0;
+        addClip(clip);
+    }
+    fclose(file);
+    return success;
+}
+
+void AnimationLibrary::addClip(const AnimationClip& clip){
+    mClips.push_back(clip);
+    mClips.back().firstFrame = -1;
+}
+
+bool AnimationLibrary::resolve(const std::vector<AtlasRegion>& regions){
+    mFrames.clear();
+    std::vector<AnimationClip> clips;
+    clips.swap(mClips);
+    for (size_t c = 0; c < clips.size(); c++){
+        AnimationClip& clip = clips[c];
+        const AtlasRegion* region = findAtlasRegion(regions, clip.image);
+        if (region == NULL){
+            printf("The atlas has no %s for the animation %s\n", clip.image.c_str(), clip.name.c_str());
+            continue;
+        }
+        int rows = (clip.frameCount + clip.columns - 1) / clip.columns;
+        if (clip.columns * clip.frameWidth > region->rect.w or rows * clip.frameHeight > region->rect.h){
+            printf("The frames of the animation %s don't fit in %s\n", clip.name.c_str(), clip.image.c_str());
+            continue;
+        }
+        clip.firstFrame = (int)mFrames.size();
+        for (int f = 0; f < clip.frameCount; f++){
+            SDL_Rect frame = { region->rect.x + (f % clip.columns) * clip.frameWidth, region->rect.y + (f / clip.columns) * clip.frameHeight,
+                               clip.frameWidth, clip.frameHeight };
+            mFrames.push_back(frame);
+        }
+        mClips.push_back(clip);
+    }
+    return !mClips.empty();
+}
+
+int AnimationLibrary::find(std::string name) const{
+    for (size_t i = 0; i < mClips.size(); i++){
+        if (mClips[i].name == name) return (int)i;
+    }
+    return -1;
+}
+
+int AnimationLibrary::getFrame(int clip, double ticks) const{
+    const AnimationClip& animation = mClips[clip];
+    int frame = ticks > 0 ? (int)(ticks / animation.ticksPerFrame) : 0;
+    if (animation.loop) return frame % animation.frameCount;
+    return frame < animation.frameCount ? frame : animation.frameCount - 1;
+}
+
+int SpriteBatch::add(int clip, int x, int y, float angle, float ticks){
+    mClips.push_back(clip);
+    mTimes.push_back(ticks);
+    mAngles.push_back(angle);
+    mX.push_back(x);
+    mY.push_back(y);
+    return (int)mClips.size() - 1;
+}
+
+void SpriteBatch::remove(int sprite){
+    int last = (int)mClips.size() - 1;
+    mClips[sprite] = mClips[last];
+    mTimes[sprite] = mTimes[last];
+    mAngles[sprite] = mAngles[last];
+    mX[sprite] = mX[last];
+    mY[sprite] = mY[last];
+    mClips.pop_back();
+    mTimes.pop_back();
+    mAngles.pop_back();
+    mX.pop_back();
+    mY.pop_back();
+}
+
+void SpriteBatch::clear(){
+    mClips.clear();
+    mTimes.clear();
+    mAngles.clear();
+    mX.clear();
+    mY.clear();
+}
+
+void SpriteBatch::setPosition(int sprite, int x, int y){
+    mX[sprite] = x;
+    mY[sprite] = y;
+}
+
+void SpriteBatch::setAngle(int sprite, float angle){
+    mAngles[sprite] = angle;
+}
+
+void SpriteBatch::setTime(int sprite, float ticks){
+    mTimes[sprite] = ticks;
+}
+
+void SpriteBatch::update(float ticks){
+    float* times = mTimes.empty() ? NULL : &mTimes[0];
+    for (size_t i = 0; i < mTimes.size(); i++) times[i] += ticks;
+}
+
+void SpriteBatch::draw(SDL_Renderer* renderer, LTexture& atlas, const AnimationLibrary& library, Uint8 alpha){
+    int count = getCount();
+    if (count == 0) return;
+    if ((int)mSources.size() < count){
+        mSources.resize(count);
+        mDestinations.resize(count);
+    }
+    for (int i = 0; i < count; i++){
+        mSources[i] = library.getFrameRect(mClips[i], library.getFrame(mClips[i], mTimes[i]));
+        SDL_Rect destination = { mX[i], mY[i], mSources[i].w, mSources[i].h };
+        mDestinations[i] = destination;
+    }
+    if (alpha != 0xFF) atlas.setAlpha(alpha);
+    atlas.renderBatch(renderer, &mSources[0], &mDestinations[0], &mAngles[0], count);
+    if (alpha != 0xFF) atlas.setAlpha(0xFF);
+}
+
+void SpriteBatch::blit(const PixelView& canvas, const SoftImage& atlas, const AnimationLibrary& library, BlitKernel kernel, Uint8 alpha){
+    for (int i = 0; i < getCount(); i++){
+        PixelView frame = atlas.getRect(library.getFrameRect(mClips[i], library.getFrame(mClips[i], mTimes[i])));
+        if (mAngles[i] == 0 or alpha != 0xFF) blitBlend(canvas, mX[i], mY[i], frame, alpha, kernel);
+        else blitRotated(canvas, mX[i], mY[i], frame, mAngles[i], kernel);
+    }
+}
+
+SDL_Rect SpriteBatch::getBounds(int sprite, const AnimationLibrary& library) const{
+    const AnimationClip& clip = library.getClip(mClips[sprite]);
+    SDL_Rect bounds = { mX[sprite], mY[sprite], clip.frameWidth, clip.frameHeight };
+    if (mAngles[sprite] != 0){
+        //The circle around the frame, plus a pixel for the filtering
+        int half = (int)ceil(sqrt((double)clip.frameWidth * clip.frameWidth + (double)clip.frameHeight * clip.frameHeight) / 2) + 1;
+        bounds.x = mX[sprite] + clip.frameWidth / 2 - half;
+        bounds.y = mY[sprite] + clip.frameHeight / 2 - half;
+        bounds.w = 2 * half;
+        bounds.h = 2 * half;
+    }
+    return bounds;
+}
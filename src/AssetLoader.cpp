@@ -0,0 +1,100 @@
+#include "AssetLoader.h"
+#include <stdio.h>
+#include "Profiler.h"
+
+static double millisecondsSince(Uint64 start){
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+AssetLoader::AssetLoader(ThreadPool& pool) : mPool(pool){
+    mFinished = 0;
+    mStart = SDL_GetPerformanceCounter();
+    mEnd = 0;
+}
+
+AssetLoader::~AssetLoader(){
+    mPool.wait();
+    for (size_t i = 0; i < mJobs.size(); i++){
+        if (!mJobs[i]->uploaded and mJobs[i]->surface != NULL) SDL_FreeSurface(mJobs[i]->surface);
+        delete mJobs[i];
+    }
+}
+
+void AssetLoader::add(std::string name, DecodeFunction decode, UploadFunction upload){
+    Job* job = new Job();
+    job->name = name;
+    job->decode = decode;
+    job->upload = upload;
+    job->surface = NULL;
+    job->decodeMs = 0;
+    job->uploadMs = 0;
+    job->uploaded = false;
+    job->failed = false;
+    mJobs.push_back(job);
+
+    mPool.submit([this, job]{
+        Uint64 start = SDL_GetPerformanceCounter();
+        SDL_Surface* surface;
+        {
+            PROFILE_ZONE_DETAIL("decode asset", job->name.c_str());
+            surface = job->decode();
+        }
+        double decodeMs = millisecondsSince(start);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        job->surface = surface;
+        job->decodeMs = decodeMs;
+        mDecoded.push_back(job);
+    });
+}
+
+bool AssetLoader::update(){
+    std::vector<Job*> decoded;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        decoded.swap(mDecoded);
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < decoded.size(); i++){
+        Job* job = decoded[i];
+        Uint64 start = SDL_GetPerformanceCounter();
+        PROFILE_ZONE_DETAIL("upload asset", job->name.c_str());
+        job->failed = !job->upload(job->surface);
+        job->uploadMs = millisecondsSince(start);
+        job->uploaded = true;
+        mFinished++;
+        if (job->failed){
+            printf("Failed to load %s!\n", job->name.c_str());
+            success = false;
+        }
+    }
+
+    //An upload can queue more assets, so we are only done when nothing new was added
+    if (isDone() and mEnd == 0) mEnd = SDL_GetPerformanceCounter();
+    return success;
+}
+
+int AssetLoader::getFinished(){
+    return mFinished;
+}
+
+int AssetLoader::getTotal(){
+    return mJobs.size();
+}
+
+bool AssetLoader::isDone(){
+    return mFinished == (int)mJobs.size();
+}
+
+void AssetLoader::printReport(){
+    double decodeTotal = 0, uploadTotal = 0;
+    printf("Startup timing (%d worker threads):\n", mPool.getThreadCount());
+    for (size_t i = 0; i < mJobs.size(); i++){
+        printf("  %-20s decode %8.2f ms  upload %8.2f ms%s\n", mJobs[i]->name.c_str(), mJobs[i]->decodeMs, mJobs[i]->uploadMs, mJobs[i]->failed ? "  FAILED" : "");
+        decodeTotal += mJobs[i]->decodeMs;
+        uploadTotal += mJobs[i]->uploadMs;
+    }
+    double wall = (mEnd != 0 ? mEnd - mStart : SDL_GetPerformanceCounter() - mStart) * 1000.0 / SDL_GetPerformanceFrequency();
+    printf("  decode work %.2f ms, upload work %.2f ms, loading took %.2f ms\n", decodeTotal, uploadTotal, wall);
+}
@@ -0,0 +1,247 @@
+#include "AssetPack.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char PACK_MAGIC[4] = { 'F', 'L', 'P', 'K' };
+
+static Uint32 alignUp(Uint32 value){
+    return (value + ASSET_PACK_ALIGN - 1) / ASSET_PACK_ALIGN * ASSET_PACK_ALIGN;
+}
+
+static void copyName(char* destination, std::string name){
+    memset(destination, 0, 32);
+    strncpy(destination, name.c_str(), 31);
+}
+
+bool writeAssetPack(std::string path, const std::vector<AssetPackItem>& items){
+    PackHeader header;
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = items.size();
+    header.regionCount = 0;
+    for (size_t i = 0; i < items.size(); i++) header.regionCount += items[i].regions.size();
+
+    //Firstly we fill the tables, so we know where the data of every item goes
+    std::vector<PackEntry> entries(items.size());
+    std::vector<PackRegion> regions;
+    Uint32 offset = alignUp(sizeof(PackHeader) + header.entryCount * sizeof(PackEntry) + header.regionCount * sizeof(PackRegion));
+    for (size_t i = 0; i < items.size(); i++){
+        const AssetPackItem& item = items[i];
+        PackEntry& entry = entries[i];
+        if (item.name.size() > 31){
+            printf("The asset name %s is too long for the pack\n", item.name.c_str());
+            return false;
+        }
+        copyName(entry.name, item.name);
+        if (item.surface != NULL){
+            entry.format = item.surface->format->format;
+            entry.width = item.surface->w;
+            entry.height = item.surface->h;
+            entry.pitch = item.surface->pitch;
+            entry.size = item.surface->pitch * item.surface->h;
+        }else{
+            entry.format = SDL_PIXELFORMAT_UNKNOWN;
+            entry.width = entry.height = entry.pitch = 0;
+            entry.size = item.bytes.size();
+        }
+        entry.offset = offset;
+        offset = alignUp(offset + entry.size);
+
+        entry.firstRegion = regions.size();
+        entry.regionCount = item.regions.size();
+        for (size_t r = 0; r < item.regions.size(); r++){
+            PackRegion region;
+            copyName(region.name, item.regions[r].name);
+            region.x = item.regions[r].rect.x;
+            region.y = item.regions[r].rect.y;
+            region.w = item.regions[r].rect.w;
+            region.h = item.regions[r].rect.h;
+            regions.push_back(region);
+        }
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == NULL){
+        printf("Unable to write the asset pack %s\n", path.c_str());
+        return false;
+    }
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!entries.empty()) success = success and fwrite(&entries[0], sizeof(PackEntry), entries.size(), file) == entries.size();
+    if (!regions.empty()) success = success and fwrite(&regions[0], sizeof(PackRegion), regions.size(), file) == regions.size();
+
+    static const char zeros[ASSET_PACK_ALIGN] = { 0 };
+    for (size_t i = 0; i < items.size() and success; i++){
+        size_t gap = entries[i].offset - ftell(file);
+        success = fwrite(zeros, 1, gap, file) == gap;
+
+        if (items[i].surface != NULL){
+            SDL_Surface* surface = items[i].surface;
+            SDL_LockSurface(surface);
+            success = success and fwrite(surface->pixels, surface->pitch, surface->h, file) == (size_t)surface->h;
+            SDL_UnlockSurface(surface);
+        }else if (!items[i].bytes.empty()){
+            success = success and fwrite(&items[i].bytes[0], 1, items[i].bytes.size(), file) == items[i].bytes.size();
+        }
+    }
+    if (fclose(file) != 0) success = false;
+    if (!success) printf("Unable to write the asset pack %s\n", path.c_str());
+    return success;
+}
+
+AssetPack::AssetPack(){
+    mData = NULL;
+    mSize = 0;
+    mHeader = NULL;
+    mEntries = NULL;
+    mRegions = NULL;
+#ifdef _WIN32
+    mFile = NULL;
+    mMapping = NULL;
+#endif
+}
+
+AssetPack::~AssetPack(){
+    close();
+}
+
+bool AssetPack::open(std::string path){
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &size) and size.QuadPart > 0) mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL){
+        CloseHandle(file);
+        return false;
+    }
+    mData = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    mFile = file;
+    mMapping = mapping;
+    mSize = size.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat info;
+    if (fstat(file, &info) == 0 and info.st_size > 0){
+        void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data != MAP_FAILED){
+            mData = (const char*)data;
+            mSize = info.st_size;
+        }
+    }
+    //The mapping keeps the file alive by itself
+    ::close(file);
+#endif
+    if (mData == NULL){
+        printf("Unable to map the asset pack %s\n", path.c_str());
+        close();
+        return false;
+    }
+
+    //Now we check the tables, so nothing later can read out of the mapping
+    bool valid = mSize >= sizeof(PackHeader);
+    if (valid){
+        mHeader = (const PackHeader*)mData;
+        valid = memcmp(mHeader->magic, PACK_MAGIC, 4) == 0 and mHeader->version == ASSET_PACK_VERSION;
+    }
+    if (valid){
+        size_t tables = sizeof(PackHeader) + (size_t)mHeader->entryCount * sizeof(PackEntry) + (size_t)mHeader->regionCount * sizeof(PackRegion);
+        valid = mHeader->entryCount < 0x10000 and mHeader->regionCount < 0x10000 and tables <= mSize;
+    }
+    if (valid){
+        mEntries = (const PackEntry*)(mData + sizeof(PackHeader));
+        mRegions = (const PackRegion*)(mEntries + mHeader->entryCount);
+        for (Uint32 i = 0; i < mHeader->entryCount and valid; i++){
+            const PackEntry& entry = mEntries[i];
+            valid = entry.name[31] == 0 and (size_t)entry.offset + entry.size <= mSize and entry.offset % ASSET_PACK_ALIGN == 0
+                and (size_t)entry.firstRegion + entry.regionCount <= mHeader->regionCount;
+            if (valid and entry.format != SDL_PIXELFORMAT_UNKNOWN)
+                valid = entry.pitch >= entry.width * SDL_BYTESPERPIXEL(entry.format) and (Uint64)entry.pitch * entry.height <= entry.size;
+        }
+        for (Uint32 i = 0; i < mHeader->regionCount and valid; i++) valid = mRegions[i].name[31] == 0;
+    }
+    if (!valid){
+        printf("%s is not a valid asset pack (version %u)\n", path.c_str(), ASSET_PACK_VERSION);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close(){
+#ifdef _WIN32
+    if (mData != NULL) UnmapViewOfFile(mData);
+    if (mMapping != NULL) CloseHandle((HANDLE)mMapping);
+    if (mFile != NULL) CloseHandle((HANDLE)mFile);
+    mFile = NULL;
+    mMapping = NULL;
+#else
+    if (mData != NULL) munmap((void*)mData, mSize);
+#endif
+    mData = NULL;
+    mSize = 0;
+    mHeader = NULL;
+    mEntries = NULL;
+    mRegions = NULL;
+}
+
+bool AssetPack::isOpen(){
+    return mHeader != NULL;
+}
+
+const PackEntry* AssetPack::find(std::string name) const{
+    if (mHeader == NULL) return NULL;
+    for (Uint32 i = 0; i < mHeader->entryCount; i++){
+        if (name == mEntries[i].name) return &mEntries[i];
+    }
+    return NULL;
+}
+
+const void* AssetPack::getData(const PackEntry* entry) const{
+    return mData + entry->offset;
+}
+
+SDL_Surface* AssetPack::getSurface(std::string name) const{
+    const PackEntry* entry = find(name);
+    if (entry == NULL or entry->format == SDL_PIXELFORMAT_UNKNOWN) return NULL;
+
+    int bpp;
+    Uint32 rMask, gMask, bMask, aMask;
+    if (!SDL_PixelFormatEnumToMasks(entry->format, &bpp, &rMask, &gMask, &bMask, &aMask)) return NULL;
+    //The surface never writes its pixels unless we blit onto it, and nobody blits onto the pack
+    return SDL_CreateRGBSurfaceFrom((void*)getData(entry), entry->width, entry->height, bpp, entry->pitch, rMask, gMask, bMask, aMask);
+}
+
+SDL_RWops* AssetPack::getRW(std::string name) const{
+    const PackEntry* entry = find(name);
+    if (entry == NULL) return NULL;
+    return SDL_RWFromConstMem(getData(entry), entry->size);
+}
+
+std::vector<AtlasRegion> AssetPack::getRegions(std::string name) const{
+    std::vector<AtlasRegion> regions;
+    const PackEntry* entry = find(name);
+    if (entry == NULL) return regions;
+    for (Uint32 i = 0; i < entry->regionCount; i++){
+        const PackRegion& packed = mRegions[entry->firstRegion + i];
+        AtlasRegion region;
+        region.name = packed.name;
+        region.rect.x = packed.x;
+        region.rect.y = packed.y;
+        region.rect.w = packed.w;
+        region.rect.h = packed.h;
+        regions.push_back(region);
+    }
+    return regions;
+}
@@ -0,0 +1,220 @@
+#include "Atlas.h"
+#include "CollisionMask.h"
+#include <SDL_image.h>
+#include <stdio.h>
+#include <algorithm>
+
+const char* const GAME_IMAGES[GAME_IMAGE_COUNT] = { "sun.png", "floor.png", "pipe.png", "spritedPlayer.png", "frame.png", "spritedmonigote.png" };
+
+SDL_Surface* loadKeyedSurface(std::string path){
+    SDL_Surface* loadedSurface = IMG_Load(path.c_str());
+    if (loadedSurface == NULL){
+        printf("No se ha cargado la imagen %s. SDL_Image error: %s\n", path.c_str(), IMG_GetError());
+        return NULL;
+    }
+
+    //Same color key as LTexture::loadFromFile. Copying onto a transparent ARGB surface leaves the keyed pixels with alpha 0
+    SDL_SetColorKey(loadedSurface, SDL_TRUE, SDL_MapRGB(loadedSurface->format, 0xFF, 0, 0));
+    SDL_SetSurfaceBlendMode(loadedSurface, SDL_BLENDMODE_NONE);
+
+    SDL_Surface* keyedSurface = SDL_CreateRGBSurface(0, loadedSurface->w, loadedSurface->h, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (keyedSurface == NULL){
+        printf("No se ha podido convertir la imagen %s. SDL Error: %s\n", path.c_str(), SDL_GetError());
+    }else{
+        SDL_FillRect(keyedSurface, NULL, 0);
+        SDL_BlitSurface(loadedSurface, NULL, keyedSurface, NULL);
+    }
+    SDL_FreeSurface(loadedSurface);
+    return keyedSurface;
+}
+
+//The packer keeps the top edge of everything placed so far as a list of flat pieces (a skyline),
+//and puts every new image where it stays lowest
+struct SkylineNode{
+    int x;
+    int y;
+    int width;
+};
+
+//Lowest y where a box w pixels wide fits if its left edge is at the node index, or -1 if it doesn't fit there
+static int skylineFit(const std::vector<SkylineNode>& skyline, int index, int w, int maxWidth){
+    if (skyline[index].x + w > maxWidth) return -1;
+
+    int y = 0;
+    int left = w;
+    for (size_t i = index; left > 0; i++){
+        if (i >= skyline.size()) return -1;
+        y = std::max(y, skyline[i].y);
+        left -= skyline[i].width;
+    }
+    return y;
+}
+
+//Raises the skyline where a w x h box was placed at the node index
+static void skylineAdd(std::vector<SkylineNode>& skyline, int index, int y, int w, int h){
+    SkylineNode node = { skyline[index].x, y + h, w };
+    skyline.insert(skyline.begin() + index, node);
+
+    //The nodes under the new box get shorter or disappear
+    for (size_t i = index + 1; i < skyline.size(); ){
+        int overlap = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+        if (overlap <= 0) break;
+        skyline[i].x += overlap;
+        skyline[i].width -= overlap;
+        if (skyline[i].width > 0) break;
+        skyline.erase(skyline.begin() + i);
+    }
+
+    //And the neighbours at the same height become one
+    for (size_t i = 0; i + 1 < skyline.size(); ){
+        if (skyline[i].y == skyline[i + 1].y){
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }else i++;
+    }
+}
+
+static bool tallerFirst(const std::pair<int, int>& a, const std::pair<int, int>& b){
+    return a.first > b.first;
+}
+
+SDL_Surface* packAtlas(const std::vector<SDL_Surface*>& images, const std::vector<std::string>& names, int maxWidth, std::vector<AtlasRegion>& regions){
+    regions.clear();
+    regions.resize(images.size());
+
+    //The tall images go first, they are the hardest to place
+    std::vector< std::pair<int, int> > order;
+    for (size_t i = 0; i < images.size(); i++) order.push_back(std::make_pair(images[i]->h, (int)i));
+    std::stable_sort(order.begin(), order.end(), tallerFirst);
+
+    std::vector<SkylineNode> skyline;
+    SkylineNode ground = { 0, 0, maxWidth };
+    skyline.push_back(ground);
+    int height = 0;
+
+    for (size_t o = 0; o < order.size(); o++){
+        int image = order[o].second;
+        int w = images[image]->w + 2 * ATLAS_PADDING;
+        int h = images[image]->h + 2 * ATLAS_PADDING;
+
+        int bestIndex = -1, bestY = 0;
+        for (size_t i = 0; i < skyline.size(); i++){
+            int y = skylineFit(skyline, i, w, maxWidth);
+            if (y >= 0 and (bestIndex == -1 or y < bestY)){
+                bestIndex = i;
+                bestY = y;
+            }
+        }
+        if (bestIndex == -1){
+            printf("The image %s is wider than the atlas (%d px)\n", names[image].c_str(), maxWidth);
+            return NULL;
+        }
+
+        AtlasRegion& region = regions[image];
+        region.name = names[image];
+        region.rect.x = skyline[bestIndex].x + ATLAS_PADDING;
+        region.rect.y = bestY + ATLAS_PADDING;
+        region.rect.w = images[image]->w;
+        region.rect.h = images[image]->h;
+        skylineAdd(skyline, bestIndex, bestY, w, h);
+        height = std::max(height, bestY + h);
+    }
+
+    //Now we copy every image to its place
+    SDL_Surface* atlas = SDL_CreateRGBSurface(0, maxWidth, height, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (atlas == NULL){
+        printf("Unable to create the atlas surface! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+    SDL_FillRect(atlas, NULL, 0);
+    for (size_t i = 0; i < images.size(); i++){
+        SDL_SetSurfaceBlendMode(images[i], SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(images[i], NULL, atlas, &regions[i].rect);
+    }
+    return atlas;
+}
+
+SDL_Surface* packGameAtlas(const std::vector<SDL_Surface*>& images, std::vector<AtlasRegion>& regions){
+    std::vector<std::string> names;
+    for (int i = 0; i < GAME_IMAGE_COUNT; i++){
+        std::string name = GAME_IMAGES[i];
+        names.push_back(name.substr(0, name.find('.')));
+    }
+    return packAtlas(images, names, ATLAS_WIDTH, regions);
+}
+
+SDL_Surface* buildGameAtlas(std::vector<AtlasRegion>& regions){
+    std::vector<SDL_Surface*> images;
+    bool success = true;
+
+    for (int i = 0; i < GAME_IMAGE_COUNT; i++){
+        SDL_Surface* image = loadKeyedSurface(GAME_IMAGES[i]);
+        if (image == NULL) success = false;
+        else images.push_back(image);
+    }
+
+    SDL_Surface* atlas = NULL;
+    if (success) atlas = packGameAtlas(images, regions);
+
+    for (size_t i = 0; i < images.size(); i++) SDL_FreeSurface(images[i]);
+    return atlas;
+}
+
+bool buildGameMasks(SDL_Surface* atlas, const std::vector<AtlasRegion>& regions, PixelMasks& masks){
+    const AtlasRegion* egg = findAtlasRegion(regions, "spritedPlayer");
+    const AtlasRegion* pipe = findAtlasRegion(regions, "pipe");
+    if (egg == NULL or pipe == NULL){
+        printf("The atlas has no egg or pipe to make the collision masks\n");
+        return false;
+    }
+
+    //The masks read the alpha of ARGB pixels
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(atlas, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (argb == NULL){
+        printf("Unable to read the atlas for the collision masks. SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_LockSurface(argb);
+    PixelView view = { (uint32_t*)argb->pixels, argb->w, argb->h, argb->pitch / 4 };
+    buildPixelMasks(masks, subView(view, egg->rect.x, egg->rect.y, egg->rect.w, egg->rect.h),
+                    subView(view, pipe->rect.x, pipe->rect.y, pipe->rect.w, pipe->rect.h));
+    SDL_UnlockSurface(argb);
+    SDL_FreeSurface(argb);
+    return true;
+}
+
+bool saveAtlasManifest(std::string path, const std::vector<AtlasRegion>& regions){
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == NULL){
+        printf("Unable to write the atlas manifest %s\n", path.c_str());
+        return false;
+    }
+    for (size_t i = 0; i < regions.size(); i++){
+        const SDL_Rect& rect = regions[i].rect;
+        fprintf(file, "%s %d %d %d %d\n", regions[i].name.c_str(), rect.x, rect.y, rect.w, rect.h);
+    }
+    fclose(file);
+    return true;
+}
+
+bool loadAtlasManifest(std::string path, std::vector<AtlasRegion>& regions){
+    regions.clear();
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == NULL) return false;
+
+    char name[64];
+    AtlasRegion region;
+    while (fscanf(file, "%63s %d %d %d %d", name, &region.rect.x, &region.rect.y, &region.rect.w, &region.rect.h) == 5){
+        region.name = name;
+        regions.push_back(region);
+    }
+    fclose(file);
+    return !regions.empty();
+}
+
+const AtlasRegion* findAtlasRegion(const std::vector<AtlasRegion>& regions, std::string name){
+    for (size_t i = 0; i < regions.size(); i++){
+        if (regions[i].name == name) return &regions[i];
+    }
+    return NULL;
+}
@@ -0,0 +1,233 @@
+#include "Autopilot.h"
+#include <string.h>
+#include <chrono>
+#include "Profiler.h"
+
+bool heuristicFlap(const World& world){
+    if (world.flying >= 0) return false;
+
+    int target = SCREEN_HEIGHT / 2;
+    int nearest = SCREEN_WIDTH * 2;
+    for (int i = 0; i < world.pipes.size(); i++){
+        int x = world.pipes[i].xPosition;
+        if (x + PIPE_COLLISION_WIDTH >= CHARACTER_X_POS and x < nearest){
+            nearest = x;
+            target = world.pipes[i].freeSpotPosition * PIPE_TILE_HEIGHT + FREE_SPACE / 2;
+        }
+    }
+    return world.posY + CHARACTER_SIZE / 2 > target + 30;
+}
+
+Autopilot::Autopilot(int horizon, double budgetMicroseconds, int threads) : mPool(threads){
+    if (horizon > AUTOPILOT_MAX_HORIZON) horizon = AUTOPILOT_MAX_HORIZON;
+    if (horizon < DECISION_TICKS * (PREFIX_DECISIONS + 1)) horizon = DECISION_TICKS * (PREFIX_DECISIONS + 1);
+    mHorizon = horizon;
+    mBudget = budgetMicroseconds;
+    mWinner = PREFIX_COUNT;
+    mDecisions = 0;
+    mNodes = 0;
+    mTimeouts = 0;
+    mDeadEnds = 0;
+    mCarriedPlans = 0;
+    mSearchSeconds = 0;
+    mWorstMicroseconds = 0;
+    for (int i = 0; i < PREFIX_COUNT; i++){
+        mBranches[i].failedKeys.assign(FAILED_SLOTS, 0);
+        mBranches[i].failedStamps.assign(FAILED_SLOTS, 0);
+        mBranches[i].stamp = 0;
+    }
+    reset();
+}
+
+uint64_t Autopilot::nodeKey(const World& world, int tick){
+    //FNV-1a over what the egg has. Two different nodes with the same hash would only make the search skip one
+    uint64_t hash = 14695981039346656037ull;
+    const int values[3] = { tick, world.posY, world.frame };
+    const unsigned char* parts[3] = { (const unsigned char*)values, (const unsigned char*)&world.flying, (const unsigned char*)&world.degrees };
+    const size_t sizes[3] = { sizeof(values), sizeof(world.flying), sizeof(world.degrees) };
+    for (int p = 0; p < 3; p++){
+        for (size_t i = 0; i < sizes[p]; i++){
+            hash ^= parts[p][i];
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool Autopilot::hasFailed(const Branch& branch, uint64_t key){
+    for (int p = 0; p < FAILED_PROBES; p++){
+        int slot = (int)((key + p) & (FAILED_SLOTS - 1));
+        if (branch.failedStamps[slot] != branch.stamp) return false;
+        if (branch.failedKeys[slot] == key) return true;
+    }
+    return false;
+}
+
+void Autopilot::addFailed(Branch& branch, uint64_t key){
+    //When every probe is taken the first one is replaced, forgetting a node only costs searching it again
+    int slot = (int)(key & (FAILED_SLOTS - 1));
+    for (int p = 0; p < FAILED_PROBES; p++){
+        int probe = (int)((key + p) & (FAILED_SLOTS - 1));
+        if (branch.failedStamps[probe] != branch.stamp){
+            slot = probe;
+            break;
+        }
+    }
+    branch.failedKeys[slot] = key;
+    branch.failedStamps[slot] = branch.stamp;
+}
+
+void Autopilot::reset(){
+    mPlanLength = 0;
+    mPhase = 0;
+}
+
+bool Autopilot::preferred(int tick, const World& world) const{
+    if (tick < mPlanLength) return mPlan[tick];
+    return heuristicFlap(world);
+}
+
+bool Autopilot::decide(const World& world){
+    PROFILE_ZONE("autopilot");
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (mBudget > 0) mDeadline = start + std::chrono::microseconds((long long)mBudget);
+    else mDeadline = std::chrono::steady_clock::time_point::max();
+    mWinner = PREFIX_COUNT;
+
+    //The calling thread searches too while it waits for the pool
+    mPool.parallelFor(PREFIX_COUNT, 1, [this, &world](int begin, int end){
+        for (int i = begin; i < end; i++) searchBranch(i, world, mBranches[i]);
+    });
+
+    //The first branch that survived, or else the one that lived longest (the first of them on a tie)
+    int best = mWinner < PREFIX_COUNT ? (int)mWinner : 0;
+    if (mWinner == 0) mCarriedPlans++;
+    if (mWinner == PREFIX_COUNT){
+        bool timedOut = mBranches[0].timedOut;
+        for (int i = 1; i < PREFIX_COUNT; i++){
+            if (mBranches[i].depth > mBranches[best].depth) best = i;
+            timedOut = timedOut or mBranches[i].timedOut;
+        }
+        if (timedOut) mTimeouts++;
+        else mDeadEnds++;
+    }
+    for (int i = 0; i < PREFIX_COUNT; i++) mNodes += mBranches[i].nodes;
+
+    //Next tick the plan starts one tick later, and the grid is one tick closer
+    mPhase = (mPhase + 1) % DECISION_TICKS;
+    const Branch& chosen = mBranches[best];
+    bool flap = chosen.plan[0];
+    mPlanLength = chosen.depth - 1;
+    if (mPlanLength > 0) memcpy(mPlan, chosen.plan + 1, mPlanLength * sizeof(bool));
+    else mPlanLength = 0;
+
+    double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    mSearchSeconds += microseconds / 1e6;
+    if (microseconds > mWorstMicroseconds) mWorstMicroseconds = microseconds;
+    mDecisions++;
+    return flap;
+}
+
+void Autopilot::searchBranch(int index, const World& world, Branch& branch){
+    branch.survived = false;
+    branch.timedOut = false;
+    branch.depth = 0;
+    branch.nodes = 0;
+    branch.stamp++;
+    bool plan[AUTOPILOT_MAX_HORIZON];
+    memset(plan, 0, sizeof(plan));
+
+    //Until the next tick of the grid the egg doesn't flap, that was decided before
+    World copy = world;
+    int first = (DECISION_TICKS - mPhase) % DECISION_TICKS;
+    for (int k = 0; k < first; k++){
+        WorldInput input = { false };
+        copy.step(input);
+        branch.nodes++;
+        if (copy.dead){
+            branch.depth = k;
+            memcpy(branch.plan, plan, sizeof(plan));
+            return;
+        }
+    }
+
+    //The bits of the index say which decisions of the prefix take the other action, so the branches go in the order of a plain search
+    for (int d = 0; d < PREFIX_DECISIONS; d++){
+        int tick = first + d * DECISION_TICKS;
+        bool flap = preferred(tick, copy) != (((index >> (PREFIX_DECISIONS - 1 - d)) & 1) != 0);
+        plan[tick] = flap;
+        for (int k = 0; k < DECISION_TICKS; k++){
+            WorldInput input = { flap and k == 0 };
+            copy.step(input);
+            branch.nodes++;
+            if (copy.dead){
+                branch.depth = tick + k;
+                memcpy(branch.plan, plan, sizeof(plan));
+                return;
+            }
+        }
+    }
+    int prefixEnd = first + PREFIX_DECISIONS * DECISION_TICKS;
+    branch.depth = prefixEnd;
+    memcpy(branch.plan, plan, sizeof(plan));
+    if (searchFrom(copy, prefixEnd, branch, plan, index)){
+        branch.survived = true;
+        branch.depth = mHorizon;
+        memcpy(branch.plan, plan, sizeof(plan));
+
+        //The branches after this one don't matter anymore
+        int winner = mWinner;
+        while (index < winner and !mWinner.compare_exchange_weak(winner, index)) {}
+    }
+}
+
+bool Autopilot::searchFrom(const World& world, int tick, Branch& branch, bool* plan, int index){
+    if (tick >= mHorizon) return true;
+    if (mWinner < index or branch.timedOut) return false;
+
+    //Once per decision: a clock read costs less than the steps of one
+    if (std::chrono::steady_clock::now() > mDeadline){
+        branch.timedOut = true;
+        return false;
+    }
+
+    bool first = preferred(tick, world);
+    for (int option = 0; option < 2; option++){
+        bool flap = option == 0 ? first : !first;
+        plan[tick] = flap;
+        World next = world;
+        int k = 0;
+        for (; k < DECISION_TICKS and tick + k < mHorizon; k++){
+            WorldInput input = { flap and k == 0 };
+            next.step(input);
+            branch.nodes++;
+            if (next.dead) break;
+        }
+        if (next.dead){
+            //The longest life so far, in case nothing gets to the horizon
+            if (tick + k > branch.depth){
+                branch.depth = tick + k;
+                memcpy(branch.plan, plan, (tick + 1) * sizeof(bool));
+            }
+            continue;
+        }
+        uint64_t key = nodeKey(next, tick + k);
+        if (hasFailed(branch, key)) continue;
+        if (searchFrom(next, tick + k, branch, plan, index)) return true;
+        if (mWinner < index or branch.timedOut) break;
+        addFailed(branch, key);
+    }
+    plan[tick] = false;
+    return false;
+}
+
+void Autopilot::printStats(FILE* file){
+    fprintf(file, "autopilot: %lld decisions on %d threads, %lld nodes, %.2f M nodes/s, %.1f us per decision (worst %.1f us), %lld out of budget, %lld dead ends, %lld kept the plan\n",
+            mDecisions, getThreadCount(), mNodes, getNodesPerSecond() / 1e6, mDecisions > 0 ? mSearchSeconds * 1e6 / mDecisions : 0,
+            mWorstMicroseconds, mTimeouts, mDeadEnds, mCarriedPlans);
+}
+
+void Autopilot::writeJson(FILE* file){
+    fprintf(file, "{ \"threads\": %d, \"horizon\": %d, \"budget_us\": %.1f, \"decisions\": %lld, \"nodes\": %lld, \"nodes_per_second\": %.0f, \"worst_us\": %.1f, \"timeouts\": %lld, \"dead_ends\": %lld, \"carried_plans\": %lld }",
+            getThreadCount(), mHorizon, mBudget, mDecisions, mNodes, getNodesPerSecond(), mWorstMicroseconds, mTimeouts, mDeadEnds, mCarriedPlans);
+}
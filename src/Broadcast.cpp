@@ -0,0 +1,555 @@
+#include "Broadcast.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include "Profiler.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+typedef SOCKET NativeSocket;
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+typedef int NativeSocket;
+#endif
+
+//A viewer that hasn't acknowledged anything for this long is gone
+static const double VIEWER_TIMEOUT_SECONDS = 3;
+
+//Without new packets the viewer still says hello this often, so the server learns about it
+static const int ACK_INTERVAL_MS = 250;
+
+enum GhostField{
+    FIELD_POS_Y = 1,
+    FIELD_DEGREES = 2,
+    FIELD_FRAME = 4,
+    FIELD_POINTS = 8,
+    FIELD_DEAD = 16,
+    FIELD_PIPES = 32
+};
+
+GhostState makeGhostState(const World& world, unsigned int tick){
+    GhostState state;
+    state.tick = tick;
+    state.posY = world.posY;
+    state.centidegrees = (int)lround(world.degrees * 100);
+    state.frame = world.frame;
+    state.points = world.points;
+    state.dead = world.dead;
+    state.pipeCount = world.pipes.size();
+    for (int i = 0; i < state.pipeCount; i++){
+        state.pipeX[i] = world.pipes[i].xPosition;
+        state.pipeGap[i] = world.pipes[i].freeSpotPosition;
+    }
+    return state;
+}
+
+GhostState emptyGhostState(){
+    GhostState state;
+    memset(&state, 0, sizeof(state));
+    return state;
+}
+
+bool sameGhostState(const GhostState& a, const GhostState& b){
+    if (a.tick != b.tick or a.posY != b.posY or a.centidegrees != b.centidegrees or a.frame != b.frame or a.points != b.points
+        or a.dead != b.dead or a.pipeCount != b.pipeCount) return false;
+    for (int i = 0; i < a.pipeCount; i++){
+        if (a.pipeX[i] != b.pipeX[i] or a.pipeGap[i] != b.pipeGap[i]) return false;
+    }
+    return true;
+}
+
+static uint32_t zigzag(int value){
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int unzigzag(uint32_t value){
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+static int varintSize(uint32_t value){
+    int size = 1;
+    while (value >= 0x80){
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static void writeVarint(uint8_t* packet, int& size, uint32_t value){
+    while (value >= 0x80){
+        packet[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    packet[size++] = (uint8_t)value;
+}
+
+static bool readVarint(const uint8_t* packet, int size, int& at, uint32_t& value){
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7){
+        if (at >= size) return false;
+        uint8_t byte = packet[at++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool readSigned(const uint8_t* packet, int size, int& at, int& value){
+    uint32_t raw;
+    if (!readVarint(packet, size, at, raw)) return false;
+    value = unzigzag(raw);
+    return true;
+}
+
+//How many pipes of base left the screen and how far the others moved, so they are the first ones of current.
+//All of them leaving always works, and it is what a new game looks like
+static void matchPipes(const GhostState& base, const GhostState& current, int& gone, int& moved){
+    for (gone = 0; gone < base.pipeCount; gone++){
+        int kept = base.pipeCount - gone;
+        if (kept > current.pipeCount) continue;
+        moved = current.pipeX[0] - base.pipeX[gone];
+        bool same = true;
+        for (int i = 0; i < kept and same; i++){
+            same = current.pipeX[i] - base.pipeX[gone + i] == moved and current.pipeGap[i] == base.pipeGap[gone + i];
+        }
+        if (same) return;
+    }
+    moved = 0;
+}
+
+int encodeGhost(const GhostState& base, const GhostState& current, uint8_t* packet, int budget, GhostState& sent){
+    int size = 0;
+    packet[size++] = 'G';
+    for (int i = 0; i < 4; i++) packet[size++] = (uint8_t)(current.tick >> (8 * i));
+    writeVarint(packet, size, base.tick == 0 ? 0 : current.tick - base.tick);
+
+    //The egg always fits in the smallest budget
+    int maskAt = size++;
+    uint8_t mask = current.dead ? FIELD_DEAD : 0;
+    const int eggFields[4] = { FIELD_POS_Y, FIELD_DEGREES, FIELD_FRAME, FIELD_POINTS };
+    const int baseValues[4] = { base.posY, base.centidegrees, base.frame, base.points };
+    const int currentValues[4] = { current.posY, current.centidegrees, current.frame, current.points };
+    for (int f = 0; f < 4; f++){
+        if (currentValues[f] == baseValues[f]) continue;
+        mask |= eggFields[f];
+        writeVarint(packet, size, zigzag(currentValues[f] - baseValues[f]));
+    }
+    sent = current;
+    sent.pipeCount = base.pipeCount;
+    memcpy(sent.pipeX, base.pipeX, sizeof(sent.pipeX));
+    memcpy(sent.pipeGap, base.pipeGap, sizeof(sent.pipeGap));
+
+    int gone, moved;
+    matchPipes(base, current, gone, moved);
+    int kept = base.pipeCount - gone;
+    int added = current.pipeCount - kept;
+    if (gone > 0 or moved != 0 or added > 0){
+        //As many new pipes as fit, the rest go in the next packets
+        int headerSize = varintSize(gone) + varintSize(zigzag(moved)) + 1;
+        int fitting = 0, pipesSize = 0, previousX = kept > 0 ? current.pipeX[kept - 1] : 0;
+        while (fitting < added){
+            int x = current.pipeX[kept + fitting];
+            int pipeSize = varintSize(zigzag(x - previousX)) + 1;
+            if (size + headerSize + pipesSize + pipeSize > budget) break;
+            pipesSize += pipeSize;
+            previousX = x;
+            fitting++;
+        }
+        if (size + headerSize + pipesSize <= budget){
+            mask |= FIELD_PIPES;
+            writeVarint(packet, size, gone);
+            writeVarint(packet, size, zigzag(moved));
+            packet[size++] = (uint8_t)fitting;
+            previousX = kept > 0 ? current.pipeX[kept - 1] : 0;
+            for (int i = kept; i < kept + fitting; i++){
+                writeVarint(packet, size, zigzag(current.pipeX[i] - previousX));
+                packet[size++] = (uint8_t)current.pipeGap[i];
+                previousX = current.pipeX[i];
+            }
+            sent.pipeCount = kept + fitting;
+            memcpy(sent.pipeX, current.pipeX, sent.pipeCount * sizeof(int));
+            memcpy(sent.pipeGap, current.pipeGap, sent.pipeCount * sizeof(int));
+        }
+    }
+    packet[maskAt] = mask;
+    return size;
+}
+
+bool readGhostHeader(const uint8_t* packet, int size, unsigned int& tick, unsigned int& baseTick){
+    if (size < 7 or packet[0] != 'G') return false;
+    tick = 0;
+    for (int i = 0; i < 4; i++) tick |= (unsigned int)packet[1 + i] << (8 * i);
+    int at = 5;
+    uint32_t back;
+    if (!readVarint(packet, size, at, back) or back > tick or tick == 0) return false;
+    baseTick = back == 0 ? 0 : tick - back;
+    return true;
+}
+
+bool decodeGhost(const uint8_t* packet, int size, const GhostState& base, GhostState& state){
+    unsigned int tick, baseTick;
+    if (!readGhostHeader(packet, size, tick, baseTick)) return false;
+    int at = 5;
+    uint32_t back;
+    readVarint(packet, size, at, back);
+    if (at >= size) return false;
+    uint8_t mask = packet[at++];
+
+    state = base;
+    state.tick = tick;
+    state.dead = (mask & FIELD_DEAD) != 0;
+    const int eggFields[4] = { FIELD_POS_Y, FIELD_DEGREES, FIELD_FRAME, FIELD_POINTS };
+    int* values[4] = { &state.posY, &state.centidegrees, &state.frame, &state.points };
+    for (int f = 0; f < 4; f++){
+        if (!(mask & eggFields[f])) continue;
+        int delta;
+        if (!readSigned(packet, size, at, delta)) return false;
+        *values[f] += delta;
+    }
+
+    if (mask & FIELD_PIPES){
+        uint32_t gone;
+        int moved;
+        if (!readVarint(packet, size, at, gone) or !readSigned(packet, size, at, moved) or at >= size) return false;
+        int added = packet[at++];
+        if ((int)gone > base.pipeCount) return false;
+        int kept = base.pipeCount - (int)gone;
+        if (kept + added > MAX_PIPES) return false;
+        for (int i = 0; i < kept; i++){
+            state.pipeX[i] = base.pipeX[gone + i] + moved;
+            state.pipeGap[i] = base.pipeGap[gone + i];
+        }
+        int previousX = kept > 0 ? state.pipeX[kept - 1] : 0;
+        for (int i = kept; i < kept + added; i++){
+            int delta;
+            if (!readSigned(packet, size, at, delta) or at >= size) return false;
+            state.pipeX[i] = previousX + delta;
+            state.pipeGap[i] = packet[at++];
+            previousX = state.pipeX[i];
+        }
+        state.pipeCount = kept + added;
+    }
+    return at == size;
+}
+
+UdpSocket::UdpSocket(){
+    mHandle = INVALID;
+}
+
+UdpSocket::~UdpSocket(){
+    close();
+}
+
+//Winsock has to be started before anything else. The other systems have nothing to start
+static bool startNetwork(){
+#ifdef _WIN32
+    static bool started = false;
+    if (!started){
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0){
+            printf("Unable to start the network\n");
+            return false;
+        }
+        started = true;
+    }
+#endif
+    return true;
+}
+
+bool UdpSocket::open(int port){
+    close();
+    if (!startNetwork()) return false;
+    intptr_t handle = (intptr_t)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (handle == INVALID){
+        printf("Unable to create a socket\n");
+        return false;
+    }
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    bool ready = bind((NativeSocket)handle, (sockaddr*)&address, sizeof(address)) == 0 and ioctlsocket((NativeSocket)handle, FIONBIO, &nonBlocking) == 0;
+#else
+    bool ready = bind((NativeSocket)handle, (sockaddr*)&address, sizeof(address)) == 0 and fcntl((NativeSocket)handle, F_SETFL, O_NONBLOCK) == 0;
+#endif
+    mHandle = handle;
+    if (!ready){
+        printf("Unable to listen on the UDP port %d\n", port);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void UdpSocket::close(){
+    if (mHandle == INVALID) return;
+#ifdef _WIN32
+    closesocket((NativeSocket)mHandle);
+#else
+    ::close((NativeSocket)mHandle);
+#endif
+    mHandle = INVALID;
+}
+
+bool UdpSocket::sendTo(const NetAddress& address, const uint8_t* data, int size){
+    if (mHandle == INVALID) return false;
+    sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = address.host;
+    to.sin_port = address.port;
+    return sendto((NativeSocket)mHandle, (const char*)data, size, 0, (sockaddr*)&to, sizeof(to)) == size;
+}
+
+int UdpSocket::receive(uint8_t* data, int capacity, NetAddress& from){
+    if (mHandle == INVALID) return -1;
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    int size = (int)recvfrom((NativeSocket)mHandle, (char*)data, capacity, 0, (sockaddr*)&address, &length);
+    if (size < 0) return -1;
+    from.host = address.sin_addr.s_addr;
+    from.port = address.sin_port;
+    return size;
+}
+
+bool UdpSocket::resolve(const std::string& text, int defaultPort, NetAddress& address){
+    std::string host = text;
+    int port = defaultPort;
+    size_t colon = text.rfind(':');
+    if (colon != std::string::npos){
+        host = text.substr(0, colon);
+        port = atoi(text.c_str() + colon + 1);
+    }
+    if (host.empty()) host = "127.0.0.1";
+
+    if (!startNetwork()) return false;
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = NULL;
+    if (getaddrinfo(host.c_str(), NULL, &hints, &found) != 0 or found == NULL){
+        printf("Unable to find the address of %s\n", host.c_str());
+        return false;
+    }
+    address.host = ((sockaddr_in*)found->ai_addr)->sin_addr.s_addr;
+    address.port = htons((uint16_t)port);
+    freeaddrinfo(found);
+    return true;
+}
+
+std::string UdpSocket::toString(const NetAddress& address){
+    uint32_t host = ntohl(address.host);
+    char text[32];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u:%u", host >> 24, (host >> 16) & 0xFF, (host >> 8) & 0xFF, host & 0xFF, ntohs(address.port));
+    return text;
+}
+
+GhostServer::GhostServer(){
+    mBudget = 64;
+    mTicks = 0;
+    mPackets = 0;
+    mBytes = 0;
+    mMaxBytes = 0;
+    mWholeSnapshots = 0;
+    mTrimmed = 0;
+    mEncodeSeconds = 0;
+    mMostViewers = 0;
+}
+
+bool GhostServer::start(int port, int budget){
+    if (!mSocket.open(port)) return false;
+    mBudget = std::min(std::max(budget, GHOST_MIN_BUDGET), GHOST_MAX_PACKET);
+    mViewers.clear();
+    printf("Broadcasting the ghost on the UDP port %d, %d bytes per tick at most\n", port, mBudget);
+    return true;
+}
+
+void GhostServer::stop(){
+    mSocket.close();
+    mViewers.clear();
+}
+
+GhostServer::Viewer* GhostServer::findViewer(const NetAddress& address){
+    for (size_t i = 0; i < mViewers.size(); i++){
+        if (mViewers[i].address.host == address.host and mViewers[i].address.port == address.port) return &mViewers[i];
+    }
+    return NULL;
+}
+
+void GhostServer::readAcks(){
+    uint8_t packet[16];
+    NetAddress from;
+    int size;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    while ((size = mSocket.receive(packet, sizeof(packet), from)) >= 0){
+        if (size != 5 or packet[0] != 'A') continue;
+        unsigned int tick = 0;
+        for (int i = 0; i < 4; i++) tick |= (unsigned int)packet[1 + i] << (8 * i);
+
+        Viewer* viewer = findViewer(from);
+        if (viewer == NULL){
+            if ((int)mViewers.size() >= MAX_VIEWERS) continue;
+            Viewer added;
+            added.address = from;
+            added.acked = 0;
+            added.sent.assign(GHOST_HISTORY, emptyGhostState());
+            mViewers.push_back(added);
+            viewer = &mViewers.back();
+            printf("A viewer is watching the ghost from %s\n", UdpSocket::toString(from).c_str());
+        }
+        viewer->lastHeard = now;
+        //Only a tick that we still remember can be a base
+        if (tick > viewer->acked and viewer->sent[tick % GHOST_HISTORY].tick == tick) viewer->acked = tick;
+    }
+    for (size_t i = 0; i < mViewers.size(); ){
+        if (std::chrono::duration<double>(now - mViewers[i].lastHeard).count() > VIEWER_TIMEOUT_SECONDS){
+            printf("The viewer at %s has gone\n", UdpSocket::toString(mViewers[i].address).c_str());
+            mViewers.erase(mViewers.begin() + i);
+        }
+        else i++;
+    }
+}
+
+void GhostServer::publish(const World& world, unsigned int tick){
+    if (!mSocket.isOpen()) return;
+    PROFILE_ZONE("broadcast");
+    readAcks();
+    mTicks++;
+    if (mViewers.empty()) return;
+    if ((int)mViewers.size() > mMostViewers) mMostViewers = (int)mViewers.size();
+
+    //Only making the state and the packets is timed, not sending them
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    GhostState current = makeGhostState(world, tick);
+    uint8_t packet[GHOST_MAX_PACKET];
+    for (size_t i = 0; i < mViewers.size(); i++){
+        Viewer& viewer = mViewers[i];
+        const GhostState* base = NULL;
+        if (viewer.acked != 0 and tick - viewer.acked < (unsigned int)GHOST_HISTORY and viewer.sent[viewer.acked % GHOST_HISTORY].tick == viewer.acked){
+            base = &viewer.sent[viewer.acked % GHOST_HISTORY];
+        }
+        GhostState empty = emptyGhostState();
+        GhostState& sent = viewer.sent[tick % GHOST_HISTORY];
+        int size = encodeGhost(base != NULL ? *base : empty, current, packet, mBudget, sent);
+        std::chrono::steady_clock::time_point encoded = std::chrono::steady_clock::now();
+        mEncodeSeconds += std::chrono::duration<double>(encoded - start).count();
+        if (base == NULL) mWholeSnapshots++;
+        if (!sameGhostState(sent, current)) mTrimmed++;
+
+        mSocket.sendTo(viewer.address, packet, size);
+        mPackets++;
+        mBytes += size;
+        if (size > mMaxBytes) mMaxBytes = size;
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+void GhostServer::printStats(FILE* file) const{
+    long long packets = mPackets > 0 ? mPackets : 1;
+    fprintf(file, "broadcast: %lld ticks, %lld packets to up to %d viewers, %.1f bytes per tick per viewer (most %d, budget %d), "
+            "%lld whole snapshots, %lld trimmed to the budget, %.0f ns to serialize each one\n",
+            mTicks, mPackets, mMostViewers, (double)mBytes / packets, mMaxBytes, mBudget, mWholeSnapshots, mTrimmed, mEncodeSeconds * 1e9 / packets);
+}
+
+GhostClient::GhostClient(){
+    mLatest = emptyGhostState();
+    mLoss = 0;
+    mLossSeed = 1;
+    mPackets = 0;
+    mBytes = 0;
+    mLost = 0;
+    mNoBase = 0;
+    mBroken = 0;
+    mDecoded = 0;
+    mDecodeSeconds = 0;
+}
+
+bool GhostClient::connect(const std::string& address){
+    if (!UdpSocket::resolve(address, BROADCAST_PORT, mServer) or !mSocket.open(0)) return false;
+    mName = UdpSocket::toString(mServer);
+    mHistory.assign(GHOST_HISTORY, emptyGhostState());
+    mLatest = emptyGhostState();
+    sendAck();
+    printf("Watching the ghost of %s\n", mName.c_str());
+    return true;
+}
+
+void GhostClient::close(){
+    mSocket.close();
+}
+
+void GhostClient::sendAck(){
+    uint8_t packet[5] = { 'A' };
+    for (int i = 0; i < 4; i++) packet[1 + i] = (uint8_t)(mLatest.tick >> (8 * i));
+    mSocket.sendTo(mServer, packet, sizeof(packet));
+    mLastAck = std::chrono::steady_clock::now();
+}
+
+bool GhostClient::poll(){
+    if (!mSocket.isOpen()) return false;
+    bool newer = false;
+    uint8_t packet[GHOST_MAX_PACKET];
+    NetAddress from;
+    int size;
+    while ((size = mSocket.receive(packet, sizeof(packet), from)) >= 0){
+        if (from.host != mServer.host or from.port != mServer.port) continue;
+        mPackets++;
+        mBytes += size;
+        if (mLoss > 0){
+            mLossSeed = mLossSeed * 1103515245u + 12345u;
+            if ((int)((mLossSeed >> 16) % 100) < mLoss) continue;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        unsigned int tick, baseTick;
+        if (!readGhostHeader(packet, size, tick, baseTick)){
+            mBroken++;
+            continue;
+        }
+        //A server that started again counts from the beginning
+        if (tick + 4 * GHOST_HISTORY < mLatest.tick){
+            mHistory.assign(GHOST_HISTORY, emptyGhostState());
+            mLatest = emptyGhostState();
+        }
+        GhostState empty = emptyGhostState();
+        const GhostState& base = baseTick == 0 ? empty : mHistory[baseTick % GHOST_HISTORY];
+        if (base.tick != baseTick){
+            mNoBase++;
+            continue;
+        }
+        GhostState state;
+        if (!decodeGhost(packet, size, base, state)){
+            mBroken++;
+            continue;
+        }
+        mDecodeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        mDecoded++;
+        mHistory[tick % GHOST_HISTORY] = state;
+        if (tick > mLatest.tick){
+            if (mLatest.tick != 0) mLost += tick - mLatest.tick - 1;
+            mLatest = state;
+            newer = true;
+        }
+    }
+    if (newer or std::chrono::steady_clock::now() - mLastAck > std::chrono::milliseconds(ACK_INTERVAL_MS)) sendAck();
+    return newer;
+}
+
+void GhostClient::printStats(FILE* file) const{
+    long long packets = mPackets > 0 ? mPackets : 1;
+    long long decoded = mDecoded > 0 ? mDecoded : 1;
+    fprintf(file, "ghost of %s: %lld packets, %.1f bytes per tick, %lld ticks lost, %lld without their base, %lld broken, %.0f ns to read each one\n",
+            mName.c_str(), mPackets, (double)mBytes / packets, mLost, mNoBase, mBroken, mDecodeSeconds * 1e9 / decoded);
+}
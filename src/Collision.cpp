@@ -0,0 +1,166 @@
+#include "Collision.h"
+#include <climits>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define COLLISION_X86 1
+#include <immintrin.h>
+#endif
+
+//Writes the two spans of one pipe in slots 2 * index and 2 * index + 1
+static inline void setPipeSegments(SegmentList& segments, int index, int xPosition, int freeSpotPosition){
+    int above = SEGMENTS_PER_PIPE * index;
+    int below = above + 1;
+
+    segments.x0[above] = segments.x0[below] = xPosition;
+    segments.x1[above] = segments.x1[below] = xPosition + PIPE_COLLISION_WIDTH;
+
+    //Above the hole
+    segments.y0[above] = 0;
+    segments.y1[above] = pipeTopSpanEnd(freeSpotPosition);
+
+    //Below the hole
+    segments.y0[below] = pipeBottomSpanStart(freeSpotPosition);
+    segments.y1[below] = PIPE_BOTTOM_SPAN_END;
+}
+
+//The empty slots start after any egg, so they never collide and the kernels don't need a tail loop
+static inline void clearUnusedSegments(SegmentList& segments, int totalPipe){
+    segments.count = SEGMENTS_PER_PIPE * totalPipe;
+    for (int i = segments.count; i < MAX_SEGMENTS; i++){
+        segments.x0[i] = INT_MAX;
+        segments.x1[i] = INT_MIN;
+        segments.y0[i] = INT_MAX;
+        segments.y1[i] = INT_MIN;
+    }
+}
+
+void buildPipeSegments(const Pipe* pipes, int totalPipe, SegmentList& segments){
+    for (int i = 0; i < totalPipe; i++) setPipeSegments(segments, i, pipes[i].xPosition, pipes[i].freeSpotPosition);
+    clearUnusedSegments(segments, totalPipe);
+}
+
+void buildPipeSegments(const PipeRing& pipes, SegmentList& segments){
+    for (int i = 0; i < pipes.size(); i++) setPipeSegments(segments, i, pipes[i].xPosition, pipes[i].freeSpotPosition);
+    clearUnusedSegments(segments, pipes.size());
+}
+
+void buildPipeSegments(const int* xPosition, const int* freeSpotPosition, int totalPipe, SegmentList& segments){
+    for (int i = 0; i < totalPipe; i++) setPipeSegments(segments, i, xPosition[i], freeSpotPosition[i]);
+    clearUnusedSegments(segments, totalPipe);
+}
+
+bool segmentsHitCharacterScalar(const SegmentList& segments, int posY){
+    for (int i = 0; i < segments.count; i++){
+        if (segments.x0[i] <= CHARACTER_X_POS + CHARACTER_SIZE and segments.x1[i] >= CHARACTER_X_POS and
+            segments.y0[i] <= posY + CHARACTER_SIZE and segments.y1[i] >= posY) return true;
+    }
+    return false;
+}
+
+#ifdef COLLISION_X86
+
+//A lane misses when the box starts after the egg ends or ends before the egg starts, on any axis
+__attribute__((target("sse2")))
+bool segmentsHitCharacterSSE2(const SegmentList& segments, int posY){
+    const __m128i left = _mm_set1_epi32(CHARACTER_X_POS);
+    const __m128i right = _mm_set1_epi32(CHARACTER_X_POS + CHARACTER_SIZE);
+    const __m128i top = _mm_set1_epi32(posY);
+    const __m128i bottom = _mm_set1_epi32(posY + CHARACTER_SIZE);
+
+    for (int i = 0; i < segments.count; i += 4){
+        __m128i x0 = _mm_loadu_si128((const __m128i*)&segments.x0[i]);
+        __m128i x1 = _mm_loadu_si128((const __m128i*)&segments.x1[i]);
+        __m128i y0 = _mm_loadu_si128((const __m128i*)&segments.y0[i]);
+        __m128i y1 = _mm_loadu_si128((const __m128i*)&segments.y1[i]);
+
+        __m128i miss = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(x0, right), _mm_cmpgt_epi32(left, x1)),
+                                    _mm_or_si128(_mm_cmpgt_epi32(y0, bottom), _mm_cmpgt_epi32(top, y1)));
+        if (_mm_movemask_epi8(miss) != 0xFFFF) return true;
+    }
+    return false;
+}
+
+__attribute__((target("avx2")))
+bool segmentsHitCharacterAVX2(const SegmentList& segments, int posY){
+    const __m256i left = _mm256_set1_epi32(CHARACTER_X_POS);
+    const __m256i right = _mm256_set1_epi32(CHARACTER_X_POS + CHARACTER_SIZE);
+    const __m256i top = _mm256_set1_epi32(posY);
+    const __m256i bottom = _mm256_set1_epi32(posY + CHARACTER_SIZE);
+
+    for (int i = 0; i < segments.count; i += 8){
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)&segments.x0[i]);
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)&segments.x1[i]);
+        __m256i y0 = _mm256_loadu_si256((const __m256i*)&segments.y0[i]);
+        __m256i y1 = _mm256_loadu_si256((const __m256i*)&segments.y1[i]);
+
+        __m256i miss = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(x0, right), _mm256_cmpgt_epi32(left, x1)),
+                                       _mm256_or_si256(_mm256_cmpgt_epi32(y0, bottom), _mm256_cmpgt_epi32(top, y1)));
+        if (_mm256_movemask_epi8(miss) != -1) return true;
+    }
+    return false;
+}
+
+bool collisionKernelSupported(CollisionKernel kernel){
+    __builtin_cpu_init();
+    if (kernel == COLLISION_AVX2) return __builtin_cpu_supports("avx2");
+    if (kernel == COLLISION_SSE2) return __builtin_cpu_supports("sse2");
+    return true;
+}
+
+#else
+
+//Without x86 intrinsics the SIMD kernels are just the scalar one
+bool segmentsHitCharacterSSE2(const SegmentList& segments, int posY){
+    return segmentsHitCharacterScalar(segments, posY);
+}
+
+bool segmentsHitCharacterAVX2(const SegmentList& segments, int posY){
+    return segmentsHitCharacterScalar(segments, posY);
+}
+
+bool collisionKernelSupported(CollisionKernel kernel){
+    return kernel == COLLISION_SCALAR;
+}
+
+#endif
+
+static CollisionKernel chooseCollisionKernel(){
+    if (collisionKernelSupported(COLLISION_AVX2)) return COLLISION_AVX2;
+    if (collisionKernelSupported(COLLISION_SSE2)) return COLLISION_SSE2;
+    return COLLISION_SCALAR;
+}
+
+//We look at the CPU only once, the first time somebody asks
+CollisionKernel getCollisionKernel(){
+    static const CollisionKernel kernel = chooseCollisionKernel();
+    return kernel;
+}
+
+const char* getCollisionKernelName(CollisionKernel kernel){
+    switch (kernel){
+        case COLLISION_AVX2: return "avx2";
+        case COLLISION_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+bool segmentsHitCharacter(const SegmentList& segments, int posY){
+    switch (getCollisionKernel()){
+        case COLLISION_AVX2: return segmentsHitCharacterAVX2(segments, posY);
+        case COLLISION_SSE2: return segmentsHitCharacterSSE2(segments, posY);
+        default: return segmentsHitCharacterScalar(segments, posY);
+    }
+}
+
+void segmentsHitCharacters(const SegmentList* segments, const int* posY, int count, unsigned char* hits){
+    switch (getCollisionKernel()){
+        case COLLISION_AVX2:
+            for (int w = 0; w < count; w++) hits[w] = segmentsHitCharacterAVX2(segments[w], posY[w]);
+            break;
+        case COLLISION_SSE2:
+            for (int w = 0; w < count; w++) hits[w] = segmentsHitCharacterSSE2(segments[w], posY[w]);
+            break;
+        default:
+            for (int w = 0; w < count; w++) hits[w] = segmentsHitCharacterScalar(segments[w], posY[w]);
+    }
+}
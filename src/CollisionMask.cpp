@@ -0,0 +1,168 @@
+#include "CollisionMask.h"
+#include <math.h>
+
+//Not M_PI, which MinGW only has without -std=c++11
+static const double PI = 3.14159265358979323846;
+
+//Packs the pixels of a width x height image where opaque(column, row) says so, cut down to the box around them.
+//The box starts at (originX, originY) in the image
+template <typename Opaque>
+static void packMask(int originX, int originY, int width, int height, Opaque opaque, CollisionMask& mask){
+    int left = width, right = 0, top = height, bottom = 0;
+    std::vector<unsigned char> cells(width * height);
+    for (int row = 0; row < height; row++){
+        for (int column = 0; column < width; column++){
+            cells[row * width + column] = opaque(column, row);
+            if (!cells[row * width + column]) continue;
+            if (column < left) left = column;
+            if (column >= right) right = column + 1;
+            if (row < top) top = row;
+            if (row >= bottom) bottom = row + 1;
+        }
+    }
+
+    //Nothing opaque: an empty mask never overlaps anything
+    if (left >= right){
+        left = right = top = bottom = 0;
+    }
+    mask.x = originX + left;
+    mask.y = originY + top;
+    mask.width = right - left;
+    mask.height = bottom - top;
+    mask.words = (mask.width + 63) / 64;
+    mask.bits.assign(mask.words * mask.height, 0);
+    for (int row = 0; row < mask.height; row++){
+        for (int column = 0; column < mask.width; column++){
+            if (cells[(top + row) * width + left + column]) mask.bits[row * mask.words + column / 64] |= (uint64_t)1 << (column % 64);
+        }
+    }
+}
+
+static inline int alphaAt(const PixelView& image, int x, int y){
+    if (x < 0 or y < 0 or x >= image.width or y >= image.height) return 0;
+    return image.pixels[y * image.pitch + x] >> 24;
+}
+
+void buildCollisionMask(const PixelView& image, CollisionMask& mask, uint8_t threshold){
+    packMask(0, 0, image.width, image.height, [&](int x, int y){ return alphaAt(image, x, y) >= threshold; }, mask);
+}
+
+void buildRotatedCollisionMask(const PixelView& image, double degrees, CollisionMask& mask, uint8_t threshold){
+    //The same geometry as blitRotated, with the image at (0, 0)
+    double radians = degrees * PI / 180.0;
+    double c = cos(radians), s = sin(radians);
+    double halfWidth = image.width / 2.0, halfHeight = image.height / 2.0;
+    double extentX = fabs(c) * halfWidth + fabs(s) * halfHeight;
+    double extentY = fabs(s) * halfWidth + fabs(c) * halfHeight;
+    int left = (int)floor(halfWidth - extentX) - 1, right = (int)ceil(halfWidth + extentX) + 1;
+    int top = (int)floor(halfHeight - extentY) - 1, bottom = (int)ceil(halfHeight + extentY) + 1;
+
+    packMask(left, top, right - left, bottom - top, [&](int column, int row){
+        double u = left + column + 0.5 - halfWidth, v = top + row + 0.5 - halfHeight;
+        double sourceX = c * u + s * v + halfWidth - 0.5;
+        double sourceY = -s * u + c * v + halfHeight - 0.5;
+        int x0 = (int)floor(sourceX), y0 = (int)floor(sourceY);
+        double fx = sourceX - x0, fy = sourceY - y0;
+        double alpha = (alphaAt(image, x0, y0) * (1 - fx) + alphaAt(image, x0 + 1, y0) * fx) * (1 - fy)
+                     + (alphaAt(image, x0, y0 + 1) * (1 - fx) + alphaAt(image, x0 + 1, y0 + 1) * fx) * fy;
+        return alpha >= threshold;
+    }, mask);
+}
+
+//The 64 bits of a row that start at column start, with zeros outside the row. start can be negative
+static inline uint64_t bitsFrom(const uint64_t* row, int words, int start){
+    int word = start >= 0 ? start / 64 : -((63 - start) / 64);
+    int offset = start - word * 64;
+    uint64_t low = word >= 0 and word < words ? row[word] : 0;
+    if (offset == 0) return low;
+    uint64_t high = word + 1 >= 0 and word + 1 < words ? row[word + 1] : 0;
+    return (low >> offset) | (high << (64 - offset));
+}
+
+bool masksOverlap(const CollisionMask& a, int ax, int ay, const CollisionMask& b, int bx, int by){
+    int aLeft = ax + a.x, aTop = ay + a.y;
+    int bLeft = bx + b.x, bTop = by + b.y;
+
+    //The boxes first, most of the time that is enough
+    int left = aLeft > bLeft ? aLeft : bLeft;
+    int right = aLeft + a.width < bLeft + b.width ? aLeft + a.width : bLeft + b.width;
+    int top = aTop > bTop ? aTop : bTop;
+    int bottom = aTop + a.height < bTop + b.height ? aTop + a.height : bTop + b.height;
+    if (left >= right or top >= bottom) return false;
+
+    //We walk the words of a where the boxes meet, and bring the bits of b under each of them.
+    //The bits of a word of a that are out of b are zero in b, so nothing else has to be masked
+    int shift = aLeft - bLeft;
+    int firstWord = (left - aLeft) / 64, lastWord = (right - 1 - aLeft) / 64;
+    for (int y = top; y < bottom; y++){
+        const uint64_t* rowA = a.row(y - aTop);
+        const uint64_t* rowB = b.row(y - bTop);
+        for (int k = firstWord; k <= lastWord; k++){
+            if (rowA[k] & bitsFrom(rowB, b.words, k * 64 + shift)) return true;
+        }
+    }
+    return false;
+}
+
+const CollisionMask& PixelMasks::getEgg(int frame, double degrees) const{
+    int angle = (int)floor((degrees - minDegrees) / step + 0.5);
+    if (angle < 0) angle = 0;
+    if (angle >= angleCount) angle = angleCount - 1;
+    if (frame < 0 or frame >= eggFrames) frame = 0;
+    return egg[frame * angleCount + angle];
+}
+
+size_t PixelMasks::getMemoryBytes() const{
+    size_t bytes = 0;
+    for (size_t i = 0; i < egg.size(); i++) bytes += egg[i].bits.size() * sizeof(uint64_t);
+    for (int i = 0; i < 4; i++) bytes += pipeColumns[i].bits.size() * sizeof(uint64_t);
+    return bytes;
+}
+
+void buildPixelMasks(PixelMasks& masks, const PixelView& eggSheet, const PixelView& pipe, double step){
+    masks.eggFrames = MAXIMUN_FRAMES;
+    masks.minDegrees = EGG_FLAP_DEGREES;
+    masks.step = step;
+    masks.angleCount = (int)ceil((EGG_MAX_DEGREES - EGG_FLAP_DEGREES) / step) + 1;
+    masks.egg.resize(masks.eggFrames * masks.angleCount);
+    for (int frame = 0; frame < masks.eggFrames; frame++){
+        //The frames are 2x2 in the sheet, like the egg of animations.txt
+        PixelView view = subView(eggSheet, (frame % 2) * CHARACTER_SIZE, (frame / 2) * CHARACTER_SIZE, CHARACTER_SIZE, CHARACTER_SIZE);
+        for (int angle = 0; angle < masks.angleCount; angle++)
+            buildRotatedCollisionMask(view, masks.minDegrees + angle * step, masks.egg[frame * masks.angleCount + angle]);
+    }
+
+    //Same slots as the pipe columns that are drawn: a piece of pipe on each of them, except the hole
+    int columnHeight = (PIPE_SLOTS - 1) * PIPE_TILE_HEIGHT + FREE_SPACE;
+    for (int free = 1; free <= 4; free++){
+        packMask(0, 0, pipe.width, columnHeight, [&](int x, int y){
+            int yPos = 0;
+            for (int j = 0; j < PIPE_SLOTS; j++){
+                if (j == free){
+                    yPos += FREE_SPACE;
+                    continue;
+                }
+                if (y >= yPos and y < yPos + pipe.height and alphaAt(pipe, x, y - yPos) >= MASK_ALPHA_THRESHOLD) return true;
+                yPos += PIPE_TILE_HEIGHT;
+            }
+            return false;
+        }, masks.pipeColumns[free - 1]);
+    }
+}
+
+bool pixelsHitCharacter(const PixelMasks& masks, const PipeRing& pipes, int frame, double degrees, int posY){
+    const CollisionMask& egg = masks.getEgg(frame, degrees);
+    for (int i = 0; i < pipes.size(); i++){
+        if (masksOverlap(egg, CHARACTER_X_POS, posY, masks.pipeColumns[pipes[i].freeSpotPosition - 1], pipes[i].xPosition, 0)) return true;
+    }
+    return false;
+}
+
+bool pixelsHitCharacter(const PixelMasks& masks, const int* xPosition, const int* freeSpotPosition, int totalPipe,
+                        int frame, double degrees, int posY){
+    const CollisionMask& egg = masks.getEgg(frame, degrees);
+    for (int i = 0; i < totalPipe; i++){
+        if (masksOverlap(egg, CHARACTER_X_POS, posY, masks.pipeColumns[freeSpotPosition[i] - 1], xPosition[i], 0)) return true;
+    }
+    return false;
+}
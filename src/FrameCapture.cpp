@@ -0,0 +1,224 @@
+#include "FrameCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <signal.h>
+#include "Profiler.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+static const char* PIPE_MODE = "wb";
+#else
+static const char* PIPE_MODE = "w";
+#endif
+
+//A gap longer than this (a pause, the game over screen) is cut to it, so the video doesn't fill the disk with one picture
+static const int MAX_REPEAT_SECONDS = 2;
+
+FrameCapture::FrameCapture(){
+    mWidth = 0;
+    mHeight = 0;
+    mFps = 0;
+    mPipe = false;
+    mFile = NULL;
+    mCurrent = -1;
+    mRunning = false;
+    mWriting = false;
+    mCaptured = 0;
+    mDropped = 0;
+    mWritten = 0;
+    mRepeated = 0;
+    mLeftOut = 0;
+    mNextPosition = -1;
+    mFailed = false;
+    mConvertSeconds = 0;
+    mWriteSeconds = 0;
+}
+
+FrameCapture::~FrameCapture(){
+    stop();
+}
+
+bool FrameCapture::start(const std::string& path, int width, int height, int fps, int buffers){
+    stop();
+    if (width <= 0 or height <= 0 or fps <= 0){
+        printf("Unable to capture frames of %dx%d at %d fps\n", width, height, fps);
+        return false;
+    }
+    mPipe = !path.empty() and path[0] == '|';
+#ifndef _WIN32
+    //If the command goes away the writes fail, instead of a SIGPIPE that kills the game
+    if (mPipe) signal(SIGPIPE, SIG_IGN);
+#endif
+    mFile = mPipe ? popen(path.c_str() + 1, PIPE_MODE) : fopen(path.c_str(), "wb");
+    if (mFile == NULL){
+        printf("Unable to write the capture to %s\n", path.c_str());
+        return false;
+    }
+    if (!mPipe) fprintf(mFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+
+    //Everything a frame needs is made here, once
+    if (buffers < 2) buffers = 2;
+    if (buffers > CAPTURE_MAX_BUFFERS) buffers = CAPTURE_MAX_BUFFERS;
+    mWidth = width;
+    mHeight = height;
+    mFps = fps;
+    mStart = std::chrono::steady_clock::now();
+    mBuffers.assign(buffers, std::vector<uint32_t>((size_t)width * height));
+    mPositions.assign(buffers, 0);
+    int chromaSize = ((width + 1) / 2) * ((height + 1) / 2);
+    mYuv.assign((size_t)width * height + 2 * chromaSize, 0);
+    int index;
+    while (mFree.peek(index)) mFree.pop();
+    for (int i = 0; i < buffers; i++) mFree.push(i);
+
+    mCurrent = -1;
+    mCaptured = 0;
+    mDropped = 0;
+    mWritten = 0;
+    mRepeated = 0;
+    mLeftOut = 0;
+    mNextPosition = -1;
+    mFailed = false;
+    mConvertSeconds = 0;
+    mWriteSeconds = 0;
+    mWriting = true;
+    mRunning = true;
+    mThread = std::thread(&FrameCapture::run, this);
+    return true;
+}
+
+void FrameCapture::stop(){
+    if (!mWriting) return;
+    mRunning = false;
+    mThread.join();
+    if (mPipe) pclose(mFile);
+    else if (fclose(mFile) != 0) mFailed = true;
+    mFile = NULL;
+    mWriting = false;
+}
+
+uint32_t* FrameCapture::beginFrame(){
+    if (!mWriting) return NULL;
+    if (!mFree.peek(mCurrent)){
+        mCurrent = -1;
+        mDropped++;
+        return NULL;
+    }
+    mFree.pop();
+    return &mBuffers[mCurrent][0];
+}
+
+void FrameCapture::endFrame(long long position){
+    if (mCurrent < 0) return;
+    //There are never more indexes than buffers, so it always fits. The queue hands the position over with the index
+    mPositions[mCurrent] = position;
+    mFull.push(mCurrent);
+    mCurrent = -1;
+    mCaptured++;
+}
+
+long long FrameCapture::getPosition(std::chrono::steady_clock::time_point time) const{
+    return (long long)(std::chrono::duration<double>(time - mStart).count() * mFps + 0.5);
+}
+
+void FrameCapture::run(){
+    setProfileThreadName("capture");
+    int index;
+    for (;;){
+        if (mFull.peek(index)){
+            mFull.pop();
+            writeFrame(&mBuffers[index][0], mPositions[index]);
+            mFree.push(index);
+        }
+        //The frames that were handed before stop are written too
+        else if (!mRunning) break;
+        else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void FrameCapture::writeFrame(const uint32_t* pixels, long long position){
+    //After a write error (the encoder went away, the disk is full...) the frames are just thrown away
+    if (mFailed) return;
+
+    //Its place already has a frame: the presents are faster than the video
+    if (mNextPosition >= 0 and position < mNextPosition){
+        mLeftOut++;
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    //The places that got no frame, dropped or never drawn, show the previous one for as long
+    if (mNextPosition >= 0){
+        long long repeats = std::min(position - mNextPosition, (long long)MAX_REPEAT_SECONDS * mFps);
+        PROFILE_ZONE("repeat frame");
+        for (long long i = 0; i < repeats and writeYuv(); i++) mRepeated++;
+    }
+    mNextPosition = position + 1;
+    std::chrono::steady_clock::time_point repeated = std::chrono::steady_clock::now();
+    {
+        PROFILE_ZONE("convert frame");
+        convert(pixels);
+    }
+    std::chrono::steady_clock::time_point converted = std::chrono::steady_clock::now();
+    {
+        PROFILE_ZONE("write frame");
+        if (writeYuv()) mWritten++;
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    mConvertSeconds += std::chrono::duration<double>(converted - repeated).count();
+    mWriteSeconds += std::chrono::duration<double>(end - converted + repeated - start).count();
+}
+
+bool FrameCapture::writeYuv(){
+    if (mFailed) return false;
+    if (!mPipe and fputs("FRAME\n", mFile) == EOF) mFailed = true;
+    if (fwrite(&mYuv[0], 1, mYuv.size(), mFile) != mYuv.size()) mFailed = true;
+    if (mFailed) printf("Unable to write more frames, the capture stops at %lld frames\n", mWritten + mRepeated);
+    return !mFailed;
+}
+
+void FrameCapture::convert(const uint32_t* pixels){
+    int chromaWidth = (mWidth + 1) / 2;
+    int chromaHeight = (mHeight + 1) / 2;
+    uint8_t* yPlane = &mYuv[0];
+    uint8_t* uPlane = yPlane + (size_t)mWidth * mHeight;
+    uint8_t* vPlane = uPlane + (size_t)chromaWidth * chromaHeight;
+
+    //Two rows at a time: every chroma sample is the mean of the 2x2 pixels it covers (the last row and column repeat on odd sizes)
+    for (int cy = 0; cy < chromaHeight; cy++){
+        const uint32_t* rows[2] = { pixels + (size_t)(2 * cy) * mWidth, pixels + (size_t)std::min(2 * cy + 1, mHeight - 1) * mWidth };
+        uint8_t* yRows[2] = { yPlane + (size_t)(2 * cy) * mWidth, yPlane + (size_t)(2 * cy + 1) * mWidth };
+        for (int r = 0; r < 2 and 2 * cy + r < mHeight; r++){
+            for (int x = 0; x < mWidth; x++){
+                uint32_t p = rows[r][x];
+                int red = (p >> 16) & 0xFF, green = (p >> 8) & 0xFF, blue = p & 0xFF;
+                yRows[r][x] = (uint8_t)(((66 * red + 129 * green + 25 * blue + 128) >> 8) + 16);
+            }
+        }
+        for (int cx = 0; cx < chromaWidth; cx++){
+            int x0 = 2 * cx, x1 = std::min(2 * cx + 1, mWidth - 1);
+            uint32_t quad[4] = { rows[0][x0], rows[0][x1], rows[1][x0], rows[1][x1] };
+            int red = 0, green = 0, blue = 0;
+            for (int i = 0; i < 4; i++){
+                red += (quad[i] >> 16) & 0xFF;
+                green += (quad[i] >> 8) & 0xFF;
+                blue += quad[i] & 0xFF;
+            }
+            red = (red + 2) >> 2;
+            green = (green + 2) >> 2;
+            blue = (blue + 2) >> 2;
+            uPlane[(size_t)cy * chromaWidth + cx] = (uint8_t)(((-38 * red - 74 * green + 112 * blue + 128) >> 8) + 128);
+            vPlane[(size_t)cy * chromaWidth + cx] = (uint8_t)(((112 * red - 94 * green - 18 * blue + 128) >> 8) + 128);
+        }
+    }
+}
+
+void FrameCapture::printStats(FILE* file) const{
+    long long frames = mWritten > 0 ? mWritten : 1;
+    fprintf(file, "capture: %lld frames of %dx%d captured, %lld written, %lld dropped, %lld repeated and %lld left out to play at %d fps, "
+            "%.2f ms to convert and %.2f ms to write each one%s\n",
+            mCaptured, mWidth, mHeight, mWritten, mDropped, mRepeated, mLeftOut, mFps, mConvertSeconds * 1000 / frames, mWriteSeconds * 1000 / frames,
+            mFailed ? ", stopped by a write error" : "");
+}
@@ -0,0 +1,100 @@
+#include "FrameStats.h"
+#include <math.h>
+
+FrameStats::FrameStats(const char* const* phaseNames, int phaseCount){
+    mPhases.resize(phaseCount);
+    for (int i = 0; i < phaseCount; i++) mPhases[i].name = phaseNames[i];
+    reset();
+}
+
+int FrameStats::bucketOf(long long microseconds){
+    if (microseconds < 2 * SUB_BUCKETS) return microseconds < 0 ? 0 : (int)microseconds;
+
+    //The highest bit tells the power of two, and the next five bits the bucket inside it
+    int highest = 63 - __builtin_clzll(microseconds);
+    int shift = highest - 5;
+    int bucket = 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS + (int)(microseconds >> shift) - SUB_BUCKETS;
+    return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+}
+
+long long FrameStats::bucketLowerBound(int bucket){
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+    int shift = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+    long long sub = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS;
+    return sub << shift;
+}
+
+void FrameStats::add(int phase, double microseconds){
+    Phase& p = mPhases[phase];
+    p.buckets[bucketOf((long long)microseconds)]++;
+    p.count++;
+    p.total += microseconds;
+    if (microseconds > p.max) p.max = microseconds;
+}
+
+void FrameStats::reset(){
+    for (size_t i = 0; i < mPhases.size(); i++){
+        mPhases[i].buckets.assign(BUCKET_COUNT, 0);
+        mPhases[i].count = 0;
+        mPhases[i].total = 0;
+        mPhases[i].max = 0;
+    }
+}
+
+int FrameStats::getPhaseCount(){
+    return mPhases.size();
+}
+
+const char* FrameStats::getPhaseName(int phase){
+    return mPhases[phase].name;
+}
+
+long long FrameStats::getCount(int phase){
+    return mPhases[phase].count;
+}
+
+double FrameStats::getMean(int phase){
+    return mPhases[phase].count > 0 ? mPhases[phase].total / mPhases[phase].count : 0;
+}
+
+double FrameStats::getMax(int phase){
+    return mPhases[phase].max;
+}
+
+double FrameStats::getPercentile(int phase, double fraction){
+    const Phase& p = mPhases[phase];
+    if (p.count == 0) return 0;
+
+    long long wanted = (long long)ceil(fraction * p.count);
+    if (wanted < 1) wanted = 1;
+    long long seen = 0;
+    for (int b = 0; b < BUCKET_COUNT; b++){
+        seen += p.buckets[b];
+        if (seen >= wanted){
+            //The middle of the bucket, but never more than the biggest sample
+            double lower = bucketLowerBound(b);
+            double upper = b + 1 < BUCKET_COUNT ? bucketLowerBound(b + 1) : p.max;
+            double middle = (lower + upper) / 2;
+            return middle < p.max ? middle : p.max;
+        }
+    }
+    return p.max;
+}
+
+void FrameStats::print(FILE* file){
+    fprintf(file, "%-16s %8s %10s %10s %10s %10s %10s\n", "phase (us)", "count", "mean", "p50", "p95", "p99", "max");
+    for (int i = 0; i < getPhaseCount(); i++){
+        fprintf(file, "%-16s %8lld %10.1f %10.1f %10.1f %10.1f %10.1f\n", getPhaseName(i), getCount(i), getMean(i),
+            getPercentile(i, 0.50), getPercentile(i, 0.95), getPercentile(i, 0.99), getMax(i));
+    }
+}
+
+void FrameStats::writeJson(FILE* file){
+    fprintf(file, "{");
+    for (int i = 0; i < getPhaseCount(); i++){
+        fprintf(file, "%s\n    \"%s\": { \"count\": %lld, \"mean_us\": %.2f, \"p50_us\": %.2f, \"p95_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f }",
+            i > 0 ? "," : "", getPhaseName(i), getCount(i), getMean(i),
+            getPercentile(i, 0.50), getPercentile(i, 0.95), getPercentile(i, 0.99), getMax(i));
+    }
+    fprintf(file, "\n  }");
+}
@@ -0,0 +1,175 @@
+#include "GlyphAtlas.h"
+#include <stdio.h>
+
+GlyphAtlas::GlyphAtlas(){
+    mTexture = NULL;
+    mHeight = 0;
+    for (int i = 0; i <= LAST_GLYPH - FIRST_GLYPH; i++){
+        mGlyphs[i].clip.x = mGlyphs[i].clip.y = mGlyphs[i].clip.w = mGlyphs[i].clip.h = 0;
+        mGlyphs[i].advance = 0;
+    }
+}
+
+GlyphAtlas::~GlyphAtlas(){
+    free();
+}
+
+bool GlyphAtlas::loadFromFont(TTF_Font* gFont, SDL_Renderer* gRenderer){
+    free();
+
+    SDL_Surface* atlasSurface = rasterize(gFont);
+    if (atlasSurface == NULL) return false;
+
+    bool success = loadFromSurface(atlasSurface, gRenderer);
+    SDL_FreeSurface(atlasSurface);
+    return success;
+}
+
+//It doesn't touch the texture, which belongs to the render thread
+SDL_Surface* GlyphAtlas::rasterize(TTF_Font* gFont){
+    //Every glyph is rendered in white, so the color can be chosen when drawing
+    SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+    SDL_Surface* glyphSurfaces[LAST_GLYPH - FIRST_GLYPH + 1];
+    char text[2] = { 0, 0 };
+
+    //Firstly we rasterize each character on its own and place it on a row of the atlas
+    int x = 0, y = 0;
+    int rowHeight = 0;
+    for (int c = FIRST_GLYPH; c <= LAST_GLYPH; c++){
+        Glyph& glyph = mGlyphs[c - FIRST_GLYPH];
+        text[0] = (char)c;
+        SDL_Surface* glyphSurface = TTF_RenderText_Solid(gFont, text, white);
+        glyphSurfaces[c - FIRST_GLYPH] = glyphSurface;
+        if (glyphSurface == NULL){
+            //Blank characters may have nothing to draw, but they still move the pen
+            int w = 0, h = 0;
+            TTF_SizeText(gFont, text, &w, &h);
+            glyph.advance = w;
+            continue;
+        }
+
+        if (x + glyphSurface->w > ATLAS_WIDTH){
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        glyph.clip.x = x;
+        glyph.clip.y = y;
+        glyph.clip.w = glyphSurface->w;
+        glyph.clip.h = glyphSurface->h;
+        glyph.advance = glyphSurface->w;
+        x += glyphSurface->w;
+        if (glyphSurface->h > rowHeight) rowHeight = glyphSurface->h;
+    }
+    mHeight = TTF_FontHeight(gFont);
+
+    //Now we copy all of them into one transparent surface
+    SDL_Surface* atlasSurface = SDL_CreateRGBSurface(0, ATLAS_WIDTH, y + rowHeight, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (atlasSurface == NULL){
+        printf("Unable to create the glyph atlas surface! SDL Error: %s\n", SDL_GetError());
+    }else{
+        SDL_FillRect(atlasSurface, NULL, 0);
+        for (int i = 0; i <= LAST_GLYPH - FIRST_GLYPH; i++){
+            if (glyphSurfaces[i] == NULL) continue;
+            SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyphSurfaces[i], NULL, atlasSurface, &mGlyphs[i].clip);
+        }
+    }
+
+    for (int i = 0; i <= LAST_GLYPH - FIRST_GLYPH; i++){
+        if (glyphSurfaces[i] != NULL) SDL_FreeSurface(glyphSurfaces[i]);
+    }
+    return atlasSurface;
+}
+
+bool GlyphAtlas::loadFromSurface(SDL_Surface* atlasSurface, SDL_Renderer* gRenderer){
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+
+    mTexture = SDL_CreateTextureFromSurface(gRenderer, atlasSurface);
+    if (mTexture == NULL){
+        printf("Unable to create the glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void GlyphAtlas::free(){
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+        mHeight = 0;
+    }
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::getGlyph(char character){
+    int c = (unsigned char)character;
+    if (c < FIRST_GLYPH or c > LAST_GLYPH) return NULL;
+    return &mGlyphs[c - FIRST_GLYPH];
+}
+
+int GlyphAtlas::getTextWidth(const char* text){
+    int width = 0;
+    for (const char* c = text; *c != 0; c++){
+        const Glyph* glyph = getGlyph(*c);
+        if (glyph != NULL) width += glyph->advance;
+    }
+    return width;
+}
+
+int GlyphAtlas::getHeight(){
+    return mHeight;
+}
+
+void GlyphAtlas::render(SDL_Renderer* gRenderer, const char* text, int x, int y, SDL_Color color){
+    if (mTexture == NULL) return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    //Every glyph is a quad of the same texture, so the whole text goes in one draw
+    int atlasWidth = 0, atlasHeight = 0;
+    SDL_QueryTexture(mTexture, NULL, NULL, &atlasWidth, &atlasHeight);
+    mVertices.clear();
+    mIndices.clear();
+
+    for (const char* c = text; *c != 0; c++){
+        const Glyph* glyph = getGlyph(*c);
+        if (glyph == NULL) continue;
+        if (glyph->clip.w > 0){
+            float left = (float)x, top = (float)y;
+            float right = (float)(x + glyph->clip.w), bottom = (float)(y + glyph->clip.h);
+            float u0 = (float)glyph->clip.x / atlasWidth, v0 = (float)glyph->clip.y / atlasHeight;
+            float u1 = (float)(glyph->clip.x + glyph->clip.w) / atlasWidth, v1 = (float)(glyph->clip.y + glyph->clip.h) / atlasHeight;
+
+            int first = mVertices.size();
+            SDL_Vertex corners[4] = {
+                { { left, top }, color, { u0, v0 } },
+                { { right, top }, color, { u1, v0 } },
+                { { right, bottom }, color, { u1, v1 } },
+                { { left, bottom }, color, { u0, v1 } }
+            };
+            mVertices.insert(mVertices.end(), corners, corners + 4);
+            int quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+            mIndices.insert(mIndices.end(), quad, quad + 6);
+        }
+        x += glyph->advance;
+    }
+
+    if (!mIndices.empty())
+        SDL_RenderGeometry(gRenderer, mTexture, &mVertices[0], mVertices.size(), &mIndices[0], mIndices.size());
+#else
+    //Older SDL can't draw geometry, so we copy glyph by glyph from the same texture
+    SDL_SetTextureColorMod(mTexture, color.r, color.g, color.b);
+    for (const char* c = text; *c != 0; c++){
+        const Glyph* glyph = getGlyph(*c);
+        if (glyph == NULL) continue;
+        if (glyph->clip.w > 0){
+            SDL_Rect renderQuad = { x, y, glyph->clip.w, glyph->clip.h };
+            SDL_RenderCopy(gRenderer, mTexture, &glyph->clip, &renderQuad);
+        }
+        x += glyph->advance;
+    }
+#endif
+}
@@ -5,6 +5,10 @@
 #include <string>
 #include <SDL_ttf.h>
 #include <cmath>
+#include "Profiler.h"
+
+//M_PI is not in strict C++11
+static const double PI = 3.14159265358979323846;
 
 LTexture::LTexture(){
 mTexture = NULL;
@@ -17,29 +21,65 @@ free();
 }
 
 bool LTexture::loadFromFile(std::string path, SDL_Renderer* gRenderer){
+    PROFILE_ZONE_DETAIL("LTexture::loadFromFile", path.c_str());
     free();
 
-    SDL_Texture* newTexture = NULL;
     SDL_Surface* loadedSurface = IMG_Load(path.c_str());
     if (loadedSurface==NULL){
         printf("No se ha cargado la imagen %s. SDL_Image error: %s\n",path.c_str(), IMG_GetError());
     }else{
         SDL_SetColorKey(loadedSurface,SDL_TRUE, SDL_MapRGB(loadedSurface->format,0xFF,0,0));
-        newTexture = SDL_CreateTextureFromSurface(gRenderer,loadedSurface);
-        if (newTexture==NULL){
-            printf("No se ha podido crear la textura desde %s. SDL Error: %s\n",path.c_str(),SDL_GetError());
-        }else{
-            mWidth = loadedSurface->w;
-            mHeight = loadedSurface->h;
+        if (!loadFromSurface(loadedSurface, gRenderer)){
+            printf("No se ha podido crear la textura desde %s.\n",path.c_str());
         }
         SDL_FreeSurface(loadedSurface);
     }
-    mTexture = newTexture;
     return mTexture!=NULL;
 }
 
+bool LTexture::loadFromSurface(SDL_Surface* surface, SDL_Renderer* gRenderer){
+    PROFILE_ZONE("LTexture::loadFromSurface");
+    free();
+
+    mTexture = SDL_CreateTextureFromSurface(gRenderer,surface);
+    if (mTexture==NULL){
+        printf("No se ha podido crear la textura. SDL Error: %s\n",SDL_GetError());
+    }else{
+        mWidth = surface->w;
+        mHeight = surface->h;
+    }
+    return mTexture!=NULL;
+}
+
+bool LTexture::loadFromPack(const AssetPack& pack, std::string name, SDL_Renderer* gRenderer){
+    PROFILE_ZONE_DETAIL("LTexture::loadFromPack", name.c_str());
+    free();
+
+    const PackEntry* entry = pack.find(name);
+    if (entry==NULL or entry->format==SDL_PIXELFORMAT_UNKNOWN){
+        printf("No hay ninguna imagen %s en el pack.\n",name.c_str());
+        return false;
+    }
+
+    //The pixels are already in the format the renderer wants, so they go from the mapping to the texture without any conversion
+    mTexture = SDL_CreateTexture(gRenderer,entry->format,SDL_TEXTUREACCESS_STATIC,entry->width,entry->height);
+    if (mTexture==NULL or SDL_UpdateTexture(mTexture,NULL,pack.getData(entry),entry->pitch)!=0){
+        printf("No se ha podido crear la textura desde %s. SDL Error: %s\n",name.c_str(),SDL_GetError());
+        free();
+        return false;
+    }
+    //The color key became alpha when packing
+    SDL_SetTextureBlendMode(mTexture,SDL_BLENDMODE_BLEND);
+    mWidth = entry->width;
+    mHeight = entry->height;
+    setRegions(pack.getRegions(name));
+    return true;
+}
+
 bool LTexture::loadFromRenderedText( std::string textureText, SDL_Color textColor,  TTF_Font* gFont, SDL_Renderer* gRenderer)
 {
+    PROFILE_ZONE_DETAIL("LTexture::loadFromRenderedText", textureText.c_str());
+
     //Get rid of preexisting texture
     free();
 
@@ -79,6 +119,7 @@ void LTexture::free(){
         mWidth = 0;
         mHeight = 0;
     }
+    mRegions.clear();
 }
 
 void LTexture::setColor(Uint8 red,Uint8 green,Uint8 blue){
@@ -93,12 +134,99 @@ void LTexture::setAlpha(Uint8 alpha){
 }
 
 void LTexture::render(SDL_Renderer* gRenderer, int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip ){
+    PROFILE_ZONE("LTexture::render");
     SDL_Rect renderQuad = {x,y,mWidth,mHeight};
     if (clip != NULL){
         renderQuad.w = clip->w;
         renderQuad.h = clip->h;
     }
-    SDL_RenderCopyEx(gRenderer,mTexture,clip, &renderQuad,angle,center,flip);
+    if (angle == 0.0 and flip == SDL_FLIP_NONE) SDL_RenderCopy(gRenderer,mTexture,clip,&renderQuad);
+    else SDL_RenderCopyEx(gRenderer,mTexture,clip, &renderQuad,angle,center,flip);
+}
+
+void LTexture::renderBatch(SDL_Renderer* gRenderer, const SDL_Rect* sources, const SDL_Rect* destinations, const float* angles, int count){
+    PROFILE_ZONE("LTexture::renderBatch");
+    if (mTexture == NULL or count <= 0) return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    //The geometry doesn't take the modulation of the texture, so it goes in the color of every corner
+    SDL_Color color = { 0xFF, 0xFF, 0xFF, 0xFF };
+    SDL_GetTextureColorMod(mTexture, &color.r, &color.g, &color.b);
+    SDL_GetTextureAlphaMod(mTexture, &color.a);
+    mVertices.resize(4 * count);
+    mIndices.resize(6 * count);
+    for (int i = 0; i < count; i++){
+        const SDL_Rect& source = sources[i];
+        const SDL_Rect& destination = destinations[i];
+        float u0 = (float)source.x / mWidth, v0 = (float)source.y / mHeight;
+        float u1 = (float)(source.x + source.w) / mWidth, v1 = (float)(source.y + source.h) / mHeight;
+
+        //The corners turn clockwise around the center, like SDL_RenderCopyEx does
+        float halfWidth = destination.w / 2.0f, halfHeight = destination.h / 2.0f;
+        float centerX = destination.x + halfWidth, centerY = destination.y + halfHeight;
+        double radians = angles[i] * PI / 180.0;
+        float c = angles[i] == 0 ? 1.0f : (float)cos(radians), s = angles[i] == 0 ? 0.0f : (float)sin(radians);
+        const float cornerX[4] = { -halfWidth, halfWidth, halfWidth, -halfWidth };
+        const float cornerY[4] = { -halfHeight, -halfHeight, halfHeight, halfHeight };
+        const float cornerU[4] = { u0, u1, u1, u0 };
+        const float cornerV[4] = { v0, v0, v1, v1 };
+        for (int k = 0; k < 4; k++){
+            SDL_Vertex& vertex = mVertices[4 * i + k];
+            vertex.position.x = centerX + cornerX[k] * c - cornerY[k] * s;
+            vertex.position.y = centerY + cornerX[k] * s + cornerY[k] * c;
+            vertex.color = color;
+            vertex.tex_coord.x = cornerU[k];
+            vertex.tex_coord.y = cornerV[k];
+        }
+        int quad[6] = { 4 * i, 4 * i + 1, 4 * i + 2, 4 * i, 4 * i + 2, 4 * i + 3 };
+        for (int k = 0; k < 6; k++) mIndices[6 * i + k] = quad[k];
+    }
+    SDL_RenderGeometry(gRenderer, mTexture, &mVertices[0], 4 * count, &mIndices[0], 6 * count);
+#else
+    //Older SDL can't draw geometry, so it is a copy per piece
+    for (int i = 0; i < count; i++){
+        if (angles[i] == 0) SDL_RenderCopy(gRenderer, mTexture, &sources[i], &destinations[i]);
+        else SDL_RenderCopyEx(gRenderer, mTexture, &sources[i], &destinations[i], angles[i], NULL, SDL_FLIP_NONE);
+    }
+#endif
+}
+
+void LTexture::setRegions(const std::vector<AtlasRegion>& regions){
+    mRegions = regions;
+}
+
+int LTexture::getRegion(std::string name){
+    for (size_t i = 0; i < mRegions.size(); i++){
+        if (mRegions[i].name == name) return i;
+    }
+    return -1;
+}
+
+void LTexture::renderRegion(SDL_Renderer* gRenderer, int x, int y, int region, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip){
+    if (region < 0 or region >= (int)mRegions.size()) return;
+    PROFILE_ZONE_DETAIL("LTexture::renderRegion", mRegions[region].name.c_str());
+
+    //The clip is moved inside the region, so sprite sheets keep their own coordinates
+    SDL_Rect source = mRegions[region].rect;
+    if (clip != NULL){
+        source.x += clip->x;
+        source.y += clip->y;
+        source.w = clip->w;
+        source.h = clip->h;
+    }
+    SDL_Rect renderQuad = {x,y,source.w,source.h};
+    if (angle == 0.0 and flip == SDL_FLIP_NONE) SDL_RenderCopy(gRenderer,mTexture,&source,&renderQuad);
+    else SDL_RenderCopyEx(gRenderer,mTexture,&source, &renderQuad,angle,center,flip);
+}
+
+int LTexture::getRegionWidth(int region){
+    if (region < 0 or region >= (int)mRegions.size()) return 0;
+    return mRegions[region].rect.w;
+}
+
+int LTexture::getRegionHeight(int region){
+    if (region < 0 or region >= (int)mRegions.size()) return 0;
+    return mRegions[region].rect.h;
 }
 
 int LTexture::getWidth(){
@@ -110,3 +238,19 @@ int LTexture::getHeight(){
 }
 
 
+
+size_t LTexture::getMemoryBytes(){
+    if (mTexture == NULL) return 0;
+    size_t bytes = getTextureMemoryBytes(mTexture);
+    return bytes > 0 ? bytes : (size_t)mWidth * mHeight * 4;
+}
+
+size_t getTextureMemoryBytes(SDL_Texture* texture){
+    if (texture == NULL) return 0;
+    Uint32 format;
+    int width, height;
+    if (SDL_QueryTexture(texture, &format, NULL, &width, &height) != 0) return 0;
+    //Formats like YUV have less than a byte per pixel, so we count them as one
+    int bytesPerPixel = SDL_ISPIXELFORMAT_FOURCC(format) ? 1 : SDL_BYTESPERPIXEL(format);
+    return (size_t)width * height * bytesPerPixel;
+}
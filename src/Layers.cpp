@@ -0,0 +1,232 @@
+#include "Layers.h"
+#include <stdio.h>
+#include <math.h>
+
+StaticLayer::StaticLayer(){
+    mRenderer = NULL;
+    mTexture = NULL;
+    mWidth = 0;
+    mHeight = 0;
+    mOpaque = false;
+}
+
+StaticLayer::~StaticLayer(){
+    free();
+}
+
+bool StaticLayer::build(SDL_Renderer* gRenderer, int width, int height, bool opaque, DrawFunction draw){
+    free();
+    mRenderer = gRenderer;
+    mWidth = width;
+    mHeight = height;
+    mOpaque = opaque;
+    mDraw = draw;
+    return rebuild();
+}
+
+bool StaticLayer::rebuild(){
+    if (mRenderer == NULL) return false;
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+
+    //Without render targets we just keep drawing it
+    if (!SDL_RenderTargetSupported(mRenderer)) return true;
+
+    mTexture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, mWidth, mHeight);
+    if (mTexture == NULL){
+        printf("Unable to create a layer texture, it will be drawn every frame. SDL Error: %s\n", SDL_GetError());
+        return true;
+    }
+
+    //Going back to a texture target leaves the scale at 1, so we put it back too
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(mRenderer);
+    float scaleX, scaleY;
+    SDL_RenderGetScale(mRenderer, &scaleX, &scaleY);
+    SDL_SetRenderTarget(mRenderer, mTexture);
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, 0);
+    SDL_RenderClear(mRenderer);
+    mDraw(mRenderer);
+    SDL_SetRenderTarget(mRenderer, previousTarget);
+    SDL_RenderSetScale(mRenderer, scaleX, scaleY);
+
+    SDL_SetTextureBlendMode(mTexture, mOpaque ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+void StaticLayer::free(){
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+    mRenderer = NULL;
+    mDraw = DrawFunction();
+}
+
+void StaticLayer::render(){
+    if (mRenderer == NULL) return;
+    if (mTexture == NULL) mDraw(mRenderer);
+    else SDL_RenderCopy(mRenderer, mTexture, NULL, NULL);
+}
+
+void StaticLayer::render(const SDL_Rect& rect){
+    if (mRenderer == NULL) return;
+    if (mTexture == NULL){
+        SDL_RenderSetClipRect(mRenderer, &rect);
+        mDraw(mRenderer);
+        SDL_RenderSetClipRect(mRenderer, NULL);
+    }
+    else SDL_RenderCopy(mRenderer, mTexture, &rect, &rect);
+}
+
+DirtyRegions::DirtyRegions(int width, int height){
+    mScreen.x = 0;
+    mScreen.y = 0;
+    mScreen.w = width;
+    mScreen.h = height;
+    mPadding = 0;
+    mInvalidated = true;
+}
+
+void DirtyRegions::add(const SDL_Rect& rect){
+    SDL_Rect padded = { rect.x - mPadding, rect.y - mPadding, rect.w + 2 * mPadding, rect.h + 2 * mPadding };
+    SDL_Rect visible;
+    if (SDL_IntersectRect(&padded, &mScreen, &visible)) mCurrent.push_back(visible);
+}
+
+void DirtyRegions::setPadding(int pixels){
+    mPadding = pixels;
+}
+
+void DirtyRegions::invalidate(){
+    mInvalidated = true;
+}
+
+bool DirtyRegions::getRegions(std::vector<SDL_Rect>& regions){
+    regions.clear();
+    if (mInvalidated){
+        mInvalidated = false;
+        return false;
+    }
+
+    regions = mPrevious;
+    regions.insert(regions.end(), mCurrent.begin(), mCurrent.end());
+
+    //Overlapping areas become one, so nothing is copied twice. Their union is a bit bigger, but it's one copy less
+    for (size_t i = 0; i < regions.size(); i++){
+        for (size_t j = i + 1; j < regions.size(); ){
+            if (SDL_HasIntersection(&regions[i], &regions[j])){
+                SDL_UnionRect(&regions[i], &regions[j], &regions[i]);
+                regions.erase(regions.begin() + j);
+                //It has grown, so it can touch the ones that were already checked
+                j = i + 1;
+            }
+            else j++;
+        }
+    }
+
+    //Past half of the screen one big copy is cheaper than a lot of small ones
+    long long area = 0;
+    for (size_t i = 0; i < regions.size(); i++) area += (long long)regions[i].w * regions[i].h;
+    if (area * 2 > (long long)mScreen.w * mScreen.h){
+        regions.clear();
+        return false;
+    }
+    return true;
+}
+
+void DirtyRegions::endFrame(){
+    mPrevious.swap(mCurrent);
+    mCurrent.clear();
+}
+
+ScaledTarget::ScaledTarget(){
+    mRenderer = NULL;
+    mTexture = NULL;
+    mWidth = 0;
+    mHeight = 0;
+    mTextureWidth = 0;
+    mTextureHeight = 0;
+    mScale = 1;
+}
+
+ScaledTarget::~ScaledTarget(){
+    free();
+}
+
+void ScaledTarget::create(SDL_Renderer* gRenderer, int width, int height){
+    free();
+    mRenderer = gRenderer;
+    mWidth = width;
+    mHeight = height;
+}
+
+void ScaledTarget::free(){
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+    mScale = 1;
+}
+
+bool ScaledTarget::setScale(double scale){
+    if (mRenderer == NULL) return false;
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+    mScale = 1;
+    if (scale >= 1) return true;
+    if (!SDL_RenderTargetSupported(mRenderer)) return false;
+
+    mTextureWidth = (int)ceil(mWidth * scale);
+    mTextureHeight = (int)ceil(mHeight * scale);
+    mTexture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, mTextureWidth, mTextureHeight);
+    if (mTexture == NULL){
+        printf("Unable to create a %dx%d target, drawing at full size. SDL Error: %s\n", mTextureWidth, mTextureHeight, SDL_GetError());
+        return false;
+    }
+    //Everything drawn into it is already blended, so it is copied as it is
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_NONE);
+    mScale = scale;
+    return true;
+}
+
+void ScaledTarget::begin(){
+    if (mTexture == NULL) return;
+    SDL_SetRenderTarget(mRenderer, mTexture);
+    SDL_RenderSetScale(mRenderer, (float)mScale, (float)mScale);
+}
+
+SDL_Rect ScaledTarget::stretch(const SDL_Rect& source) const{
+    int x = (int)floor(source.x / mScale), y = (int)floor(source.y / mScale);
+    SDL_Rect destination = { x, y, (int)ceil((source.x + source.w) / mScale) - x, (int)ceil((source.y + source.h) / mScale) - y };
+    return destination;
+}
+
+void ScaledTarget::end(const std::vector<SDL_Rect>* regions){
+    if (mTexture == NULL) return;
+    SDL_SetRenderTarget(mRenderer, NULL);
+    SDL_RenderSetScale(mRenderer, 1, 1);
+    //Every pixel of the texture covers the same part of the screen in both paths, so a full frame and the
+    //areas copied over it later line up. The last column and row can reach past the window, which clips them
+    SDL_Rect texture = { 0, 0, mTextureWidth, mTextureHeight };
+    if (regions == NULL){
+        SDL_Rect destination = stretch(texture);
+        SDL_RenderCopy(mRenderer, mTexture, &texture, &destination);
+        return;
+    }
+
+    //The pixels of the texture that cover each area
+    for (size_t r = 0; r < regions->size(); r++){
+        const SDL_Rect& area = (*regions)[r];
+        int left = (int)floor(area.x * mScale), top = (int)floor(area.y * mScale);
+        SDL_Rect covering = { left, top, (int)ceil((area.x + area.w) * mScale) - left, (int)ceil((area.y + area.h) * mScale) - top };
+        SDL_Rect source;
+        if (!SDL_IntersectRect(&covering, &texture, &source)) continue;
+        SDL_Rect destination = stretch(source);
+        SDL_RenderCopy(mRenderer, mTexture, &source, &destination);
+    }
+}
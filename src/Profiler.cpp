@@ -0,0 +1,156 @@
+#include "Profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> gProfiling(false);
+
+//One zone of the trace. The times are nanoseconds since the profiler was loaded
+struct ProfileEvent{
+    const char* name;
+    long long start;
+    long long end;
+    char detail[40];
+};
+
+//The zones of one thread. Only that thread writes, and it publishes how many it has written after each one,
+//so a reader knows which ones are complete. It belongs to the list of rings, so it outlives its thread
+struct ProfileRing{
+    //About 2 MB per thread, some minutes of frames
+    static const long long CAPACITY = 1 << 15;
+
+    ProfileRing() : events(CAPACITY), written(0) { name[0] = '\0'; }
+
+    std::vector<ProfileEvent> events;
+    std::atomic<long long> written;
+    char name[32];
+    int id;
+};
+
+static const std::chrono::steady_clock::time_point gProfileEpoch = std::chrono::steady_clock::now();
+
+//Only taken when a thread records its first zone and when the trace is written
+static std::mutex gRingsMutex;
+static std::vector<ProfileRing*> gRings;
+
+static thread_local ProfileRing* tRing = NULL;
+static thread_local char tThreadName[32] = "";
+
+static long long profileTime(std::chrono::steady_clock::time_point time){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - gProfileEpoch).count();
+}
+
+static long long profileNow(){
+    return profileTime(std::chrono::steady_clock::now());
+}
+
+static ProfileRing* threadRing(){
+    if (tRing == NULL){
+        ProfileRing* ring = new ProfileRing();
+        snprintf(ring->name, sizeof(ring->name), "%s", tThreadName);
+        std::lock_guard<std::mutex> lock(gRingsMutex);
+        ring->id = (int)gRings.size() + 1;
+        gRings.push_back(ring);
+        tRing = ring;
+    }
+    return tRing;
+}
+
+void setProfiling(bool enabled){
+    gProfiling.store(enabled, std::memory_order_relaxed);
+}
+
+void setProfileThreadName(const char* name){
+    snprintf(tThreadName, sizeof(tThreadName), "%s", name);
+    if (tRing != NULL){
+        std::lock_guard<std::mutex> lock(gRingsMutex);
+        snprintf(tRing->name, sizeof(tRing->name), "%s", name);
+    }
+}
+
+static void recordZone(const char* name, long long start, long long end, const char* detail){
+    ProfileRing* ring = threadRing();
+    long long index = ring->written.load(std::memory_order_relaxed);
+    ProfileEvent& event = ring->events[index & (ProfileRing::CAPACITY - 1)];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    if (detail != NULL) snprintf(event.detail, sizeof(event.detail), "%s", detail);
+    else event.detail[0] = '\0';
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+void addProfileZone(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end){
+    if (isProfiling()) recordZone(name, profileTime(start), profileTime(end), NULL);
+}
+
+void ProfileZone::begin(const char* name, const char* detail){
+    mName = name;
+    mDetail = detail;
+    mStart = profileNow();
+}
+
+void ProfileZone::end(){
+    recordZone(mName, mStart, profileNow(), mDetail);
+}
+
+//The names and details are ours, but a file name can have anything
+static void writeJsonString(FILE* file, const char* text){
+    fputc('"', file);
+    for (const char* c = text; *c != '\0'; c++){
+        if (*c == '"' or *c == '\\') fprintf(file, "\\%c", *c);
+        else if ((unsigned char)*c < 0x20) fprintf(file, "\\u%04x", *c);
+        else fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+bool writeChromeTrace(const char* path){
+    FILE* file = fopen(path, "w");
+    if (file == NULL){
+        printf("Unable to write the trace to %s\n", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(gRingsMutex);
+    long long total = 0, lost = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (size_t r = 0; r < gRings.size(); r++){
+        ProfileRing* ring = gRings[r];
+        fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", ring->id);
+        writeJsonString(file, ring->name[0] != '\0' ? ring->name : "thread");
+        fprintf(file, "}}");
+        first = false;
+
+        //The thread can still be writing: we copy what it had published, and then throw away what it may have overwritten meanwhile
+        long long written = ring->written.load(std::memory_order_acquire);
+        long long begin = written > ProfileRing::CAPACITY ? written - ProfileRing::CAPACITY : 0;
+        std::vector<ProfileEvent> events;
+        for (long long i = begin; i < written; i++) events.push_back(ring->events[i & (ProfileRing::CAPACITY - 1)]);
+        long long now = ring->written.load(std::memory_order_acquire);
+        long long oldest = now >= ProfileRing::CAPACITY ? now - ProfileRing::CAPACITY + 1 : 0;
+        if (oldest < begin) oldest = begin;
+        lost += oldest;
+
+        for (long long i = oldest; i < written; i++){
+            const ProfileEvent& event = events[i - begin];
+            fprintf(file, ",\n{\"ph\":\"X\",\"name\":");
+            writeJsonString(file, event.name);
+            fprintf(file, ",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", ring->id, event.start / 1000.0, (event.end - event.start) / 1000.0);
+            if (event.detail[0] != '\0'){
+                fprintf(file, ",\"args\":{\"detail\":");
+                writeJsonString(file, event.detail);
+                fprintf(file, "}");
+            }
+            fprintf(file, "}");
+            total++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    bool success = fclose(file) == 0;
+    printf("Trace: %lld zones of %d threads written to %s%s\n", total, (int)gRings.size(), path, lost > 0 ? ", the oldest ones were overwritten" : "");
+    return success;
+}
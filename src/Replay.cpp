@@ -0,0 +1,186 @@
+#include "Replay.h"
+#include "CollisionMask.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static const char REPLAY_MAGIC[4] = { 'F', 'L', 'R', 'P' };
+static const unsigned int REPLAY_VERSION = 3;
+
+static void writeU32(std::vector<unsigned char>& out, unsigned int value){
+    for (int i = 0; i < 4; i++) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+static void writeVarint(std::vector<unsigned char>& out, unsigned int value){
+    while (value >= 0x80){
+        out.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+//Both readers move pos forward and return false if the data ends before the number does
+static bool readU32(const std::vector<unsigned char>& in, size_t& pos, unsigned int& value){
+    if (pos + 4 > in.size()) return false;
+    value = 0;
+    for (int i = 0; i < 4; i++) value |= (unsigned int)in[pos + i] << (8 * i);
+    pos += 4;
+    return true;
+}
+
+static bool readVarint(const std::vector<unsigned char>& in, size_t& pos, unsigned int& value){
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7){
+        if (pos >= in.size()) return false;
+        unsigned char byte = in[pos++];
+        value |= (unsigned int)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+Replay::Replay(){
+    start(0, false);
+}
+
+void Replay::start(unsigned int seed, bool pixelCollision){
+    mSeed = seed;
+    mTicks = 0;
+    mChecksumInterval = REPLAY_CHECKSUM_INTERVAL;
+    mPixelCollision = pixelCollision;
+    mFlapTicks.clear();
+    mChecksums.clear();
+    mCursor = 0;
+}
+
+void Replay::record(const WorldInput& input, const World& world){
+    if (input.flap) mFlapTicks.push_back(mTicks);
+    mTicks++;
+    if (mTicks % mChecksumInterval == 0) mChecksums.push_back(world.checksum());
+}
+
+bool Replay::save(std::string path) const{
+    std::vector<unsigned char> data;
+    data.insert(data.end(), REPLAY_MAGIC, REPLAY_MAGIC + 4);
+    writeU32(data, REPLAY_VERSION);
+    writeU32(data, mSeed);
+    writeU32(data, mTicks);
+    writeU32(data, mChecksumInterval);
+    writeU32(data, mPixelCollision ? 1 : 0);
+    writeU32(data, mFlapTicks.size());
+    int previous = 0;
+    for (size_t i = 0; i < mFlapTicks.size(); i++){
+        writeVarint(data, mFlapTicks[i] - previous);
+        previous = mFlapTicks[i];
+    }
+    for (size_t i = 0; i < mChecksums.size(); i++) writeU32(data, mChecksums[i]);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == NULL){
+        printf("Unable to write the replay %s\n", path.c_str());
+        return false;
+    }
+    bool success = fwrite(&data[0], 1, data.size(), file) == data.size();
+    if (fclose(file) != 0) success = false;
+    if (!success) printf("Unable to write the replay %s\n", path.c_str());
+    return success;
+}
+
+bool Replay::load(std::string path){
+    start(0, false);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL){
+        printf("Unable to read the replay %s\n", path.c_str());
+        return false;
+    }
+    std::vector<unsigned char> data;
+    unsigned char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + read);
+    fclose(file);
+
+    size_t pos = 4;
+    unsigned int version = 0, seed, ticks, interval, collision, flaps;
+    bool valid = data.size() >= 4 and memcmp(&data[0], REPLAY_MAGIC, 4) == 0;
+    valid = valid and readU32(data, pos, version) and version == REPLAY_VERSION;
+    valid = valid and readU32(data, pos, seed) and readU32(data, pos, ticks) and readU32(data, pos, interval);
+    valid = valid and readU32(data, pos, collision) and readU32(data, pos, flaps);
+    valid = valid and ticks < 0x7FFFFFFF and interval > 0 and collision <= 1 and flaps <= ticks;
+
+    //The flaps have to be in order and inside the game
+    unsigned int tick = 0;
+    for (unsigned int i = 0; i < flaps and valid; i++){
+        unsigned int distance;
+        valid = readVarint(data, pos, distance) and (i == 0 or distance > 0) and distance < ticks - tick;
+        if (valid){
+            tick += distance;
+            mFlapTicks.push_back(tick);
+        }
+    }
+    for (unsigned int i = 0; valid and i < ticks / interval; i++){
+        unsigned int checksum;
+        valid = readU32(data, pos, checksum);
+        mChecksums.push_back(checksum);
+    }
+    if (!valid){
+        printf("%s is not a valid replay (version %u)\n", path.c_str(), version);
+        start(0, false);
+        return false;
+    }
+
+    mSeed = seed;
+    mTicks = ticks;
+    mChecksumInterval = interval;
+    mPixelCollision = collision == 1;
+    return true;
+}
+
+bool Replay::usesPixelCollision() const{
+    return mPixelCollision;
+}
+
+unsigned int Replay::getSeed() const{
+    return mSeed;
+}
+
+int Replay::getTickCount() const{
+    return mTicks;
+}
+
+int Replay::getFlapCount() const{
+    return mFlapTicks.size();
+}
+
+WorldInput Replay::getInput(int tick){
+    //Going back (or far forward) needs a search, the usual next tick doesn't
+    if (mCursor > 0 and mFlapTicks[mCursor - 1] >= tick) mCursor = 0;
+    if (mCursor < mFlapTicks.size() and mFlapTicks[mCursor] < tick)
+        mCursor = std::lower_bound(mFlapTicks.begin() + mCursor, mFlapTicks.end(), tick) - mFlapTicks.begin();
+
+    WorldInput input = { false };
+    if (mCursor < mFlapTicks.size() and mFlapTicks[mCursor] == tick){
+        input.flap = true;
+        mCursor++;
+    }
+    return input;
+}
+
+bool Replay::check(int tick, const World& world) const{
+    //The checksum of the tick count n is the one kept after stepping tick n - 1
+    int stepped = tick + 1;
+    if (stepped % mChecksumInterval != 0) return true;
+    size_t index = stepped / mChecksumInterval - 1;
+    if (index >= mChecksums.size()) return true;
+    return mChecksums[index] == world.checksum();
+}
+
+int Replay::play(World& world, int ticks){
+    if (ticks < 0 or ticks > mTicks) ticks = mTicks;
+    world.restart(mSeed);
+    mCursor = 0;
+    for (int tick = 0; tick < ticks; tick++){
+        world.step(getInput(tick));
+        if (!check(tick, world)) return tick;
+    }
+    return -1;
+}
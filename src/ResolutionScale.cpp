@@ -0,0 +1,80 @@
+#include "ResolutionScale.h"
+
+const double RESOLUTION_LEVELS[RESOLUTION_LEVEL_COUNT] = { 1.0, 0.875, 0.75, 0.625, 0.5 };
+
+//How much of the last frame goes into the average
+static const double SMOOTHING = 0.1;
+
+//Going up has to leave this much of the target free
+static const double UP_MARGIN = 0.85;
+
+//The longest wait before going up again, in frames
+static const int MAX_UP_FRAMES = 960;
+
+ResolutionController::ResolutionController(){
+    mTarget = 12500;
+    mAuto = false;
+    mLevel = 0;
+    mSettle = 0;
+    mSamples = 0;
+    mAverage = 0;
+    mUpFrames = UP_FRAMES;
+    mWentUp = false;
+    mChanges = 0;
+    mLowest = 0;
+}
+
+void ResolutionController::setTarget(double targetMicroseconds){
+    mTarget = targetMicroseconds;
+}
+
+void ResolutionController::setAuto(bool enabled){
+    mAuto = enabled;
+}
+
+void ResolutionController::setLevel(int level){
+    if (level < 0) level = 0;
+    if (level >= RESOLUTION_LEVEL_COUNT) level = RESOLUTION_LEVEL_COUNT - 1;
+    if (level != mLevel) changeLevel(level);
+}
+
+bool ResolutionController::addFrame(double microseconds){
+    if (!mAuto) return false;
+    if (mSettle > 0){
+        mSettle--;
+        return false;
+    }
+    mAverage = mSamples == 0 ? microseconds : mAverage + (microseconds - mAverage) * SMOOTHING;
+    mSamples++;
+
+    if (mLevel + 1 < RESOLUTION_LEVEL_COUNT and mSamples >= DOWN_FRAMES and mAverage > mTarget){
+        //Going up didn't pay, so the next try waits longer
+        if (mWentUp and mUpFrames < MAX_UP_FRAMES) mUpFrames *= 2;
+        mWentUp = false;
+        changeLevel(mLevel + 1);
+        return true;
+    }
+    if (mLevel > 0 and mSamples >= mUpFrames){
+        double ratio = RESOLUTION_LEVELS[mLevel - 1] / RESOLUTION_LEVELS[mLevel];
+        if (mAverage * ratio * ratio < mTarget * UP_MARGIN){
+            mWentUp = true;
+            changeLevel(mLevel - 1);
+            return true;
+        }
+    }
+
+    //A level that has held for a while is good, the waits start again from the beginning
+    if (mSamples >= MAX_UP_FRAMES){
+        mUpFrames = UP_FRAMES;
+        mWentUp = false;
+    }
+    return false;
+}
+
+void ResolutionController::changeLevel(int level){
+    mLevel = level;
+    mSettle = SETTLE_FRAMES;
+    mSamples = 0;
+    mChanges++;
+    if (level > mLowest) mLowest = level;
+}
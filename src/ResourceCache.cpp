@@ -0,0 +1,213 @@
+#include "ResourceCache.h"
+
+TextureHandle::TextureHandle(){
+    mEntry = NULL;
+}
+
+TextureHandle::TextureHandle(ResourceEntry* entry){
+    mEntry = entry;
+    if (mEntry != NULL) mEntry->handles++;
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other){
+    mEntry = other.mEntry;
+    if (mEntry != NULL) mEntry->handles++;
+}
+
+TextureHandle& TextureHandle::operator=(const TextureHandle& other){
+    if (other.mEntry != NULL) other.mEntry->handles++;
+    reset();
+    mEntry = other.mEntry;
+    return *this;
+}
+
+TextureHandle::~TextureHandle(){
+    reset();
+}
+
+LTexture* TextureHandle::get() const{
+    if (mEntry->cache != NULL){
+        mEntry->cache->ensureLoaded(mEntry);
+        mEntry->cache->touch(mEntry);
+    }
+    return &mEntry->texture;
+}
+
+void TextureHandle::reset(){
+    if (mEntry == NULL) return;
+    ResourceEntry* entry = mEntry;
+    mEntry = NULL;
+    if (entry->cache != NULL) entry->cache->release(entry);
+    //A leak that outlived the cache: its texture is already gone
+    else if (--entry->handles == 0) delete entry;
+}
+
+ResourceCache::ResourceCache(){
+    mBudget = 0;
+    mBytes = 0;
+    mClock = 0;
+    mLoads = 0;
+    mHits = 0;
+    mEvictions = 0;
+}
+
+ResourceCache::~ResourceCache(){
+    shutdown();
+}
+
+TextureHandle ResourceCache::load(const std::string& key, LoadFunction load, LoadFunction reload){
+    std::map<std::string, ResourceEntry*>::iterator found = mEntries.find(key);
+    if (found != mEntries.end()){
+        mHits++;
+        ResourceEntry* entry = found->second;
+        if (!ensureLoaded(entry)) return TextureHandle();
+        touch(entry);
+        return TextureHandle(entry);
+    }
+
+    ResourceEntry* entry = new ResourceEntry();
+    entry->cache = this;
+    entry->key = key;
+    entry->reload = reload;
+    entry->loaded = false;
+    entry->handles = 0;
+    entry->bytes = 0;
+    entry->lastUse = 0;
+    if (!load(entry->texture)){
+        printf("Unable to load the texture %s\n", key.c_str());
+        delete entry;
+        return TextureHandle();
+    }
+    entry->loaded = true;
+    entry->bytes = entry->texture.getMemoryBytes();
+    mBytes += entry->bytes;
+    mLoads++;
+    mEntries[key] = entry;
+    touch(entry);
+
+    TextureHandle handle(entry);
+    enforceBudget(entry);
+    return handle;
+}
+
+void ResourceCache::track(const std::string& key, TextureSource texture){
+    mTracked[key] = texture;
+    enforceBudget(NULL);
+}
+
+void ResourceCache::setBudget(size_t bytes){
+    mBudget = bytes;
+    enforceBudget(NULL);
+}
+
+size_t ResourceCache::getBytesInUse() const{
+    return mBytes + getTrackedBytes();
+}
+
+size_t ResourceCache::getTrackedBytes() const{
+    size_t bytes = 0;
+    for (std::map<std::string, TextureSource>::const_iterator it = mTracked.begin(); it != mTracked.end(); ++it)
+        bytes += getTextureMemoryBytes(it->second());
+    return bytes;
+}
+
+bool ResourceCache::ensureLoaded(ResourceEntry* entry){
+    if (entry->loaded) return true;
+    if (!entry->reload or !entry->reload(entry->texture)){
+        printf("Unable to load the texture %s again\n", entry->key.c_str());
+        return false;
+    }
+    entry->loaded = true;
+    entry->bytes = entry->texture.getMemoryBytes();
+    mBytes += entry->bytes;
+    mLoads++;
+    enforceBudget(entry);
+    return true;
+}
+
+void ResourceCache::touch(ResourceEntry* entry){
+    entry->lastUse = ++mClock;
+}
+
+void ResourceCache::release(ResourceEntry* entry){
+    if (--entry->handles > 0) return;
+    //What can be loaded again stays, in case somebody asks for it again, until the budget needs the memory
+    if (entry->loaded and entry->reload and (mBudget == 0 or getBytesInUse() <= mBudget)) return;
+    unload(entry);
+    mEntries.erase(entry->key);
+    delete entry;
+}
+
+void ResourceCache::unload(ResourceEntry* entry){
+    if (!entry->loaded) return;
+    entry->texture.free();
+    entry->loaded = false;
+    mBytes -= entry->bytes;
+}
+
+void ResourceCache::enforceBudget(ResourceEntry* keep){
+    if (mBudget == 0) return;
+    //The tracked textures can't go, so the ones of the cache make room for them
+    size_t tracked = getTrackedBytes();
+    while (mBytes + tracked > mBudget){
+        //The textures that nobody holds go first, and then the ones used the longest ago
+        ResourceEntry* victim = NULL;
+        for (std::map<std::string, ResourceEntry*>::iterator it = mEntries.begin(); it != mEntries.end(); ++it){
+            ResourceEntry* entry = it->second;
+            if (entry == keep or !entry->loaded or !entry->reload) continue;
+            if (victim == NULL or (entry->handles == 0) > (victim->handles == 0)
+                or ((entry->handles == 0) == (victim->handles == 0) and entry->lastUse < victim->lastUse)) victim = entry;
+        }
+        if (victim == NULL) return;
+
+        unload(victim);
+        mEvictions++;
+        if (victim->handles == 0){
+            mEntries.erase(victim->key);
+            delete victim;
+        }
+    }
+}
+
+void ResourceCache::printReport(FILE* file) const{
+    fprintf(file, "%-24s %10s %8s %s\n", "texture", "KB", "handles", "state");
+    for (std::map<std::string, ResourceEntry*>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it){
+        const ResourceEntry* entry = it->second;
+        fprintf(file, "%-24s %10.1f %8d %s%s\n", entry->key.c_str(), entry->bytes / 1024.0, entry->handles,
+                entry->loaded ? "loaded" : "evicted", entry->reload ? ", reloadable" : "");
+    }
+    for (std::map<std::string, TextureSource>::const_iterator it = mTracked.begin(); it != mTracked.end(); ++it){
+        SDL_Texture* texture = it->second();
+        fprintf(file, "%-24s %10.1f %8s %s\n", it->first.c_str(), getTextureMemoryBytes(texture) / 1024.0, "-",
+                texture != NULL ? "tracked" : "tracked, none now");
+    }
+    fprintf(file, "%.1f MB of textures", getBytesInUse() / (1024.0 * 1024.0));
+    if (!mTracked.empty()) fprintf(file, ", %.1f MB of them tracked", getTrackedBytes() / (1024.0 * 1024.0));
+    if (mBudget > 0) fprintf(file, " (budget %.1f MB)", mBudget / (1024.0 * 1024.0));
+    fprintf(file, ", %d loads, %d hits, %d evictions\n", mLoads, mHits, mEvictions);
+}
+
+int ResourceCache::shutdown(){
+    int leaks = 0;
+    for (std::map<std::string, ResourceEntry*>::iterator it = mEntries.begin(); it != mEntries.end(); ++it){
+        ResourceEntry* entry = it->second;
+        unload(entry);
+        if (entry->handles > 0){
+            printf("Leak: the texture %s still has %d handles\n", entry->key.c_str(), entry->handles);
+            leaks++;
+            //The last handle deletes it
+            entry->cache = NULL;
+        }
+        else delete entry;
+    }
+    mEntries.clear();
+
+    //What the others make has to be gone by now too
+    for (std::map<std::string, TextureSource>::iterator it = mTracked.begin(); it != mTracked.end(); ++it){
+        if (it->second() == NULL) continue;
+        printf("Leak: the texture %s was not freed before the cache\n", it->first.c_str());
+        leaks++;
+    }
+    mTracked.clear();
+    return leaks;
+}
@@ -0,0 +1,152 @@
+#include "RotationCache.h"
+#include <stdio.h>
+#include <math.h>
+
+RotationCache::RotationCache(){
+    mRenderer = NULL;
+    mTexture = NULL;
+    mFrameCount = 0;
+    mFrameWidth = 0;
+    mFrameHeight = 0;
+    mMinDegrees = 0;
+    mStep = 1;
+    mAngleCount = 0;
+    mCellWidth = 0;
+    mCellHeight = 0;
+    mColumns = 1;
+    mUses = 0;
+    mBakes = 0;
+}
+
+RotationCache::~RotationCache(){
+    free();
+}
+
+bool RotationCache::build(SDL_Renderer* gRenderer, int frameCount, int frameWidth, int frameHeight, double minDegrees, double maxDegrees,
+                          double step, size_t budget, DrawFunction draw){
+    free();
+    if (step <= 0 or frameCount <= 0 or !SDL_RenderTargetSupported(gRenderer)) return false;
+
+    mFrameCount = frameCount;
+    mFrameWidth = frameWidth;
+    mFrameHeight = frameHeight;
+    mMinDegrees = minDegrees;
+    mStep = step;
+    mAngleCount = (int)ceil((maxDegrees - minDegrees) / step) + 1;
+
+    //The diagonal fits any rotation, and one more pixel on each side keeps the linear filter away from the neighbours
+    int diagonal = (int)ceil(sqrt((double)frameWidth * frameWidth + (double)frameHeight * frameHeight));
+    mCellWidth = frameWidth + 2 * ((diagonal - frameWidth + 1) / 2 + 1);
+    mCellHeight = frameHeight + 2 * ((diagonal - frameHeight + 1) / 2 + 1);
+
+    int keys = mFrameCount * mAngleCount;
+    int cells = (int)(budget / ((size_t)mCellWidth * mCellHeight * 4));
+    if (cells > keys) cells = keys;
+
+    //As square as we can, but never bigger than the renderer allows
+    SDL_RendererInfo info;
+    int maxWidth = 4096, maxHeight = 4096;
+    if (SDL_GetRendererInfo(gRenderer, &info) == 0 and info.max_texture_width > 0){
+        maxWidth = info.max_texture_width;
+        maxHeight = info.max_texture_height;
+    }
+    mColumns = (int)ceil(sqrt((double)cells));
+    if (mColumns > maxWidth / mCellWidth) mColumns = maxWidth / mCellWidth;
+    if (mColumns < 1) return false;
+    int rows = (cells + mColumns - 1) / mColumns;
+    if (rows > maxHeight / mCellHeight){
+        rows = maxHeight / mCellHeight;
+        cells = rows * mColumns;
+    }
+    if (cells <= 0) return false;
+
+    mTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, mColumns * mCellWidth, rows * mCellHeight);
+    if (mTexture == NULL){
+        printf("Unable to create the rotation cache. SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+    mRenderer = gRenderer;
+    mDraw = draw;
+    mCellKeys.assign(cells, -1);
+    mCellLastUse.assign(cells, 0);
+    mKeyCells.assign(keys, -1);
+
+    //If everything fits we draw it now, so the game never stops to draw a frame
+    if (cells == keys){
+        for (int key = 0; key < keys; key++) bake(key, key);
+    }
+    return true;
+}
+
+void RotationCache::free(){
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+    mRenderer = NULL;
+    mDraw = DrawFunction();
+    mCellKeys.clear();
+    mKeyCells.clear();
+    mCellLastUse.clear();
+    mUses = 0;
+    mBakes = 0;
+}
+
+void RotationCache::invalidate(){
+    for (size_t i = 0; i < mCellKeys.size(); i++) mCellKeys[i] = -1;
+    for (size_t i = 0; i < mKeyCells.size(); i++) mKeyCells[i] = -1;
+}
+
+void RotationCache::bake(int key, int cell){
+    SDL_Rect rect = { (cell % mColumns) * mCellWidth, (cell / mColumns) * mCellHeight, mCellWidth, mCellHeight };
+
+    //Going back to a texture target leaves the scale at 1, so we put it back too
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(mRenderer);
+    float scaleX, scaleY;
+    SDL_RenderGetScale(mRenderer, &scaleX, &scaleY);
+    SDL_SetRenderTarget(mRenderer, mTexture);
+    SDL_BlendMode previousBlend;
+    SDL_GetRenderDrawBlendMode(mRenderer, &previousBlend);
+    SDL_SetRenderDrawBlendMode(mRenderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, 0);
+    SDL_RenderFillRect(mRenderer, &rect);
+    SDL_SetRenderDrawBlendMode(mRenderer, previousBlend);
+
+    mDraw(mRenderer, key / mAngleCount, mMinDegrees + (key % mAngleCount) * mStep,
+          rect.x + (mCellWidth - mFrameWidth) / 2, rect.y + (mCellHeight - mFrameHeight) / 2);
+    SDL_SetRenderTarget(mRenderer, previousTarget);
+    SDL_RenderSetScale(mRenderer, scaleX, scaleY);
+
+    if (mCellKeys[cell] >= 0) mKeyCells[mCellKeys[cell]] = -1;
+    mCellKeys[cell] = key;
+    mKeyCells[key] = cell;
+    mBakes++;
+}
+
+bool RotationCache::render(int frame, double degrees, int x, int y){
+    if (mTexture == NULL or frame < 0 or frame >= mFrameCount) return false;
+    int angle = (int)floor((degrees - mMinDegrees) / mStep + 0.5);
+    if (angle < 0 or angle >= mAngleCount) return false;
+
+    int key = frame * mAngleCount + angle;
+    int cell = mKeyCells[key];
+    if (cell < 0){
+        //An empty cell, or else the one that has waited the longest
+        cell = 0;
+        for (size_t i = 0; i < mCellKeys.size(); i++){
+            if (mCellKeys[i] < 0){
+                cell = i;
+                break;
+            }
+            if (mCellLastUse[i] < mCellLastUse[cell]) cell = i;
+        }
+        bake(key, cell);
+    }
+    mCellLastUse[cell] = ++mUses;
+
+    SDL_Rect source = { (cell % mColumns) * mCellWidth, (cell / mColumns) * mCellHeight, mCellWidth, mCellHeight };
+    SDL_Rect destination = { x - (mCellWidth - mFrameWidth) / 2, y - (mCellHeight - mFrameHeight) / 2, mCellWidth, mCellHeight };
+    SDL_RenderCopy(mRenderer, mTexture, &source, &destination);
+    return true;
+}
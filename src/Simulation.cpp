@@ -0,0 +1,212 @@
+#include "Simulation.h"
+#include "Profiler.h"
+
+Simulation::Simulation(){
+    mRunning = false;
+    mPlaying = false;
+    mEnded = false;
+    mGame = 0;
+    mRecording = NULL;
+    mRecordPath = NULL;
+    mMasks = NULL;
+    mAutopilot = NULL;
+    mPiloting = false;
+    mBroadcast = NULL;
+    mWatching = NULL;
+    mWatchTick = 0;
+    mTicks = 0;
+    mLateTicks = 0;
+    mDroppedTicks = 0;
+    mWorstLateness = 0;
+
+    //The renderer has something to read before the first game
+    mWorld.restart(0);
+    mPrevious = mWorld;
+    mTickTime = std::chrono::steady_clock::now();
+    publish();
+    update();
+}
+
+Simulation::~Simulation(){
+    stop();
+}
+
+void Simulation::setRecording(Replay* replay, const char* recordPath){
+    mRecording = replay;
+    mRecordPath = recordPath;
+}
+
+void Simulation::setCollision(const PixelMasks* masks){
+    mMasks = masks;
+}
+
+void Simulation::setAutopilot(Autopilot* autopilot){
+    mAutopilot = autopilot;
+}
+
+void Simulation::setBroadcast(GhostServer* broadcast){
+    mBroadcast = broadcast;
+}
+
+void Simulation::watchReplay(Replay* replay, int tick, const World& world){
+    mWatching = replay;
+    mWatchTick = tick;
+    mPiloting = false;
+    mWorld = world;
+    mPrevious = world;
+    mPlaying = tick < replay->getTickCount() and !world.dead;
+    mEnded = !mPlaying;
+    mGame++;
+    mTickTime = std::chrono::steady_clock::now();
+    mNextTick = mTickTime + TICK_DURATION;
+    publish();
+}
+
+void Simulation::start(){
+    if (mRunning) return;
+    mRunning = true;
+    mThread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop(){
+    if (mRunning){
+        mRunning = false;
+        mThread.join();
+    }
+    if (mPlaying and mWatching == NULL and mRecording != NULL and mRecordPath != NULL) mRecording->save(mRecordPath);
+    mPlaying = false;
+}
+
+bool Simulation::send(const SimCommand& command){
+    return mCommands.push(command);
+}
+
+bool Simulation::update(){
+    return mSnapshots.update();
+}
+
+bool Simulation::takeAppliedInput(long long tick, AppliedInput& input){
+    if (!mApplied.peek(input) or input.tick > tick) return false;
+    mApplied.pop();
+    return true;
+}
+
+void Simulation::run(){
+    setProfileThreadName("simulation");
+    while (mRunning){
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        advance(now);
+
+        //Until the next tick is due, but a restart never waits more than a millisecond
+        std::chrono::steady_clock::time_point wake = now + std::chrono::milliseconds(1);
+        if (mPlaying and mNextTick < wake) wake = mNextTick;
+        std::this_thread::sleep_until(wake);
+    }
+}
+
+void Simulation::advance(std::chrono::steady_clock::time_point now){
+    bool changed = false;
+    SimCommand command;
+    for (;;){
+        //A restart is taken as soon as it is seen, and the ticks of the new game count from when it was asked
+        if (mCommands.peek(command) and command.type == COMMAND_RESTART){
+            mCommands.pop();
+            restartGame(command.seed, command.time);
+            changed = true;
+            continue;
+        }
+        //Flaps between games go nowhere
+        if (!mPlaying){
+            if (mCommands.peek(command) and command.type == COMMAND_FLAP){
+                mCommands.pop();
+                continue;
+            }
+            break;
+        }
+        if (mNextTick > now) break;
+
+        //After a stall we only catch up MAX_FRAME_SECONDS, the rest is dropped
+        double late = std::chrono::duration<double>(now - mNextTick).count();
+        if (late > MAX_FRAME_SECONDS){
+            long long dropped = (long long)((late - MAX_FRAME_SECONDS) / TICK_SECONDS) + 1;
+            mNextTick += dropped * TICK_DURATION;
+            mDroppedTicks += dropped;
+            continue;
+        }
+        if (late > TICK_SECONDS) mLateTicks++;
+        if (late > mWorstLateness) mWorstLateness = late;
+        PROFILE_ZONE("tick");
+
+        //Every flap that happened before this tick was due. The renderer gets them back to time them,
+        //unless the renderer isn't taking them and there is no room
+        WorldInput input = { false };
+        while (mCommands.peek(command) and command.type == COMMAND_FLAP and command.time <= mNextTick){
+            mCommands.pop();
+            input.flap = true;
+            AppliedInput applied = { command.time, now, mTicks + 1 };
+            if (mWatching == NULL and !mPiloting) mApplied.push(applied);
+        }
+
+        //The autopilot searches on the copies of this world, and the keys don't count
+        if (mPiloting) input.flap = mAutopilot->decide(mWorld);
+
+        mPrevious = mWorld;
+        if (mWatching != NULL){
+            //Watching a replay the keys don't play, the recorded flaps do
+            input = mWatching->getInput(mWatchTick);
+            mWorld.step(input);
+            if (!mWatching->check(mWatchTick, mWorld)) printf("The replay doesn't play the same since tick %d\n", mWatchTick);
+            mWatchTick++;
+            if (mWatchTick >= mWatching->getTickCount()) endGame();
+        }
+        else {
+            mWorld.step(input);
+            if (mRecording != NULL) mRecording->record(input, mWorld);
+        }
+        mTicks++;
+        if (mBroadcast != NULL) mBroadcast->publish(mWorld, (unsigned int)mTicks);
+        mTickTime = mNextTick;
+        mNextTick += TICK_DURATION;
+        if (mWorld.dead and mPlaying) endGame();
+        changed = true;
+    }
+    if (changed) publish();
+}
+
+void Simulation::restartGame(unsigned int seed, std::chrono::steady_clock::time_point now){
+    //The recording keeps which collision it was
+    mWorld.masks = mMasks;
+    mWorld.restart(seed);
+    mPrevious = mWorld;
+    if (mRecording != NULL) mRecording->start(seed, mMasks != NULL);
+    mPiloting = mAutopilot != NULL;
+    if (mPiloting) mAutopilot->reset();
+    mWatching = NULL;
+    mPlaying = true;
+    mEnded = false;
+    mGame++;
+    mTickTime = now;
+    mNextTick = now + TICK_DURATION;
+}
+
+void Simulation::endGame(){
+    if (mWatching == NULL and mRecording != NULL and mRecordPath != NULL) mRecording->save(mRecordPath);
+    mPlaying = false;
+    mEnded = true;
+}
+
+void Simulation::publish(){
+    WorldSnapshot& snapshot = mSnapshots.getBack();
+    snapshot.previous = mPrevious;
+    snapshot.current = mWorld;
+    snapshot.time = mTickTime;
+    snapshot.game = mGame;
+    snapshot.ended = mEnded;
+    snapshot.tick = mTicks;
+    mSnapshots.publish();
+}
+
+void Simulation::printStats(FILE* file) const{
+    fprintf(file, "simulation: %lld ticks, %lld started more than a tick late (the worst %.2f ms late), %lld dropped after stalls\n",
+            mTicks, mLateTicks, mWorstLateness * 1000, mDroppedTicks);
+}
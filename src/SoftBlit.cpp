@@ -0,0 +1,402 @@
+#include "SoftBlit.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define BLIT_X86 1
+#include <immintrin.h>
+#endif
+
+//M_PI isn't standard, and -std=c++11 hides it in the math.h of MinGW
+static const double PI = 3.14159265358979323846;
+
+//x / 255 rounding down, for any x up to 255 * 255. The SIMD kernels do the same on 16 bit lanes
+static inline uint32_t div255(uint32_t x){
+    x += 1;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t blendPixel(uint32_t d, uint32_t s, uint32_t alphaMod){
+    uint32_t sa = div255((s >> 24) * alphaMod);
+    uint32_t out = (sa + div255((d >> 24) * (255 - sa))) << 24;
+    for (int shift = 0; shift < 24; shift += 8){
+        uint32_t sc = (s >> shift) & 0xFF;
+        uint32_t dc = (d >> shift) & 0xFF;
+        out |= (div255(sc * sa) + div255(dc * (255 - sa))) << shift;
+    }
+    return out;
+}
+
+//Transparent outside of the image
+static inline uint32_t fetch(const PixelView& src, int x, int y){
+    if ((unsigned)x >= (unsigned)src.width or (unsigned)y >= (unsigned)src.height) return 0;
+    return src.pixels[y * src.pitch + x];
+}
+
+//Bilinear sample at (sx, sy) in 16.16 fixed point. Each direction uses 8 bit weights and drops the fraction, like the SIMD kernels
+static inline uint32_t sample(const PixelView& src, int32_t sx, int32_t sy){
+    int x0 = sx >> 16, y0 = sy >> 16;
+    uint32_t fx = (sx >> 8) & 0xFF, fy = (sy >> 8) & 0xFF;
+    uint32_t c00 = fetch(src, x0, y0), c01 = fetch(src, x0 + 1, y0);
+    uint32_t c10 = fetch(src, x0, y0 + 1), c11 = fetch(src, x0 + 1, y0 + 1);
+
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8){
+        uint32_t top = (((c00 >> shift) & 0xFF) * (256 - fx) + ((c01 >> shift) & 0xFF) * fx) >> 8;
+        uint32_t bottom = (((c10 >> shift) & 0xFF) * (256 - fx) + ((c11 >> shift) & 0xFF) * fx) >> 8;
+        out |= ((top * (256 - fy) + bottom * fy) >> 8) << shift;
+    }
+    return out;
+}
+
+//The kernels work on one row: n pixels of dst from n pixels of src, or from the samples along (sx, sy) + i * (dx, dy)
+typedef void (*KeyRow)(uint32_t* d, const uint32_t* s, int n, uint32_t key);
+typedef void (*BlendRow)(uint32_t* d, const uint32_t* s, int n, uint32_t alphaMod);
+typedef void (*RotateRow)(uint32_t* d, int n, const PixelView& src, int32_t sx, int32_t sy, int32_t dx, int32_t dy);
+
+static void keyRowScalar(uint32_t* d, const uint32_t* s, int n, uint32_t key){
+    for (int i = 0; i < n; i++){
+        if ((s[i] & 0xFFFFFF) != (key & 0xFFFFFF)) d[i] = s[i];
+    }
+}
+
+static void blendRowScalar(uint32_t* d, const uint32_t* s, int n, uint32_t alphaMod){
+    for (int i = 0; i < n; i++) d[i] = blendPixel(d[i], s[i], alphaMod);
+}
+
+static void rotateRowScalar(uint32_t* d, int n, const PixelView& src, int32_t sx, int32_t sy, int32_t dx, int32_t dy){
+    for (int i = 0; i < n; i++, sx += dx, sy += dy) d[i] = blendPixel(d[i], sample(src, sx, sy), 255);
+}
+
+#ifdef BLIT_X86
+
+__attribute__((target("sse2")))
+static inline __m128i div255SSE2(__m128i x){
+    x = _mm_add_epi16(x, _mm_set1_epi16(1));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+//Two pixels spread on 16 bit lanes (B, G, R, A each), blended with their own alpha
+__attribute__((target("sse2")))
+static inline __m128i blendHalfSSE2(__m128i d, __m128i s, __m128i alphaMod){
+    const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = div255SSE2(_mm_mullo_epi16(a, alphaMod));
+
+    //The colors are multiplied by alpha, and the alpha lane is alpha itself
+    __m128i source = div255SSE2(_mm_mullo_epi16(s, a));
+    source = _mm_or_si128(_mm_andnot_si128(alphaLanes, source), _mm_and_si128(alphaLanes, a));
+    __m128i kept = div255SSE2(_mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a)));
+    return _mm_add_epi16(source, kept);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i blend4SSE2(__m128i d, __m128i s, __m128i alphaMod){
+    const __m128i zero = _mm_setzero_si128();
+    __m128i low = blendHalfSSE2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), alphaMod);
+    __m128i high = blendHalfSSE2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), alphaMod);
+    return _mm_packus_epi16(low, high);
+}
+
+__attribute__((target("sse2")))
+static void keyRowSSE2(uint32_t* d, const uint32_t* s, int n, uint32_t key){
+    const __m128i colorMask = _mm_set1_epi32(0xFFFFFF);
+    const __m128i keyColor = _mm_set1_epi32(key & 0xFFFFFF);
+    int i = 0;
+    for (; i + 4 <= n; i += 4){
+        __m128i source = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i destination = _mm_loadu_si128((const __m128i*)(d + i));
+        __m128i keyed = _mm_cmpeq_epi32(_mm_and_si128(source, colorMask), keyColor);
+        _mm_storeu_si128((__m128i*)(d + i), _mm_or_si128(_mm_and_si128(keyed, destination), _mm_andnot_si128(keyed, source)));
+    }
+    keyRowScalar(d + i, s + i, n - i, key);
+}
+
+__attribute__((target("sse2")))
+static void blendRowSSE2(uint32_t* d, const uint32_t* s, int n, uint32_t alphaMod){
+    const __m128i mod = _mm_set1_epi16(alphaMod);
+    int i = 0;
+    for (; i + 4 <= n; i += 4){
+        __m128i source = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i destination = _mm_loadu_si128((const __m128i*)(d + i));
+        _mm_storeu_si128((__m128i*)(d + i), blend4SSE2(destination, source, mod));
+    }
+    blendRowScalar(d + i, s + i, n - i, alphaMod);
+}
+
+//Each pixel's 8 bit weight in its four 16 bit lanes, in the order that unpacklo/unpackhi_epi8 leave the pixels
+__attribute__((target("sse2")))
+static inline void spreadWeightsSSE2(__m128i weights, __m128i& low, __m128i& high){
+    weights = _mm_or_si128(weights, _mm_slli_epi32(weights, 16));
+    low = _mm_unpacklo_epi32(weights, weights);
+    high = _mm_unpackhi_epi32(weights, weights);
+}
+
+//(a * (256 - f) + b * f) >> 8 on 16 bit lanes. It never overflows: it is at most 255 * 256
+__attribute__((target("sse2")))
+static inline __m128i lerpSSE2(__m128i a, __m128i b, __m128i f){
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, _mm_sub_epi16(_mm_set1_epi16(256), f)), _mm_mullo_epi16(b, f));
+    return _mm_srli_epi16(sum, 8);
+}
+
+//Four bilinear samples from their texels and weights
+__attribute__((target("sse2")))
+static inline __m128i bilinear4SSE2(__m128i c00, __m128i c01, __m128i c10, __m128i c11, __m128i fx, __m128i fy){
+    const __m128i zero = _mm_setzero_si128();
+    __m128i fxLow, fxHigh, fyLow, fyHigh;
+    spreadWeightsSSE2(fx, fxLow, fxHigh);
+    spreadWeightsSSE2(fy, fyLow, fyHigh);
+
+    __m128i topLow = lerpSSE2(_mm_unpacklo_epi8(c00, zero), _mm_unpacklo_epi8(c01, zero), fxLow);
+    __m128i bottomLow = lerpSSE2(_mm_unpacklo_epi8(c10, zero), _mm_unpacklo_epi8(c11, zero), fxLow);
+    __m128i topHigh = lerpSSE2(_mm_unpackhi_epi8(c00, zero), _mm_unpackhi_epi8(c01, zero), fxHigh);
+    __m128i bottomHigh = lerpSSE2(_mm_unpackhi_epi8(c10, zero), _mm_unpackhi_epi8(c11, zero), fxHigh);
+    return _mm_packus_epi16(lerpSSE2(topLow, bottomLow, fyLow), lerpSSE2(topHigh, bottomHigh, fyHigh));
+}
+
+//SSE2 can't gather, so the texels are read one by one and only the math goes 4 pixels at a time
+__attribute__((target("sse2")))
+static void rotateRowSSE2(uint32_t* d, int n, const PixelView& src, int32_t sx, int32_t sy, int32_t dx, int32_t dy){
+    const __m128i mod = _mm_set1_epi16(255);
+    int i = 0;
+    for (; i + 4 <= n; i += 4){
+        uint32_t t00[4], t01[4], t10[4], t11[4];
+        int32_t fx[4], fy[4];
+        for (int k = 0; k < 4; k++){
+            int32_t x = sx + k * dx, y = sy + k * dy;
+            int x0 = x >> 16, y0 = y >> 16;
+            t00[k] = fetch(src, x0, y0);
+            t01[k] = fetch(src, x0 + 1, y0);
+            t10[k] = fetch(src, x0, y0 + 1);
+            t11[k] = fetch(src, x0 + 1, y0 + 1);
+            fx[k] = (x >> 8) & 0xFF;
+            fy[k] = (y >> 8) & 0xFF;
+        }
+        __m128i sampled = bilinear4SSE2(_mm_loadu_si128((const __m128i*)t00), _mm_loadu_si128((const __m128i*)t01),
+                                        _mm_loadu_si128((const __m128i*)t10), _mm_loadu_si128((const __m128i*)t11),
+                                        _mm_loadu_si128((const __m128i*)fx), _mm_loadu_si128((const __m128i*)fy));
+        __m128i destination = _mm_loadu_si128((const __m128i*)(d + i));
+        _mm_storeu_si128((__m128i*)(d + i), blend4SSE2(destination, sampled, mod));
+        sx += 4 * dx;
+        sy += 4 * dy;
+    }
+    rotateRowScalar(d + i, n - i, src, sx, sy, dx, dy);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i div255AVX2(__m256i x){
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(1));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i blendHalfAVX2(__m256i d, __m256i s, __m256i alphaMod){
+    const __m256i alphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    a = div255AVX2(_mm256_mullo_epi16(a, alphaMod));
+
+    __m256i source = div255AVX2(_mm256_mullo_epi16(s, a));
+    source = _mm256_blendv_epi8(source, a, alphaLanes);
+    __m256i kept = div255AVX2(_mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a)));
+    return _mm256_add_epi16(source, kept);
+}
+
+//The unpacks and the pack stay inside each 128 bit half, so the pixels come back in their order
+__attribute__((target("avx2")))
+static inline __m256i blend8AVX2(__m256i d, __m256i s, __m256i alphaMod){
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i low = blendHalfAVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero), alphaMod);
+    __m256i high = blendHalfAVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero), alphaMod);
+    return _mm256_packus_epi16(low, high);
+}
+
+__attribute__((target("avx2")))
+static void keyRowAVX2(uint32_t* d, const uint32_t* s, int n, uint32_t key){
+    const __m256i colorMask = _mm256_set1_epi32(0xFFFFFF);
+    const __m256i keyColor = _mm256_set1_epi32(key & 0xFFFFFF);
+    int i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m256i source = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i destination = _mm256_loadu_si256((const __m256i*)(d + i));
+        __m256i keyed = _mm256_cmpeq_epi32(_mm256_and_si256(source, colorMask), keyColor);
+        _mm256_storeu_si256((__m256i*)(d + i), _mm256_blendv_epi8(source, destination, keyed));
+    }
+    keyRowScalar(d + i, s + i, n - i, key);
+}
+
+__attribute__((target("avx2")))
+static void blendRowAVX2(uint32_t* d, const uint32_t* s, int n, uint32_t alphaMod){
+    const __m256i mod = _mm256_set1_epi16(alphaMod);
+    int i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m256i source = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i destination = _mm256_loadu_si256((const __m256i*)(d + i));
+        _mm256_storeu_si256((__m256i*)(d + i), blend8AVX2(destination, source, mod));
+    }
+    blendRowScalar(d + i, s + i, n - i, alphaMod);
+}
+
+__attribute__((target("avx2")))
+static inline void spreadWeightsAVX2(__m256i weights, __m256i& low, __m256i& high){
+    weights = _mm256_or_si256(weights, _mm256_slli_epi32(weights, 16));
+    low = _mm256_unpacklo_epi32(weights, weights);
+    high = _mm256_unpackhi_epi32(weights, weights);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i lerpAVX2(__m256i a, __m256i b, __m256i f){
+    __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(a, _mm256_sub_epi16(_mm256_set1_epi16(256), f)), _mm256_mullo_epi16(b, f));
+    return _mm256_srli_epi16(sum, 8);
+}
+
+//The texel at (x, y) of every lane, or 0 where it is outside of the image
+__attribute__((target("avx2")))
+static inline __m256i gatherAVX2(const PixelView& src, __m256i x, __m256i y){
+    __m256i inside = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(x, _mm256_set1_epi32(-1)), _mm256_cmpgt_epi32(_mm256_set1_epi32(src.width), x)),
+                                      _mm256_and_si256(_mm256_cmpgt_epi32(y, _mm256_set1_epi32(-1)), _mm256_cmpgt_epi32(_mm256_set1_epi32(src.height), y)));
+    __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, _mm256_set1_epi32(src.pitch)), x);
+    return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), (const int*)src.pixels, index, inside, 4);
+}
+
+__attribute__((target("avx2")))
+static void rotateRowAVX2(uint32_t* d, int n, const PixelView& src, int32_t sx, int32_t sy, int32_t dx, int32_t dy){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i weightMask = _mm256_set1_epi32(0xFF);
+    const __m256i mod = _mm256_set1_epi16(255);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m256i x = _mm256_add_epi32(_mm256_set1_epi32(sx), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dx)));
+        __m256i y = _mm256_add_epi32(_mm256_set1_epi32(sy), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dy)));
+        __m256i x0 = _mm256_srai_epi32(x, 16), y0 = _mm256_srai_epi32(y, 16);
+        __m256i x1 = _mm256_add_epi32(x0, one), y1 = _mm256_add_epi32(y0, one);
+
+        __m256i fxLow, fxHigh, fyLow, fyHigh;
+        spreadWeightsAVX2(_mm256_and_si256(_mm256_srai_epi32(x, 8), weightMask), fxLow, fxHigh);
+        spreadWeightsAVX2(_mm256_and_si256(_mm256_srai_epi32(y, 8), weightMask), fyLow, fyHigh);
+
+        __m256i c00 = gatherAVX2(src, x0, y0), c01 = gatherAVX2(src, x1, y0);
+        __m256i c10 = gatherAVX2(src, x0, y1), c11 = gatherAVX2(src, x1, y1);
+        __m256i topLow = lerpAVX2(_mm256_unpacklo_epi8(c00, zero), _mm256_unpacklo_epi8(c01, zero), fxLow);
+        __m256i bottomLow = lerpAVX2(_mm256_unpacklo_epi8(c10, zero), _mm256_unpacklo_epi8(c11, zero), fxLow);
+        __m256i topHigh = lerpAVX2(_mm256_unpackhi_epi8(c00, zero), _mm256_unpackhi_epi8(c01, zero), fxHigh);
+        __m256i bottomHigh = lerpAVX2(_mm256_unpackhi_epi8(c10, zero), _mm256_unpackhi_epi8(c11, zero), fxHigh);
+        __m256i sampled = _mm256_packus_epi16(lerpAVX2(topLow, bottomLow, fyLow), lerpAVX2(topHigh, bottomHigh, fyHigh));
+
+        __m256i destination = _mm256_loadu_si256((const __m256i*)(d + i));
+        _mm256_storeu_si256((__m256i*)(d + i), blend8AVX2(destination, sampled, mod));
+        sx += 8 * dx;
+        sy += 8 * dy;
+    }
+    rotateRowScalar(d + i, n - i, src, sx, sy, dx, dy);
+}
+
+bool blitKernelSupported(BlitKernel kernel){
+    __builtin_cpu_init();
+    if (kernel == BLIT_AVX2) return __builtin_cpu_supports("avx2");
+    if (kernel == BLIT_SSE2) return __builtin_cpu_supports("sse2");
+    return true;
+}
+
+static const KeyRow KEY_ROWS[] = { keyRowScalar, keyRowSSE2, keyRowAVX2 };
+static const BlendRow BLEND_ROWS[] = { blendRowScalar, blendRowSSE2, blendRowAVX2 };
+static const RotateRow ROTATE_ROWS[] = { rotateRowScalar, rotateRowSSE2, rotateRowAVX2 };
+
+#else
+
+//Without x86 intrinsics the SIMD kernels are just the scalar one
+bool blitKernelSupported(BlitKernel kernel){
+    return kernel == BLIT_SCALAR;
+}
+
+static const KeyRow KEY_ROWS[] = { keyRowScalar, keyRowScalar, keyRowScalar };
+static const BlendRow BLEND_ROWS[] = { blendRowScalar, blendRowScalar, blendRowScalar };
+static const RotateRow ROTATE_ROWS[] = { rotateRowScalar, rotateRowScalar, rotateRowScalar };
+
+#endif
+
+static BlitKernel chooseBlitKernel(){
+    if (blitKernelSupported(BLIT_AVX2)) return BLIT_AVX2;
+    if (blitKernelSupported(BLIT_SSE2)) return BLIT_SSE2;
+    return BLIT_SCALAR;
+}
+
+//We look at the CPU only once, the first time somebody asks
+BlitKernel getBlitKernel(){
+    static const BlitKernel kernel = chooseBlitKernel();
+    return kernel;
+}
+
+const char* getBlitKernelName(BlitKernel kernel){
+    switch (kernel){
+        case BLIT_AVX2: return "avx2";
+        case BLIT_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+//The part of src at (x, y) that falls inside dst. Returns false if nothing does
+static bool clipBlit(const PixelView& dst, int& x, int& y, PixelView& src){
+    int left = x < 0 ? -x : 0, top = y < 0 ? -y : 0;
+    int right = x + src.width > dst.width ? x + src.width - dst.width : 0;
+    int bottom = y + src.height > dst.height ? y + src.height - dst.height : 0;
+    int w = src.width - left - right, h = src.height - top - bottom;
+    if (w <= 0 or h <= 0) return false;
+    src = subView(src, left, top, w, h);
+    x += left;
+    y += top;
+    return true;
+}
+
+void blitCopy(const PixelView& dst, int x, int y, const PixelView& src){
+    PixelView clipped = src;
+    if (!clipBlit(dst, x, y, clipped)) return;
+    for (int row = 0; row < clipped.height; row++)
+        memcpy(dst.pixels + (y + row) * dst.pitch + x, clipped.pixels + row * clipped.pitch, clipped.width * sizeof(uint32_t));
+}
+
+void blitColorKey(const PixelView& dst, int x, int y, const PixelView& src, uint32_t key, BlitKernel kernel){
+    PixelView clipped = src;
+    if (!clipBlit(dst, x, y, clipped)) return;
+    KeyRow keyRow = KEY_ROWS[kernel];
+    for (int row = 0; row < clipped.height; row++)
+        keyRow(dst.pixels + (y + row) * dst.pitch + x, clipped.pixels + row * clipped.pitch, clipped.width, key);
+}
+
+void blitBlend(const PixelView& dst, int x, int y, const PixelView& src, uint8_t alphaMod, BlitKernel kernel){
+    PixelView clipped = src;
+    if (alphaMod == 0 or !clipBlit(dst, x, y, clipped)) return;
+    BlendRow blendRow = BLEND_ROWS[kernel];
+    for (int row = 0; row < clipped.height; row++)
+        blendRow(dst.pixels + (y + row) * dst.pitch + x, clipped.pixels + row * clipped.pitch, clipped.width, alphaMod);
+}
+
+void blitRotated(const PixelView& dst, int x, int y, const PixelView& src, double degrees, BlitKernel kernel){
+    double radians = degrees * PI / 180.0;
+    double c = cos(radians), s = sin(radians);
+    double halfWidth = src.width / 2.0, halfHeight = src.height / 2.0;
+    double centerX = x + halfWidth, centerY = y + halfHeight;
+
+    //The box where the rotated image lands, inside dst
+    double extentX = fabs(c) * halfWidth + fabs(s) * halfHeight;
+    double extentY = fabs(s) * halfWidth + fabs(c) * halfHeight;
+    int left = (int)floor(centerX - extentX) - 1, right = (int)ceil(centerX + extentX) + 1;
+    int top = (int)floor(centerY - extentY) - 1, bottom = (int)ceil(centerY + extentY) + 1;
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    if (right > dst.width) right = dst.width;
+    if (bottom > dst.height) bottom = dst.height;
+    if (left >= right or top >= bottom) return;
+
+    //Going one pixel right on the screen goes (c, -s) on the image. Every kernel gets the same start of row in 16.16,
+    //so they all sample the same places
+    int32_t dx = (int32_t)lround(c * 65536.0), dy = (int32_t)lround(-s * 65536.0);
+    RotateRow rotateRow = ROTATE_ROWS[kernel];
+    for (int row = top; row < bottom; row++){
+        double u = left + 0.5 - centerX, v = row + 0.5 - centerY;
+        double sourceX = c * u + s * v + halfWidth - 0.5;
+        double sourceY = -s * u + c * v + halfHeight - 0.5;
+        rotateRow(dst.pixels + row * dst.pitch + left, right - left, src, (int32_t)lround(sourceX * 65536.0), (int32_t)lround(sourceY * 65536.0), dx, dy);
+    }
+}
@@ -0,0 +1,95 @@
+#include "SoftCanvas.h"
+#include <stdio.h>
+#include <string.h>
+
+SoftImage::SoftImage(){
+    mView.pixels = NULL;
+    mView.width = 0;
+    mView.height = 0;
+    mView.pitch = 0;
+}
+
+bool SoftImage::loadFromSurface(SDL_Surface* surface){
+    free();
+    //The converted copy turns a color key into alpha, like the textures do
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (converted == NULL){
+        printf("Unable to convert an image for the software blitter. SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    create(converted->w, converted->h, 0);
+    SDL_LockSurface(converted);
+    for (int y = 0; y < converted->h; y++)
+        memcpy(&mPixels[y * mView.pitch], (Uint8*)converted->pixels + y * converted->pitch, converted->w * sizeof(Uint32));
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+    return true;
+}
+
+void SoftImage::create(int width, int height, Uint32 argb){
+    mPixels.assign((size_t)width * height, argb);
+    mView.pixels = mPixels.data();
+    mView.width = width;
+    mView.height = height;
+    mView.pitch = width;
+}
+
+void SoftImage::free(){
+    std::vector<Uint32>().swap(mPixels);
+    mView.pixels = NULL;
+    mView.width = 0;
+    mView.height = 0;
+    mView.pitch = 0;
+}
+
+PixelView SoftImage::getRect(const SDL_Rect& rect) const{
+    return subView(mView, rect.x, rect.y, rect.w, rect.h);
+}
+
+SoftCanvas::SoftCanvas(){
+    mRenderer = NULL;
+    mTexture = NULL;
+}
+
+SoftCanvas::~SoftCanvas(){
+    free();
+}
+
+bool SoftCanvas::create(SDL_Renderer* gRenderer, int width, int height){
+    free();
+    mTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (mTexture == NULL){
+        printf("Unable to create the canvas texture. SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    //Every pixel of the canvas is already the final color, so it is copied without blending
+    SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_NONE);
+    mRenderer = gRenderer;
+    mCanvas.create(width, height, 0xFF000000);
+    return true;
+}
+
+void SoftCanvas::free(){
+    if (mTexture != NULL){
+        SDL_DestroyTexture(mTexture);
+        mTexture = NULL;
+    }
+    mRenderer = NULL;
+    mCanvas.free();
+}
+
+void SoftCanvas::render(const std::vector<SDL_Rect>* regions){
+    if (mTexture == NULL) return;
+    const PixelView& view = mCanvas.getView();
+    if (regions == NULL){
+        SDL_UpdateTexture(mTexture, NULL, view.pixels, view.pitch * sizeof(Uint32));
+        SDL_RenderCopy(mRenderer, mTexture, NULL, NULL);
+        return;
+    }
+    for (size_t i = 0; i < regions->size(); i++){
+        const SDL_Rect& rect = (*regions)[i];
+        SDL_UpdateTexture(mTexture, &rect, view.pixels + rect.y * view.pitch + rect.x, view.pitch * sizeof(Uint32));
+        SDL_RenderCopy(mRenderer, mTexture, &rect, &rect);
+    }
+}
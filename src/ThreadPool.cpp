@@ -0,0 +1,118 @@
+#include "ThreadPool.h"
+#include <stdio.h>
+#include "Profiler.h"
+
+ThreadPool::ThreadPool(int threads){
+    mQueued = 0;
+    mPending = 0;
+    mNextWorker = 0;
+    mQuit = false;
+
+    if (threads <= 0) threads = std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    for (int i = 0; i < threads; i++) mWorkers.push_back(new Worker());
+    for (int i = 0; i < threads; i++) mThreads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool(){
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mQuit = true;
+    }
+    mSleep.notify_all();
+    for (size_t i = 0; i < mThreads.size(); i++) mThreads[i].join();
+    for (size_t i = 0; i < mWorkers.size(); i++) delete mWorkers[i];
+}
+
+void ThreadPool::submit(std::function<void()> task){
+    Worker* worker = mWorkers[mNextWorker++ % mWorkers.size()];
+    ++mPending;
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->tasks.push_back(task);
+    }
+    ++mQueued;
+
+    //Taking the lock makes sure a worker that is about to sleep sees the new task
+    { std::lock_guard<std::mutex> lock(mSleepMutex); }
+    mSleep.notify_one();
+}
+
+bool ThreadPool::popTask(int index, std::function<void()>& task){
+    int count = mWorkers.size();
+    for (int k = 0; k < count; k++){
+        Worker* worker = mWorkers[(index + k) % count];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if (worker->tasks.empty()) continue;
+
+        //Our own queue is used from the front, the stolen ones from the back
+        if (k == 0){
+            task = worker->tasks.front();
+            worker->tasks.pop_front();
+        }else{
+            task = worker->tasks.back();
+            worker->tasks.pop_back();
+        }
+        --mQueued;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::finishTask(){
+    if (--mPending == 0){
+        { std::lock_guard<std::mutex> lock(mSleepMutex); }
+        mDone.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop(int index){
+    char name[32];
+    snprintf(name, sizeof(name), "worker %d", index);
+    setProfileThreadName(name);
+
+    std::function<void()> task;
+    while (true){
+        if (popTask(index, task)){
+            task();
+            task = NULL;
+            finishTask();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleep.wait(lock, [this]{ return mQuit or mQueued > 0; });
+        if (mQuit and mQueued == 0) return;
+    }
+}
+
+void ThreadPool::wait(){
+    std::function<void()> task;
+    while (mPending > 0){
+        if (popTask(0, task)){
+            task();
+            task = NULL;
+            finishTask();
+            continue;
+        }
+
+        //Everything left is already running on a worker
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mDone.wait(lock, [this]{ return mPending == 0 or mQueued > 0; });
+    }
+}
+
+void ThreadPool::parallelFor(int count, int grain, const std::function<void(int, int)>& body){
+    if (grain < 1) grain = 1;
+    for (int begin = 0; begin < count; begin += grain){
+        int end = begin + grain < count ? begin + grain : count;
+        submit([&body, begin, end]{ body(begin, end); });
+    }
+    wait();
+}
+
+int ThreadPool::getThreadCount(){
+    return mThreads.size();
+}
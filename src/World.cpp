@@ -0,0 +1,148 @@
+#include "World.h"
+#include "Collision.h"
+#include "CollisionMask.h"
+#include <stddef.h>
+
+World::World(){
+    masks = NULL;
+}
+
+//This reset the data to restart the game
+void World::restart(unsigned int newSeed){
+    seed = newSeed;
+    dead = false;
+
+    //Handler of the points counting
+    points = 0;
+
+    //This is going to handle the movement
+    frame = 0;
+
+    //This is going to rotate our character, enhancing the animation
+    degrees = EGG_FLAP_DEGREES;
+
+    //This tell us when we need to do the flying(> 0) or falling (< 0) animation and the movement
+    flying = MAXIMUN_FRAMES * 4 * 2;
+
+    //Handler of the character's Y position
+    posY = (SCREEN_HEIGHT - CHARACTER_SIZE)/2;
+
+    //This is how we handle the spawns of out pipes
+    timingPipe = MAX_TIME_PIPE;
+
+    //This is how we handle the current position of each pipe. There is only one at the start
+    pipes.clear();
+    Pipe& first = pipes.push();
+    first.xPosition = SCREEN_WIDTH;
+    first.freeSpotPosition = nextFreeSpot(seed);
+    first.pointCounted = false;
+}
+
+void World::step(const WorldInput& input){
+    if (dead) return;
+
+    //Our egg is going to fly!!
+    if (input.flap){
+        flying = MAXIMUN_FRAMES * 4 * 2;
+        degrees = EGG_FLAP_DEGREES;
+    }
+
+    //This is how we spawn new pipes. We reset the timer, put the pipe at the end of the Screen and select the random free spot
+    if (timingPipe == 0){
+        timingPipe = MAX_TIME_PIPE;
+        Pipe& pipe = pipes.push();
+        pipe.xPosition = SCREEN_WIDTH;
+        pipe.freeSpotPosition = nextFreeSpot(seed);
+        pipe.pointCounted = false;
+    }
+
+    --timingPipe;
+
+    for (int i = 0; i < pipes.size(); i++){
+        Pipe& pipe = pipes[i];
+        //Here we are going to count the points. When the pipe past the character position, we flag it as counted and increment the points
+        if (pipe.xPosition < CHARACTER_X_POS and !pipe.pointCounted){
+            points++;
+            pipe.pointCounted = true;
+        }
+
+        //And it keeps moving to the left
+        pipe.xPosition -= PIPE_SPEED;
+    }
+
+    //A pipe that has left the screen can't be hit or counted anymore, so it goes
+    while (!pipes.empty() and pipes[0].xPosition + PIPE_WIDTH <= 0) pipes.popFront();
+
+    //Now we check the egg against the pipes: pixel by pixel if we have the masks, and else against the top and bottom span of every pipe
+    if (masks != NULL){
+        if (pixelsHitCharacter(*masks, pipes, frame / 4, degrees, posY)) dead = true;
+    }
+    else {
+        SegmentList segments;
+        buildPipeSegments(pipes, segments);
+        if (segmentsHitCharacter(segments, posY)) dead = true;
+    }
+
+    //This case is when our egg if falling. We accelerate until reaching the maximum speed (15px), we rotate the animation and we set the position
+    if (flying < 0 ){
+        if (flying > -EGG_MAX_FALL_SPEED)
+            flying = flying * EGG_FALL_ACCELERATION;
+        if (degrees <= EGG_MAX_DEGREES - EGG_TURN_DEGREES ) degrees += EGG_TURN_DEGREES;
+        if (posY <= SCREEN_HEIGHT - FLOOR_HEIGHT - CHARACTER_SIZE + flying )
+            posY -= flying;
+        else {
+            posY = SCREEN_HEIGHT - FLOOR_HEIGHT - CHARACTER_SIZE;
+            //YOU'VE LOST, BABY!
+            dead = true;
+        }
+    }
+
+    //This case is when we stop flying and start falling
+    if (flying == 0){
+        flying = -1;
+        degrees = 0;
+    }
+
+    //This case is when we are flying. We rotate the animation, set the frame and fly a little bit
+    if (flying > 0){
+        degrees = EGG_FLAP_DEGREES;
+        --flying;
+        ++frame;
+        if (posY > CHARACTER_MOVEMENT) posY -= CHARACTER_MOVEMENT;
+        if (frame/4 >= MAXIMUN_FRAMES) frame = 0;
+    }
+    else frame = 0;
+}
+
+//FNV-1a, field by field so the padding of the struct doesn't count
+static void hashBytes(unsigned int& hash, const void* data, size_t size){
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++){
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+}
+
+static void hashInt(unsigned int& hash, int value){
+    hashBytes(hash, &value, sizeof(value));
+}
+
+unsigned int World::checksum() const{
+    unsigned int hash = 2166136261u;
+    hashInt(hash, frame);
+    hashBytes(hash, &degrees, sizeof(degrees));
+    hashBytes(hash, &flying, sizeof(flying));
+    hashInt(hash, posY);
+    hashInt(hash, timingPipe);
+    hashInt(hash, points);
+    hashInt(hash, dead);
+    hashInt(hash, seed);
+    //Only the pipes that are alive, in order, wherever they are in the ring
+    hashInt(hash, pipes.size());
+    for (int i = 0; i < pipes.size(); i++){
+        hashInt(hash, pipes[i].xPosition);
+        hashInt(hash, pipes[i].freeSpotPosition);
+        hashInt(hash, pipes[i].pointCounted);
+    }
+    return hash;
+}
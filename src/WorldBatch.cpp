@@ -0,0 +1,198 @@
+#include "WorldBatch.h"
+#include "CollisionMask.h"
+#include <chrono>
+
+WorldBatch::WorldBatch(int worldCount, const PixelMasks* masks) :
+    frame(worldCount), degrees(worldCount), flying(worldCount), posY(worldCount),
+    timingPipe(worldCount), points(worldCount), dead(worldCount), seed(worldCount),
+    pipeFirst(worldCount), pipeCount(worldCount),
+    pipeX(worldCount * MAX_PIPES), pipeFree(worldCount * MAX_PIPES), pipeCounted(worldCount * MAX_PIPES),
+    mSegments(worldCount), mHits(worldCount)
+{
+    mMasks = masks;
+    mCount = worldCount;
+    mTotalTicks = 0;
+    mTotalSeconds = 0;
+    restartAll(0);
+}
+
+void WorldBatch::restart(int index, unsigned int newSeed){
+    World world;
+    world.restart(newSeed);
+    setWorld(index, world);
+}
+
+void WorldBatch::restartAll(unsigned int firstSeed){
+    for (int w = 0; w < mCount; w++) restart(w, firstSeed + w);
+}
+
+//These are the same rules as World::step, written over the arrays so each world only touches its own slots.
+//We go over the range three times: pipes first, then the collision of every egg at once, and the egg physics at the end.
+//With the pixel masks the collision goes in the first pass instead
+void WorldBatch::stepRange(int begin, int end, const WorldInput* inputs){
+    const PixelMasks* masks = mMasks;
+    for (int w = begin; w < end; w++){
+        //A dead world has nothing to test
+        if (dead[w]){
+            mSegments[w].count = 0;
+            continue;
+        }
+
+        int* x = &pipeX[w * MAX_PIPES];
+        int* free = &pipeFree[w * MAX_PIPES];
+        unsigned char* counted = &pipeCounted[w * MAX_PIPES];
+
+        //Our egg is going to fly!!
+        if (inputs != NULL and inputs[w].flap){
+            flying[w] = MAXIMUN_FRAMES * 4 * 2;
+            degrees[w] = EGG_FLAP_DEGREES;
+        }
+
+        //The spawn of the pipes, at the back of the ring
+        if (timingPipe[w] == 0){
+            if (pipeCount[w] == MAX_PIPES){
+                pipeFirst[w] = (pipeFirst[w] + 1) % MAX_PIPES;
+                pipeCount[w]--;
+            }
+            int next = (pipeFirst[w] + pipeCount[w]) % MAX_PIPES;
+            timingPipe[w] = MAX_TIME_PIPE;
+            x[next] = SCREEN_WIDTH;
+            free[next] = nextFreeSpot(seed[w]);
+            counted[next] = false;
+            pipeCount[w]++;
+        }
+
+        --timingPipe[w];
+
+        //Every slot that is alive, in the order of the ring. The segments get them one after another
+        int aliveX[MAX_PIPES];
+        int aliveFree[MAX_PIPES];
+        for (int i = 0; i < pipeCount[w]; i++){
+            int slot = (pipeFirst[w] + i) % MAX_PIPES;
+            if (x[slot] < CHARACTER_X_POS and !counted[slot]){
+                points[w]++;
+                counted[slot] = true;
+            }
+            x[slot] -= PIPE_SPEED;
+            aliveX[i] = x[slot];
+            aliveFree[i] = free[slot];
+        }
+
+        //The ones that have left the screen go
+        int gone = 0;
+        while (pipeCount[w] > 0 and x[pipeFirst[w]] + PIPE_WIDTH <= 0){
+            pipeFirst[w] = (pipeFirst[w] + 1) % MAX_PIPES;
+            pipeCount[w]--;
+            gone++;
+        }
+
+        if (masks != NULL) mHits[w] = pixelsHitCharacter(*masks, aliveX + gone, aliveFree + gone, pipeCount[w], frame[w] / 4, degrees[w], posY[w]);
+        else buildPipeSegments(aliveX + gone, aliveFree + gone, pipeCount[w], mSegments[w]);
+    }
+
+    if (masks == NULL) segmentsHitCharacters(&mSegments[begin], &posY[begin], end - begin, &mHits[begin]);
+
+    for (int w = begin; w < end; w++){
+        if (dead[w]) continue;
+
+        double fly = flying[w];
+        double deg = degrees[w];
+        int y = posY[w];
+        bool hit = mHits[w];
+
+        //Falling
+        if (fly < 0){
+            if (fly > -EGG_MAX_FALL_SPEED)
+                fly = fly * EGG_FALL_ACCELERATION;
+            if (deg <= EGG_MAX_DEGREES - EGG_TURN_DEGREES) deg += EGG_TURN_DEGREES;
+            if (y <= SCREEN_HEIGHT - FLOOR_HEIGHT - CHARACTER_SIZE + fly)
+                y -= fly;
+            else {
+                y = SCREEN_HEIGHT - FLOOR_HEIGHT - CHARACTER_SIZE;
+                hit = true;
+            }
+        }
+
+        //From flying to falling
+        if (fly == 0){
+            fly = -1;
+            deg = 0;
+        }
+
+        //Flying
+        if (fly > 0){
+            deg = EGG_FLAP_DEGREES;
+            --fly;
+            ++frame[w];
+            if (y > CHARACTER_MOVEMENT) y -= CHARACTER_MOVEMENT;
+            if (frame[w]/4 >= MAXIMUN_FRAMES) frame[w] = 0;
+        }
+        else frame[w] = 0;
+
+        flying[w] = fly;
+        degrees[w] = deg;
+        posY[w] = y;
+        if (hit) dead[w] = true;
+    }
+}
+
+void WorldBatch::step(const WorldInput* inputs, ThreadPool& pool){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    pool.parallelFor(mCount, GRAIN, [this, inputs](int begin, int end){ stepRange(begin, end, inputs); });
+
+    mTotalSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    mTotalTicks += mCount;
+}
+
+World WorldBatch::getWorld(int index) const{
+    World world;
+    world.masks = mMasks;
+    world.frame = frame[index];
+    world.degrees = degrees[index];
+    world.flying = flying[index];
+    world.posY = posY[index];
+    world.timingPipe = timingPipe[index];
+    world.points = points[index];
+    world.dead = dead[index];
+    world.seed = seed[index];
+    world.pipes.first = pipeFirst[index];
+    world.pipes.count = pipeCount[index];
+    for (int i = 0; i < MAX_PIPES; i++){
+        world.pipes.items[i].xPosition = pipeX[index * MAX_PIPES + i];
+        world.pipes.items[i].freeSpotPosition = pipeFree[index * MAX_PIPES + i];
+        world.pipes.items[i].pointCounted = pipeCounted[index * MAX_PIPES + i];
+    }
+    return world;
+}
+
+void WorldBatch::setWorld(int index, const World& world){
+    frame[index] = world.frame;
+    degrees[index] = world.degrees;
+    flying[index] = world.flying;
+    posY[index] = world.posY;
+    timingPipe[index] = world.timingPipe;
+    points[index] = world.points;
+    dead[index] = world.dead;
+    seed[index] = world.seed;
+    pipeFirst[index] = world.pipes.first;
+    pipeCount[index] = world.pipes.count;
+    for (int i = 0; i < MAX_PIPES; i++){
+        pipeX[index * MAX_PIPES + i] = world.pipes.items[i].xPosition;
+        pipeFree[index * MAX_PIPES + i] = world.pipes.items[i].freeSpotPosition;
+        pipeCounted[index * MAX_PIPES + i] = world.pipes.items[i].pointCounted;
+    }
+}
+
+int WorldBatch::size() const{
+    return mCount;
+}
+
+double WorldBatch::getTicksPerSecond() const{
+    if (mTotalSeconds <= 0) return 0;
+    return mTotalTicks / mTotalSeconds;
+}
+
+long long WorldBatch::getTotalTicks() const{
+    return mTotalTicks;
+}
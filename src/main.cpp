@@ -12,17 +12,27 @@
 #include <LTexture.h>
 #include <SDL_ttf.h>
 #include <cmath>
-#include <sstream>
-
-//Screen dimension constants, the frames that we need to do the animation, the time between pipes and the hole space of the pipe in pixels.
-const int SCREEN_WIDTH = 1600;
-const int SCREEN_HEIGHT = 900;
-const int MAXIMUN_FRAMES = 4;
-const int MAX_TIME_PIPE = SCREEN_WIDTH / 21;
-const int FREE_SPACE = 180;
-const int CHARACTER_X_POS = SCREEN_WIDTH / 4;
-const int PIPE_MOVEMENT = 1;
-const int CHARACTER_MOVEMENT = 5;
+#include <World.h>
+#include <GlyphAtlas.h>
+#include <Atlas.h>
+#include <AssetLoader.h>
+#include <AssetPack.h>
+#include <FrameStats.h>
+#include <Profiler.h>
+#include <Replay.h>
+#include <Layers.h>
+#include <SoftCanvas.h>
+#include <RotationCache.h>
+#include <ResourceCache.h>
+#include <CollisionMask.h>
+#include <Simulation.h>
+#include <ResolutionScale.h>
+#include <Autopilot.h>
+#include <FrameCapture.h>
+#include <Animation.h>
+#include <Broadcast.h>
+#include <vector>
+#include <algorithm>
 
 //Starts up SDL and creates window
 bool init();
@@ -36,11 +46,57 @@ void close();
 //Restart the game
 void restart ();
 
-//Our hand-made collisionDetector
-bool collisionWithCharacter(int posXObj, int posYObj, int widthObj, int heightObj);
+//Draws the world between two ticks: alpha 0 is the previous one and 1 the current one. It only reads them, all the game logic lives in World::step
+void renderWorld(const World& previous, const World& world, double alpha);
 
-//Loads individual image as texture
-SDL_Texture* loadTexture( std::string path );
+//With --fps-cap, waits until the frame that started at frameStart has taken its share of the second
+void waitUntil(std::chrono::steady_clock::time_point end);
+void waitForFrameCap(std::chrono::steady_clock::time_point frameStart);
+
+//Writes the points text again when the world has scored
+void updatePointsText(int newPoints);
+
+//Queues the game images one by one, to pack them when all of them are decoded. It is used when there is no packed atlas
+void addGameImages(AssetLoader& loader, std::vector<SDL_Surface*>& images, int& imagesLeft);
+
+//Makes the atlas texture and its regions, and the pipe columns, from the packed surface. It frees the surface.
+//file is the image that the atlas can be loaded again from, NULL if it was packed here
+bool uploadGameAtlas(SDL_Surface* atlas, const std::vector<AtlasRegion>& regions, const char* file);
+
+//Looks for the regions of the game in the atlas texture, which is already loaded, and builds the pipe columns from its surface
+bool useGameAtlas(SDL_Surface* atlas, const std::vector<AtlasRegion>& regions);
+
+//Draws the frame and the text of the end of a game over the world
+void renderGameOver(int points);
+
+//Stretches the frame to the window if it was drawn scaled, and lets gResolution know how long it took. It goes right before the present
+void finishFrame();
+
+//Draws at the scale that gResolution has chosen from now on
+void applyRenderScale();
+
+//Reads the finished frame back for gCapture, if it is capturing, for the place position of the video.
+//It goes after finishFrame and before the present
+void captureFrame(long long position);
+
+//Takes what has arrived from every remote game and acknowledges it. It goes on every frame, paused too,
+//or the servers stop sending to us
+void pollGhosts();
+
+//Polls, and puts every remote egg into gGhosts
+void updateGhosts();
+
+//Plays scripted games as fast as it can and writes how long every phase of the frames took
+bool runBenchmark(int frames, const char* output);
+
+//Draws the sky and the sun once in gBackground
+bool buildLayers();
+
+//Shows how many assets are loaded while the others are still decoding
+void renderLoadingScreen(int finished, int total);
+
+//Builds one whole pipe per hole position from the pipe region of the atlas
+bool loadPipeColumns(SDL_Surface* atlas, const SDL_Rect& pipe);
 
 //The window we'll be rendering to
 SDL_Window* gWindow = NULL;
@@ -50,52 +106,173 @@ SDL_Renderer* gRenderer = NULL;
 
 //The font renderer
 TTF_Font *gFont = NULL;
-SDL_Color textColor;
 
-//This way we handle animation / sprited textures
-SDL_Rect gSpriteClips[4];
-LTexture gSpriteSheetTexture;
-LTexture gSpritedMonigote;
+//The decoded images and the font, mapped from assets.pack. It stays open while the font is
+AssetPack gPack;
 
-//This way we manage the starting and restarting text and the point text
-LTexture gTextTextureStart;
-LTexture gTextTexturePoints;
-
-//SDL_Texture* gTexture = NULL;
-LTexture gFooTexture;
-LTexture gSunTexture;
-LTexture gFloorTexture;
-LTexture gPipeTexture;
-LTexture gFrameTexture;
-
-//This is going to handle the movement
-int frame;
+SDL_Color textColor;
 
-//This is going to rotate our character, enhancing the animation
-double degrees;
+//The clips of the sprite sheets, from animations.txt. The egg plays its clip by the frame counter of the world,
+//so the frame that is drawn is the one that collides
+AnimationLibrary gAnimations;
+int gEggClip = -1;
 
-//This tell us when we need to do the flying(> 0) or falling (< 0) animation and the movement
-double flying;
+//--sprites N puts N monigotes dancing over the floor, to see how many animated sprites a frame can take
+SpriteBatch gSprites;
+int gSpriteCount = 0;
 
-//Handler of the character's Y position
-int posY;
+//Every text of the game is drawn from this atlas, so showing new points doesn't create any texture
+GlyphAtlas gTextAtlas;
 
-//This is how we handle the spawns of out pipes
-int timingPipe;
-int nextPipe;
-int totalPipe;
+//This way we manage the starting and restarting text and the point text
+const char* START_TEXT = "Hi bro! Do you want to try my game? Press Enter to start playing, or Esc to exit";
+char gPointsText[32];
+char gGameOverText[128];
+
+//Every texture of the game comes from here, and the handles below keep them. --texture-budget-mb changes its budget
+ResourceCache gResources;
+int gTextureBudgetMB = 256;
+
+//The sun, the floor, the pipe, the egg and the final frame all live in this texture
+TextureHandle gAtlas;
+int gSunRegion;
+int gFloorRegion;
+int gFrameRegion;
+
+//Every pipe with its hole at slot 1 to 4, already built from pipe.png, side by side in one texture. This way each pipe is just one draw
+const int PIPE_COLUMN_HEIGHT = (PIPE_SLOTS - 1) * PIPE_TILE_HEIGHT + FREE_SPACE;
+TextureHandle gPipeColumns;
+int gPipeColumnRegions[4];
+
+//The pink sky and the sun never change, so they are drawn once here and copied every frame.
+//The floor goes over the pipes, so it is still drawn from the atlas after them
+StaticLayer gBackground;
+
+//Where the pipes, the egg and the points are drawn. The software renderer keeps the previous frame on the screen,
+//so with it we only put the background back and draw again where they were or are now (--layers full|dirty overrides it)
+DirtyRegions gDirty(SCREEN_WIDTH, SCREEN_HEIGHT);
+bool gDirtyCompositing = false;
+
+//With --blitter the sky, the pipes, the floor and the egg are drawn by the CPU into gSoftCanvas, from copies of the images
+//in memory, and the renderer only copies the canvas and draws the text. It is for machines without a GPU
+bool gSoftBlitter = false;
+BlitKernel gBlitKernel = BLIT_SCALAR;
+SoftCanvas gSoftCanvas;
+SoftImage gSoftAtlas;
+SoftImage gSoftPipeColumns;
+SoftImage gSoftBackground;
+PixelView gSoftSun;
+PixelView gSoftFloor;
+PixelView gSoftPipeColumnViews[4];
+
+//--render-scale draws the game at a fraction of the screen (0.5 to 1) into gScaledTarget, which stretches it to the window,
+//and --render-scale auto lets gResolution choose it from how long the frames take to draw against --draw-budget-ms.
+//Everything is still laid out in screen coordinates. The software blitter has its own canvas, which is always the whole screen
+ScaledTarget gScaledTarget;
+ResolutionController gResolution;
+double gRenderScale = 1;
+std::chrono::steady_clock::time_point gDrawStart;
+
+//The areas of the screen that the last frame drew, or all of it if gFramePartial is false
+std::vector<SDL_Rect> gFrameRegions;
+bool gFramePartial = false;
+
+//The layout, in the logical screen of World.h whatever the resolution it is drawn at. On the 1600x900 screen the points go
+//20 and 10 pixels in from the top right corner, the font is 20 pixels, and the loading bar is 40 pixels tall with a 4 pixel border
+const int POINTS_MARGIN_X = SCREEN_WIDTH / 80;
+const int POINTS_MARGIN_Y = SCREEN_HEIGHT / 90;
+const int FONT_SIZE = SCREEN_HEIGHT / 45;
+const int LOADING_BAR_HEIGHT = SCREEN_HEIGHT / 22;
+const int LOADING_BAR_INSET = SCREEN_HEIGHT / 225;
+
+//Every frame of the egg at every angle it can have, rounded to gRotationStep degrees, so it isn't turned again every frame.
+//--rotation-step 0 turns it off
+RotationCache gEggRotations;
+double gRotationStep = EGG_TURN_DEGREES;
+int gRotationCacheKB = 8192;
+
+//The egg and the pipes as bits, made from the atlas, so the world collides with what is drawn. --box-collision goes back to the boxes
+PixelMasks gPixelMasks;
+bool gPixelCollision = true;
+
+//The state of our game in the benchmark, and before the replay that is watched
+World gWorld;
+
+//The points that gPointsText is currently showing
+int shownPoints;
+
+//The parts of a frame that we time. Their percentiles are printed on exit
+enum FramePhase{
+    PHASE_EVENTS,
+    PHASE_SIMULATION,
+    PHASE_DRAW_BACKGROUND,
+    PHASE_DRAW_PIPES,
+    PHASE_DRAW_TEXT,
+    PHASE_DRAW_FLOOR,
+    PHASE_DRAW_SPRITES,
+    PHASE_DRAW_EGG,
+    PHASE_UPLOAD_CANVAS,
+    PHASE_DRAW_GAME_OVER,
+    PHASE_UPSCALE,
+    PHASE_CAPTURE,
+    PHASE_PRESENT,
+    PHASE_FRAME,
+    PHASE_COUNT
+};
+const char* const PHASE_NAMES[PHASE_COUNT] = { "events", "simulation", "draw background", "draw pipes", "draw text", "draw floor", "draw sprites", "draw egg", "upload canvas", "draw game over", "upscale", "capture", "present", "frame" };
+FrameStats gFrameStats(PHASE_NAMES, PHASE_COUNT);
+
+//Every game is recorded here, and saved to gRecordPath (--record) when it ends. --replay loads a game here to watch it
+Replay gReplay;
+const char* gRecordPath = NULL;
+
+//While playing, the world steps on the thread of gSimulation and this one only handles the events and draws its snapshots.
+//--sim-thread off steps it from the loop instead, before drawing. --stall-ms holds every 60th present that long,
+//to see that the ticks keep their pace anyway
+Simulation gSimulation;
+bool gSimThread = true;
+int gStallMs = 0;
+
+//--vsync off lets the game draw as fast as it can, --fps-cap limits it (0 is no limit). The game plays the same with any of them
+bool gVsync = true;
+int gFpsCap = 0;
+
+//--autopilot plays by itself and starts a new game AUTOPILOT_RESTART_SECONDS after losing, for the stations that run unattended.
+//It searches on --autopilot-threads threads (one per core by default) for at most --autopilot-budget-us every tick.
+//In the benchmark it plays instead of the simple player, without a budget so the games don't depend on how fast the machine is
+Autopilot* gAutopilot = NULL;
+const double AUTOPILOT_RESTART_SECONDS = 2;
+
+//--low-latency draws one frame per tick without vsync: it sleeps until just before the tick is due, reads the keys then,
+//and presents that tick as soon as it is stepped. It also waits for the GPU every frame, so no frames queue up in the driver
+bool gLowLatency = false;
+const int LATE_INPUT_MARGIN_US = 1000;
+
+//How long every flap took from the key to the present that first showed it. The SDL timestamps only have milliseconds,
+//and the present returns before the screen scans the frame out, so it is the part of the latency that the game adds
+enum LatencyPart{
+    LATENCY_INPUT_TO_TICK,
+    LATENCY_TICK_TO_PRESENT,
+    LATENCY_INPUT_TO_PRESENT,
+    LATENCY_PART_COUNT
+};
+const char* const LATENCY_NAMES[LATENCY_PART_COUNT] = { "input to tick", "tick to present", "input to present" };
+FrameStats gLatencyStats(LATENCY_NAMES, LATENCY_PART_COUNT);
 
-//Here we are going to save the points
-int points;
+//Without a window or a GPU: dummy video driver, software renderer and no vsync
+bool gHeadless = false;
 
-//This is how we handle the current position of each pipe
-struct Pipe{
-	int xPosition;
-	int freeSpotPosition;
-	bool pointCounted;
-};
+//--capture records the presented frames to a Y4M file, or "|command" gives the raw YUV 4:2:0 frames to an encoder, at TICK_RATE
+//frames per second by the time they were presented. The frames that come while --capture-buffers frames are still waiting to be
+//written are dropped, and the previous frame is repeated in their place
+FrameCapture gCapture;
 
-Pipe pipes[7];
+//--broadcast port sends every tick of this game to the viewers on other machines over UDP, in at most --broadcast-budget bytes
+//per tick and viewer. --ghost host:port, as many times as wanted, draws the eggs of those games see-through over ours
+GhostServer gBroadcast;
+std::vector<GhostClient*> gGhostClients;
+SpriteBatch gGhosts;
+const Uint8 GHOST_ALPHA = 0x60;
 
 bool init()
 {
@@ -117,7 +294,7 @@ bool init()
 		}
 
 		//Create window
-		gWindow = SDL_CreateWindow( "SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN );
+		gWindow = SDL_CreateWindow( "SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, gHeadless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN );
 		if( gWindow == NULL )
 		{
 			printf( "Window could not be created! SDL Error: %s\n", SDL_GetError() );
@@ -126,7 +303,7 @@ bool init()
 		else
 		{
 			//Create renderer for window
-			gRenderer = SDL_CreateRenderer( gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC );
+			gRenderer = SDL_CreateRenderer( gWindow, -1, gHeadless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED | ( gVsync ? SDL_RENDERER_PRESENTVSYNC : 0 ) );
 			if( gRenderer == NULL )
 			{
 				printf( "Renderer could not be created! SDL Error: %s\n", SDL_GetError() );
@@ -161,85 +338,126 @@ bool loadMedia()
 {
 	//Loading success flag
 	bool success = true;
-
-     //Open the font
-    gFont = TTF_OpenFont( "University.ttf", 20 );
-    if( gFont == NULL )
-    {
-        printf( "Failed to load font! SDL_ttf Error: %s\n", TTF_GetError() );
-        success = false;
-    }
-    else
-    {
-        //Render text
-        textColor = { 0, 0, 0 };
-        if( !gTextTextureStart.loadFromRenderedText( "Hi bro! Do you want to try my game? Press Enter to start playing, or Esc to exit", textColor, gFont ,gRenderer ) )
-        {
-            printf( "Failed to render text texture!\n" );
-            success = false;
-        }
-    }
-    //This top of our background
-	if (!gSunTexture.loadFromFile("sun.png", gRenderer )){
-        printf("Sorry bro, I have a problem loading \"sun.png\" \n ");
-        success = false;
+	textColor = { 0, 0, 0, 0xFF };
+
+	//The textures that make and free themselves are not in the cache, but they count in its report, budget and leak check
+	gResources.track( "glyph atlas", [](){ return gTextAtlas.getTexture(); } );
+	gResources.track( "background layer", [](){ return gBackground.getTexture(); } );
+	gResources.track( "soft canvas", [](){ return gSoftCanvas.getTexture(); } );
+	gResources.track( "scaled target", [](){ return gScaledTarget.getTexture(); } );
+	gResources.track( "egg rotations", [](){ return gEggRotations.getTexture(); } );
+
+	//The workers decode every file at the same time, and this thread turns them into textures as they finish.
+	//The loader goes after the pool, so it is destroyed first and can still wait for it
+	ThreadPool pool;
+	AssetLoader loader( pool );
+
+	//With the asset pack the images are already decoded and the font is already in memory. Without it we load every file
+	if( gPack.open( ASSET_PACK ) ) printf( "Loading from %s\n", ASSET_PACK );
+
+	//The egg has always had 4 frames of 60x60, 2 per row, 4 ticks each. That one is used if the manifest doesn't have it
+	gAnimations.load( ANIMATION_MANIFEST );
+	if( gAnimations.find( "egg" ) < 0 )
+	{
+		AnimationClip egg = { "egg", "spritedPlayer", CHARACTER_SIZE, CHARACTER_SIZE, 2, MAXIMUN_FRAMES, 4, true, -1 };
+		gAnimations.addClip( egg );
 	}
 
-    //This is the bottom of our background
-    if (!gFloorTexture.loadFromFile("floor.png", gRenderer)){
-        printf("Sorry bro, I have a problem loading \"floor.png\" \n ");
-        success = false;
+	//Open the font and rasterize it once for every text of the game
+	loader.add( FONT_FILE, []{
+		if( gPack.find( FONT_FILE ) != NULL ) gFont = TTF_OpenFontRW( gPack.getRW( FONT_FILE ), 1, FONT_SIZE );
+		else gFont = TTF_OpenFont( FONT_FILE, FONT_SIZE );
+		if( gFont == NULL )
+		{
+			printf( "Failed to load font! SDL_ttf Error: %s\n", TTF_GetError() );
+			return (SDL_Surface*)NULL;
+		}
+		return gTextAtlas.rasterize( gFont );
+	}, []( SDL_Surface* glyphs ){
+		if( glyphs == NULL ) return false;
+		bool uploaded = gTextAtlas.loadFromSurface( glyphs, gRenderer );
+		SDL_FreeSurface( glyphs );
+		return uploaded;
+	});
+
+	//Every image of the game, packed in one texture. The packed atlas is made by the AtlasPacker tool,
+	//without it we pack the images here, which is slower but works the same
+	std::vector<AtlasRegion> regions;
+	std::vector<SDL_Surface*> images;
+	int imagesLeft = 0;
+	if( gPack.find( ATLAS_IMAGE ) != NULL )
+	{
+		//The surface only points at the mapped pixels, the pipe columns are cut from it
+		loader.add( ATLAS_IMAGE, []{ return gPack.getSurface( ATLAS_IMAGE ); }, []( SDL_Surface* atlas ){
+			ResourceCache::LoadFunction fromPack = []( LTexture& texture ){ return texture.loadFromPack( gPack, ATLAS_IMAGE, gRenderer ); };
+			if( atlas != NULL ) gAtlas = gResources.load( std::string( "pack:" ) + ATLAS_IMAGE, fromPack, fromPack );
+			bool uploaded = gAtlas.isValid() && useGameAtlas( atlas, gPack.getRegions( ATLAS_IMAGE ) );
+			if( atlas != NULL ) SDL_FreeSurface( atlas );
+			return uploaded;
+		});
+	}
+	else if( loadAtlasManifest( ATLAS_MANIFEST, regions ) )
+	{
+		loader.add( ATLAS_IMAGE, []{ return loadKeyedSurface( ATLAS_IMAGE ); }, [&]( SDL_Surface* atlas ){
+			if( atlas != NULL ) return uploadGameAtlas( atlas, regions, ATLAS_IMAGE );
+			printf( "There is no %s, packing the images now\n", ATLAS_IMAGE );
+			addGameImages( loader, images, imagesLeft );
+			return true;
+		});
+	}
+	else
+	{
+		printf( "There is no %s, packing the images now\n", ATLAS_MANIFEST );
+		addGameImages( loader, images, imagesLeft );
 	}
 
-    //This is the pipe texture
-	if (!gPipeTexture.loadFromFile("pipe.png", gRenderer)){
-        printf("Sorry bro, I have a problem loading \"pipe.png\" \n ");
-        success = false;
+	while( !loader.isDone() )
+	{
+		SDL_Event e;
+		while( SDL_PollEvent( &e ) != 0 )
+		{
+			if( e.type == SDL_QUIT || ( e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE ) )
+			{
+				printf( "Loading cancelled\n" );
+				return false;
+			}
+		}
+		if( !loader.update() ) success = false;
+		renderLoadingScreen( loader.getFinished(), loader.getTotal() );
 	}
-	//This is the final's frame texture
-	if (!gFrameTexture.loadFromFile("frame.png", gRenderer)){
-        printf("Sorry bro, I have a problem loading \"frame.png\" \n ");
-        success = false;
-	}else
-         gFrameTexture.setBlendMode(SDL_BLENDMODE_BLEND);
-
-    //This is the sprite of our character (flying egg). It have 4 square frames
-    if (!( gSpritedMonigote.loadFromFile("spritedPlayer.png", gRenderer))){
-        printf("Sorry bro, I have a problem loading \"spritedPlayer.png\" \n");
-        success = false;
-	} else{
-        gSpriteClips[0].x = 0;
-        gSpriteClips[0].y = 0;
-        gSpriteClips[0].w = 60;
-        gSpriteClips[0].h = 60;
-
-        gSpriteClips[1].x = 60;
-        gSpriteClips[1].y = 0;
-        gSpriteClips[1].w = 60;
-        gSpriteClips[1].h = 60;
-
-        gSpriteClips[2].x = 0;
-        gSpriteClips[2].y = 60;
-        gSpriteClips[2].w = 60;
-        gSpriteClips[2].h = 60;
-
-        gSpriteClips[3].x = 60;
-        gSpriteClips[3].y = 60;
-        gSpriteClips[3].w = 60;
-        gSpriteClips[3].h = 60;
-
-        //This allows us to use transparencies on the character
-        gSpritedMonigote.setBlendMode(SDL_BLENDMODE_BLEND);
+	loader.printReport();
+
+	if( !success )
+	{
+		printf("Sorry bro, I have a problem loading the images \n ");
 	}
 	return success;
 }
 
 void close()
 {
-	gSunTexture.free();
-	gFloorTexture.free();
-	gPipeTexture.free();
-	gSpritedMonigote.free();
+	gResources.printReport( stdout );
+
+	gBackground.free();
+	gTextAtlas.free();
+	gSoftCanvas.free();
+	gSoftAtlas.free();
+	gSoftPipeColumns.free();
+	gSoftBackground.free();
+	gEggRotations.free();
+	gScaledTarget.free();
+
+	//Every handle goes before the cache checks that nothing is left
+	gAtlas.reset();
+	gPipeColumns.reset();
+	int leaks = gResources.shutdown();
+	if( leaks > 0 ) printf( "%d textures were never released\n", leaks );
+
+	if( gFont != NULL )
+	{
+		TTF_CloseFont( gFont );
+		gFont = NULL;
+	}
 
 	//Destroy window
 	SDL_DestroyRenderer( gRenderer );
@@ -248,84 +466,645 @@ void close()
 	gRenderer = NULL;
 
 	//Quit SDL subsystems
+	TTF_Quit();
 	IMG_Quit();
 	SDL_Quit();
 }
 
-SDL_Texture* loadTexture( std::string path )
+void addGameImages( AssetLoader& loader, std::vector<SDL_Surface*>& images, int& imagesLeft )
 {
-	//The final texture
-	SDL_Texture* newTexture = NULL;
+	images.assign( GAME_IMAGE_COUNT, (SDL_Surface*)NULL );
+	imagesLeft = GAME_IMAGE_COUNT;
+	for( int i = 0; i < GAME_IMAGE_COUNT; i++ )
+	{
+		loader.add( GAME_IMAGES[i], [i]{ return loadKeyedSurface( GAME_IMAGES[i] ); }, [i, &images, &imagesLeft]( SDL_Surface* image ){
+			images[i] = image;
+			imagesLeft--;
+			if( imagesLeft > 0 ) return image != NULL;
+
+			//The last one to arrive packs all of them
+			bool complete = true;
+			for( int j = 0; j < GAME_IMAGE_COUNT; j++ ) if( images[j] == NULL ) complete = false;
+			std::vector<AtlasRegion> regions;
+			SDL_Surface* atlas = complete ? packGameAtlas( images, regions ) : NULL;
+			for( int j = 0; j < GAME_IMAGE_COUNT; j++ ) if( images[j] != NULL ) SDL_FreeSurface( images[j] );
+			images.clear();
+			if( atlas == NULL ) return false;
+			return uploadGameAtlas( atlas, regions, NULL );
+		});
+	}
+}
 
-	//Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load( path.c_str() );
-	if( loadedSurface == NULL )
+bool uploadGameAtlas( SDL_Surface* atlas, const std::vector<AtlasRegion>& regions, const char* file )
+{
+	ResourceCache::LoadFunction fromSurface = [&]( LTexture& texture ){
+		if( !texture.loadFromSurface( atlas, gRenderer ) ) return false;
+		texture.setRegions( regions );
+		return true;
+	};
+
+	//Only an atlas read from a file can be evicted, because it can be read again
+	ResourceCache::LoadFunction fromFile;
+	if( file != NULL )
 	{
-		printf( "Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError() );
+		std::string path = file;
+		fromFile = [path, regions]( LTexture& texture ){
+			SDL_Surface* surface = loadKeyedSurface( path );
+			bool loaded = surface != NULL && texture.loadFromSurface( surface, gRenderer );
+			if( surface != NULL ) SDL_FreeSurface( surface );
+			if( loaded ) texture.setRegions( regions );
+			return loaded;
+		};
 	}
-	else
+
+	gAtlas = gResources.load( file != NULL ? file : "packed atlas", fromSurface, fromFile );
+	bool success = gAtlas.isValid() && useGameAtlas( atlas, regions );
+
+	SDL_FreeSurface( atlas );
+	return success;
+}
+
+bool useGameAtlas( SDL_Surface* atlas, const std::vector<AtlasRegion>& regions )
+{
+	//This allows us to use transparencies on the character and the final frame
+	gAtlas->setBlendMode( SDL_BLENDMODE_BLEND );
+
+	gSunRegion = gAtlas->getRegion( "sun" );
+	gFloorRegion = gAtlas->getRegion( "floor" );
+	gFrameRegion = gAtlas->getRegion( "frame" );
+	gAnimations.resolve( regions );
+	gEggClip = gAnimations.find( "egg" );
+	const AtlasRegion* pipe = findAtlasRegion( regions, "pipe" );
+	if( gSunRegion < 0 || gFloorRegion < 0 || gFrameRegion < 0 || gEggClip < 0 || pipe == NULL )
+	{
+		printf( "The atlas is missing some images!\n" );
+		return false;
+	}
+
+	//The world still steps the frames of the egg by itself, and the masks are made from its sheet
+	const AnimationClip& egg = gAnimations.getClip( gEggClip );
+	if( egg.frameCount != MAXIMUN_FRAMES || egg.ticksPerFrame != 4 || egg.frameWidth != CHARACTER_SIZE || egg.frameHeight != CHARACTER_SIZE )
+	{
+		printf( "The egg of %s is not the one the world collides with, it may not look like it does\n", ANIMATION_MANIFEST );
+	}
+
+	//The collision masks come from the same pixels that are drawn
+	if( !buildGameMasks( atlas, regions, gPixelMasks ) ) return false;
+	printf( "Collision masks: %d egg frames at %d angles, %.1f KB\n", gPixelMasks.eggFrames, gPixelMasks.angleCount, gPixelMasks.getMemoryBytes() / 1024.0 );
+
+	//The software blitter reads its own copy of the pixels
+	if( gSoftBlitter )
+	{
+		if( !gSoftAtlas.loadFromSurface( atlas ) ) return false;
+		gSoftSun = gSoftAtlas.getRect( findAtlasRegion( regions, "sun" )->rect );
+		gSoftFloor = gSoftAtlas.getRect( findAtlasRegion( regions, "floor" )->rect );
+	}
+	return loadPipeColumns( atlas, pipe->rect );
+}
+
+void renderLoadingScreen( int finished, int total )
+{
+	SDL_SetRenderDrawColor( gRenderer, 0xFF, 0xAE, 0xC9, 0xFF );
+	SDL_RenderClear( gRenderer );
+
+	SDL_Rect border = { SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - LOADING_BAR_HEIGHT / 2, SCREEN_WIDTH / 2, LOADING_BAR_HEIGHT };
+	SDL_Rect bar = { border.x + LOADING_BAR_INSET, border.y + LOADING_BAR_INSET, 0, border.h - 2 * LOADING_BAR_INSET };
+	if( total > 0 ) bar.w = ( border.w - 2 * LOADING_BAR_INSET ) * finished / total;
+	SDL_SetRenderDrawColor( gRenderer, 0, 0, 0, 0xFF );
+	SDL_RenderDrawRect( gRenderer, &border );
+	SDL_RenderFillRect( gRenderer, &bar );
+
+	SDL_RenderPresent( gRenderer );
+}
+
+bool loadPipeColumns( SDL_Surface* atlas, const SDL_Rect& pipe )
+{
+	//Every column gets the same padding as the atlas
+	int columnWidth = pipe.w + 2 * ATLAS_PADDING;
+	SDL_Surface* columns = SDL_CreateRGBSurface( 0, 4 * columnWidth, PIPE_COLUMN_HEIGHT, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 );
+	if( columns == NULL )
+	{
+		printf( "Unable to create the pipe columns! SDL Error: %s\n", SDL_GetError() );
+		return false;
+	}
+	SDL_FillRect( columns, NULL, 0 );
+
+	//We copy the pixels as they are instead of blending them
+	SDL_SetSurfaceBlendMode( atlas, SDL_BLENDMODE_NONE );
+
+	std::vector<AtlasRegion> regions;
+	for( int free = 1; free <= 4; free++ )
 	{
-		//Create texture from surface pixels
-        newTexture = SDL_CreateTextureFromSurface( gRenderer, loadedSurface );
-		if( newTexture == NULL )
+		AtlasRegion region;
+		region.name = "column" + std::string( 1, (char)( '0' + free ) );
+		region.rect.x = ( free - 1 ) * columnWidth + ATLAS_PADDING;
+		region.rect.y = 0;
+		region.rect.w = pipe.w;
+		region.rect.h = PIPE_COLUMN_HEIGHT;
+		regions.push_back( region );
+
+		//Same slots as the game: a piece of pipe on each of them, except the hole
+		int yPos = 0;
+		for( int j = 0; j < PIPE_SLOTS; j++ )
 		{
-			printf( "Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError() );
+			if( j == free ) yPos += FREE_SPACE;
+			else
+			{
+				SDL_Rect slot = { region.rect.x, yPos, pipe.w, pipe.h };
+				SDL_BlitSurface( atlas, &pipe, columns, &slot );
+				yPos += PIPE_TILE_HEIGHT;
+			}
 		}
-
-		//Get rid of old loaded surface
-		SDL_FreeSurface( loadedSurface );
 	}
 
-	return newTexture;
+	//They are cut from the atlas surface, which is gone afterwards, so they can't be evicted
+	gPipeColumns = gResources.load( "pipe columns", [&]( LTexture& texture ){
+		if( !texture.loadFromSurface( columns, gRenderer ) ) return false;
+		texture.setRegions( regions );
+		texture.setBlendMode( SDL_BLENDMODE_BLEND );
+		return true;
+	});
+	bool success = gPipeColumns.isValid();
+	if( success )
+	{
+		for( int i = 0; i < 4; i++ ) gPipeColumnRegions[i] = i;
+	}
+	if( success && gSoftBlitter )
+	{
+		success = gSoftPipeColumns.loadFromSurface( columns );
+		for( int i = 0; i < 4 && success; i++ ) gSoftPipeColumnViews[i] = gSoftPipeColumns.getRect( regions[i].rect );
+	}
+	SDL_FreeSurface( columns );
+	return success;
 }
 
-//This reset the data to restart the game
+//This reset the data to restart the game, for the benchmark. Playing, gSimulation restarts its own world
 void restart (){
-    //Handler of the points counting
-    points = 0;
-    std::stringstream ss;
-    ss << points;
-    if( !gTextTexturePoints.loadFromRenderedText( "Points: " + ss.str(), textColor, gFont ,gRenderer ) )
-        {
-            printf( "Failed to render text texture of points!\n" );
+    unsigned int seed = rand();
+    gWorld.restart(seed);
+    gReplay.start(seed, gWorld.masks != NULL);
+    if (gAutopilot != NULL) gAutopilot->reset();
+    gDirty.invalidate();
+    updatePointsText(gWorld.points);
+}
+
+void updatePointsText(int newPoints){
+    PROFILE_ZONE("update points text");
+    shownPoints = newPoints;
+    snprintf(gPointsText, sizeof(gPointsText), "Points: %d", shownPoints);
+}
+
+//Where something that was at "from" on the previous tick and is at "to" now is drawn
+static int interpolate(double from, double to, double alpha){
+    return (int)floor(from + (to - from) * alpha + 0.5);
+}
+
+//The pipe i of world as it was in previous, or NULL if it was just spawned. The oldest pipe may have been retired in between,
+//so it is the same index or the next one, PIPE_SPEED to the right
+static const Pipe* previousPipe(const World& previous, const World& world, int i){
+    for (int j = i; j <= i + 1 and j < previous.pipes.size(); j++){
+        int moved = previous.pipes[j].xPosition - world.pipes[i].xPosition;
+        if (moved >= 0 and moved <= PIPE_SPEED) return &previous.pipes[j];
+    }
+    return NULL;
+}
+
+void renderWorld(const World& previous, const World& world, double alpha){
+    //Where everything goes this frame, and which pipes are on the screen at all
+    int pipeX[MAX_PIPES];
+    bool pipeVisible[MAX_PIPES];
+    int pipeWidth = gPipeColumns->getRegionWidth(0);
+    for (int i = 0; i < world.pipes.size(); i++){
+        pipeX[i] = world.pipes[i].xPosition;
+        const Pipe* before = previousPipe(previous, world, i);
+        if (before != NULL) pipeX[i] = interpolate(before->xPosition, pipeX[i], alpha);
+        pipeVisible[i] = pipeX[i] < SCREEN_WIDTH and pipeX[i] + pipeWidth > 0;
+    }
+    int textWidth = gTextAtlas.getTextWidth(gPointsText);
+    int posY = interpolate(previous.posY, world.posY, alpha);
+
+    //A flap turns the egg up at once, so only the turning down is interpolated
+    double degrees = world.degrees >= previous.degrees ? previous.degrees + (world.degrees - previous.degrees) * alpha : world.degrees;
+
+    //Scaled, everything goes to the target texture from here on
+    gDrawStart = FrameStats::now();
+    gScaledTarget.begin();
+
+    //The areas that change. The egg can be rotated, so we take the square where any rotation fits
+    std::vector<SDL_Rect>& regions = gFrameRegions;
+    bool& partial = gFramePartial;
+    regions.clear();
+    partial = false;
+    if (gDirtyCompositing){
+        for (int i = 0; i < world.pipes.size(); i++){
+            if (!pipeVisible[i]) continue;
+            SDL_Rect pipe = { pipeX[i], 0, pipeWidth, SCREEN_HEIGHT };
+            gDirty.add(pipe);
         }
+        SDL_Rect text = { SCREEN_WIDTH - (textWidth + POINTS_MARGIN_X), POINTS_MARGIN_Y, textWidth, gTextAtlas.getHeight() };
+        gDirty.add(text);
+        int eggHalf = (int)ceil(CHARACTER_SIZE * 0.7072) + 2;
+        SDL_Rect egg = { CHARACTER_X_POS + CHARACTER_SIZE / 2 - eggHalf, posY + CHARACTER_SIZE / 2 - eggHalf, 2 * eggHalf, 2 * eggHalf };
+        gDirty.add(egg);
+        for (int i = 0; i < gSprites.getCount(); i++) gDirty.add(gSprites.getBounds(i, gAnimations));
+        for (int i = 0; i < gGhosts.getCount(); i++) gDirty.add(gGhosts.getBounds(i, gAnimations));
+        partial = gDirty.getRegions(regions);
+        gDirty.endFrame();
+    }
 
-    //This is going to handle the movement
-    frame = 0;
+    //The software blitter draws into the canvas what the renderer would draw, and then the renderer copies it
+    bool soft = gSoftCanvas.isCreated();
+    const PixelView& canvas = gSoftCanvas.getView();
 
-    //This is going to rotate our character, enhancing the animation
-    degrees = -45;
+    {
+        PhaseTimer timer(gFrameStats, PHASE_DRAW_BACKGROUND);
+        //Firstly we draw the sky and the sun, everywhere or only where something has changed
+        if (soft){
+            if (partial){
+                for (size_t r = 0; r < regions.size(); r++) blitCopy(canvas, regions[r].x, regions[r].y, gSoftBackground.getRect(regions[r]));
+            }
+            else blitCopy(canvas, 0, 0, gSoftBackground.getView());
+        }
+        else if (partial){
+            for (size_t r = 0; r < regions.size(); r++) gBackground.render(regions[r]);
+        }
+        else gBackground.render();
+    }
 
-    //This tell us when we need to do the flying(> 0) or falling (< 0) animation and the movement
-    flying = MAXIMUN_FRAMES * 4 * 2;
+    {
+        PhaseTimer timer(gFrameStats, PHASE_DRAW_PIPES);
+        //Now we draw all the pipes, each one with the column of its hole
+        for (int i = 0; i < world.pipes.size(); i++){
+            if (!pipeVisible[i]) continue;
+            int column = gPipeColumnRegions[world.pipes[i].freeSpotPosition - 1];
+            if (soft) blitBlend(canvas, pipeX[i], 0, gSoftPipeColumnViews[column], 255, gBlitKernel);
+            else gPipeColumns->renderRegion(gRenderer,pipeX[i],0,column);
+        }
+    }
 
-    //Handler of the character's Y position
-    posY = (SCREEN_HEIGHT - 60)/2;
+    {
+        PhaseTimer timer(gFrameStats, PHASE_DRAW_FLOOR);
+        //Now we render the floor on top of the pipe, only the pieces that the background has covered
+        int floorY = SCREEN_HEIGHT-gAtlas->getRegionHeight(gFloorRegion);
+        if (partial){
+            SDL_Rect floor = { 0, floorY, gAtlas->getRegionWidth(gFloorRegion), gAtlas->getRegionHeight(gFloorRegion) };
+            for (size_t r = 0; r < regions.size(); r++){
+                SDL_Rect piece;
+                if (!SDL_IntersectRect(&regions[r], &floor, &piece)) continue;
+                SDL_Rect clip = { piece.x, piece.y - floorY, piece.w, piece.h };
+                if (soft) blitBlend(canvas, piece.x, piece.y, subView(gSoftFloor, clip.x, clip.y, clip.w, clip.h), 255, gBlitKernel);
+                else gAtlas->renderRegion(gRenderer,piece.x,piece.y,gFloorRegion,&clip);
+            }
+        }
+        else if (soft) blitBlend(canvas, 0, floorY, gSoftFloor, 255, gBlitKernel);
+        else gAtlas->renderRegion(gRenderer,0,floorY,gFloorRegion);
+    }
 
-    //This is how we handle the spawns of out pipes
-    timingPipe = MAX_TIME_PIPE;
-    nextPipe = 1;
-    totalPipe = 1;
+    if (gSprites.getCount() > 0){
+        PhaseTimer timer(gFrameStats, PHASE_DRAW_SPRITES);
+        if (soft) gSprites.blit(canvas, gSoftAtlas, gAnimations, gBlitKernel);
+        else gSprites.draw(gRenderer, *gAtlas.get(), gAnimations);
+    }
 
-    //This is how we handle the current position of each pipe
-    pipes[0].xPosition = SCREEN_WIDTH;
-    pipes[0].freeSpotPosition = (rand() % 4) + 1;
-    pipes[0].pointCounted = false;
+    {
+        PhaseTimer timer(gFrameStats, PHASE_DRAW_EGG);
+        //The remote eggs go under ours
+        if (soft) gGhosts.blit(canvas, gSoftAtlas, gAnimations, gBlitKernel, GHOST_ALPHA);
+        else gGhosts.draw(gRenderer, *gAtlas.get(), gAnimations, GHOST_ALPHA);
+
+        //We select the frame of the egg that we're going to paint
+        int eggFrame = gAnimations.getFrame(gEggClip, world.frame);
+        SDL_Rect currentClip = gAnimations.getFrameRect(gEggClip, eggFrame);
+        if (soft) blitRotated(canvas, CHARACTER_X_POS, posY, gSoftAtlas.getRect(currentClip), degrees, gBlitKernel);
+        else if (!gEggRotations.render(eggFrame, degrees, CHARACTER_X_POS, posY))
+            gAtlas->render(gRenderer,CHARACTER_X_POS, posY, &currentClip, degrees,NULL);
     }
 
-//TODO ARREGLAR LA PUTA COLLISION
-bool collisionWithCharacter(int posXObj, int posYObj, int widthObj, int heightObj){
-    bool collision = false;
+    if (soft){
+        PhaseTimer timer(gFrameStats, PHASE_UPLOAD_CANVAS);
+        gSoftCanvas.render(partial ? &regions : NULL);
+    }
+
+    //The text goes on top of everything, so it is drawn by the renderer after the canvas
+    PhaseTimer timer(gFrameStats, PHASE_DRAW_TEXT);
+    gTextAtlas.render(gRenderer, gPointsText, SCREEN_WIDTH - (textWidth + POINTS_MARGIN_X), POINTS_MARGIN_Y, textColor);
+}
+
+bool buildLayers(){
+    //The monigotes of --sprites stand on the floor all over the screen, each one a bit later in the dance than the previous
+    int dancer = gAnimations.find("monigote");
+    if (gSpriteCount > 0 and dancer < 0) printf("There is no monigote animation, --sprites is ignored\n");
+    for (int i = 0; dancer >= 0 and i < gSpriteCount; i++){
+        const AnimationClip& clip = gAnimations.getClip(dancer);
+        int x = (i * 53) % (SCREEN_WIDTH - clip.frameWidth);
+        int y = SCREEN_HEIGHT - FLOOR_HEIGHT - clip.frameHeight + (i % 5) * FLOOR_HEIGHT / 5;
+        gSprites.add(dancer, x, y, 0, (float)(i * 3));
+    }
+
+    if (gSoftBlitter){
+        //The same background in memory. Without the canvas texture the renderer draws everything as usual
+        gSoftBackground.create(SCREEN_WIDTH, SCREEN_HEIGHT, 0xFFFFAEC9);
+        blitBlend(gSoftBackground.getView(), 0, 0, gSoftSun, 255, gBlitKernel);
+        if (gSoftCanvas.create(gRenderer, SCREEN_WIDTH, SCREEN_HEIGHT)) printf("Drawing with the %s software blitter\n", getBlitKernelName(gBlitKernel));
+    }
+
+    //The software blitter turns the egg itself
+    if (gRotationStep > 0 and !gSoftCanvas.isCreated()){
+        const AnimationClip& egg = gAnimations.getClip(gEggClip);
+        bool built = gEggRotations.build(gRenderer, egg.frameCount, egg.frameWidth, egg.frameHeight, EGG_FLAP_DEGREES, EGG_MAX_DEGREES, gRotationStep,
+                                         (size_t)gRotationCacheKB * 1024, [](SDL_Renderer* renderer, int frame, double degrees, int x, int y){
+            SDL_Rect clip = gAnimations.getFrameRect(gEggClip, frame);
+            gAtlas->setBlendMode(SDL_BLENDMODE_NONE);
+            gAtlas->render(renderer, x, y, &clip, degrees, NULL);
+            gAtlas->setBlendMode(SDL_BLENDMODE_BLEND);
+        });
+        if (built) printf("Egg rotations: %d cells every %g degrees, %d drawn at start\n", gEggRotations.getCellCount(), gRotationStep, gEggRotations.getBakeCount());
+    }
+
+    //The canvas of the software blitter is the whole screen, so it isn't scaled
+    gScaledTarget.create(gRenderer, SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (gSoftCanvas.isCreated() and (gRenderScale < 1 or gResolution.isAuto())){
+        printf("The software blitter draws the whole screen, --render-scale is ignored\n");
+        gResolution.setAuto(false);
+    }
+    else if (gResolution.isAuto()) applyRenderScale();
+    else if (gRenderScale < 1){
+        if (!gScaledTarget.setScale(gRenderScale)) printf("The renderer can't draw at %g of the screen, drawing it whole\n", gRenderScale);
+        gDirty.setPadding(gScaledTarget.isScaled() ? (int)ceil(1 / gScaledTarget.getScale()) : 0);
+    }
+
+    //It only fills, so it is also right when the layer is drawn from scratch with a clip rect
+    return gBackground.build(gRenderer, SCREEN_WIDTH, SCREEN_HEIGHT, true, [](SDL_Renderer* renderer){
+        SDL_SetRenderDrawColor(renderer,0xFF,0xAE,0xC9,0xFF);
+        SDL_RenderFillRect(renderer, NULL);
+        gAtlas->renderRegion(renderer,0,0,gSunRegion);
+    });
+}
+
+void waitUntil(std::chrono::steady_clock::time_point end){
+    //SDL_Delay can sleep a bit longer than asked, so the last couple of milliseconds are waited here
+    for (;;){
+        double left = std::chrono::duration<double, std::milli>(end - FrameStats::now()).count();
+        if (left <= 0) break;
+        if (left > 2) SDL_Delay((Uint32)(left - 2));
+    }
+}
+
+void waitForFrameCap(std::chrono::steady_clock::time_point frameStart){
+    if (gFpsCap <= 0) return;
+    waitUntil(frameStart + std::chrono::microseconds(1000000 / gFpsCap));
+}
+
+//Times every flap that the snapshot of tick has, now that it is on the screen
+static void addInputLatency(long long tick, std::chrono::steady_clock::time_point presented){
+    AppliedInput input;
+    while (gSimulation.takeAppliedInput(tick, input)){
+        gLatencyStats.add(LATENCY_INPUT_TO_TICK, std::chrono::duration<double, std::micro>(input.stepped - input.time).count());
+        gLatencyStats.add(LATENCY_TICK_TO_PRESENT, std::chrono::duration<double, std::micro>(presented - input.stepped).count());
+        gLatencyStats.add(LATENCY_INPUT_TO_PRESENT, std::chrono::duration<double, std::micro>(presented - input.time).count());
+    }
+}
+
+//When an event happened, from its SDL timestamp (the milliseconds since SDL started)
+static std::chrono::steady_clock::time_point eventTime(Uint32 timestamp){
+    Uint32 ticks = SDL_GetTicks();
+    Uint32 age = ticks > timestamp ? ticks - timestamp : 0;
+    return FrameStats::now() - std::chrono::milliseconds(age);
+}
+
+void renderGameOver(int points){
+    PhaseTimer timer(gFrameStats, PHASE_DRAW_GAME_OVER);
+    //It covers the middle of the screen, which isn't tracked, so this frame goes whole to the window too
+    gDirty.invalidate();
+    gFramePartial = false;
+    snprintf(gGameOverText, sizeof(gGameOverText), "Congratulations... or maybe not. You've reach %d points. Press Enter to restart, and Esc to exit", points);
+    //The alpha is for the whole atlas, so we put it back after drawing the frame
+    gAtlas->setAlpha(0xA0);
+    gAtlas->renderRegion(gRenderer, SCREEN_WIDTH/2 - gAtlas->getRegionWidth(gFrameRegion) /2, SCREEN_HEIGHT/2 - gAtlas->getRegionHeight(gFrameRegion) / 2, gFrameRegion);
+    gAtlas->setAlpha(0xFF);
+    gTextAtlas.render(gRenderer, gGameOverText, SCREEN_WIDTH/2 - gTextAtlas.getTextWidth(gGameOverText) /2, SCREEN_HEIGHT/2, textColor);
+}
+
+void finishFrame(){
+    {
+        PhaseTimer timer(gFrameStats, PHASE_UPSCALE);
+        gScaledTarget.end(gFramePartial ? &gFrameRegions : NULL);
+    }
+    double drawing = std::chrono::duration<double, std::micro>(FrameStats::now() - gDrawStart).count();
+    if (gResolution.addFrame(drawing)) applyRenderScale();
+}
+
+void captureFrame(long long position){
+    if (!gCapture.isCapturing()) return;
+    PhaseTimer timer(gFrameStats, PHASE_CAPTURE);
+    uint32_t* pixels = gCapture.beginFrame();
+    if (pixels == NULL) return;
+    //The window, after the frame was stretched to it. The buffer always has its size from when the capture started
+    SDL_Rect rect = { 0, 0, gCapture.getWidth(), gCapture.getHeight() };
+    if (SDL_RenderReadPixels( gRenderer, &rect, SDL_PIXELFORMAT_ARGB8888, pixels, rect.w * (int)sizeof(uint32_t) ) != 0){
+        printf( "Unable to read the frame back! SDL Error: %s\n", SDL_GetError() );
+        gCapture.stop();
+        return;
+    }
+    gCapture.endFrame(position);
+}
+
+void pollGhosts(){
+    for (size_t i = 0; i < gGhostClients.size(); i++) gGhostClients[i]->poll();
+}
+
+void updateGhosts(){
+    pollGhosts();
+    gGhosts.clear();
+    for (size_t i = 0; i < gGhostClients.size(); i++){
+        if (!gGhostClients[i]->hasState()) continue;
+        const GhostState& ghost = gGhostClients[i]->getState();
+        gGhosts.add(gEggClip, CHARACTER_X_POS, ghost.posY, ghost.centidegrees / 100.0f, (float)ghost.frame);
+    }
+}
+
+void applyRenderScale(){
+    if (!gScaledTarget.setScale(gResolution.getScale())){
+        gResolution.setAuto(false);
+        gResolution.setLevel(0);
+    }
+    //The new texture has nothing yet. Scaled, the edges of the areas round to whole pixels of the texture
+    gDirty.invalidate();
+    gDirty.setPadding(gScaledTarget.isScaled() ? (int)ceil(1 / gScaledTarget.getScale()) : 0);
+}
+
+bool runBenchmark(int frames, const char* output){
+    //The games are always the same, so two runs can be compared
+    const int WARMUP_FRAMES = 60;
+    srand(1);
+    restart();
+    int games = 0;
+    long long bestPoints = 0;
+
+    std::chrono::steady_clock::time_point start = FrameStats::now();
+    for (int f = 0; f < WARMUP_FRAMES + frames; f++){
+        if (f == WARMUP_FRAMES){
+            gFrameStats.reset();
+            start = FrameStats::now();
+        }
+        PhaseTimer frameTimer(gFrameStats, PHASE_FRAME);
+
+        {
+            PhaseTimer timer(gFrameStats, PHASE_EVENTS);
+            SDL_Event e;
+            while( SDL_PollEvent( &e ) != 0 ) if( e.type == SDL_QUIT ) return false;
+        }
+
+        {
+            PhaseTimer timer(gFrameStats, PHASE_SIMULATION);
+            WorldInput input = { gAutopilot != NULL ? gAutopilot->decide(gWorld) : heuristicFlap(gWorld) };
+            gWorld.step(input);
+            gSprites.update(1);
+            if (gWorld.points != shownPoints) updatePointsText(gWorld.points);
+        }
 
-    if (posXObj <= CHARACTER_X_POS+60 and posXObj + widthObj >= CHARACTER_X_POS){
-        if (posYObj <= posY + 60 and posYObj + heightObj >= posY ) collision = true;
+        renderWorld(gWorld, gWorld, 1);
+        if (gWorld.dead){
+            renderGameOver(gWorld.points);
+            games++;
+            if (gWorld.points > bestPoints) bestPoints = gWorld.points;
+            restart();
+        }
+
+        finishFrame();
+        //One tick per frame, so the video plays at the speed of the game however fast the benchmark goes
+        captureFrame(f);
+        PhaseTimer timer(gFrameStats, PHASE_PRESENT);
+        SDL_RenderPresent( gRenderer );
     }
+    double seconds = std::chrono::duration<double>(FrameStats::now() - start).count();
 
-    return collision;
+    FILE* file = output != NULL ? fopen(output, "w") : stdout;
+    if (file == NULL){
+        printf("Unable to write the benchmark results to %s\n", output);
+        return false;
+    }
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(gRenderer, &info) != 0) info.name = "unknown";
+    fprintf(file, "{\n  \"benchmark\": \"frames\",\n  \"video_driver\": \"%s\",\n  \"renderer\": \"%s\",\n", SDL_GetCurrentVideoDriver(), info.name);
+    fprintf(file, "  \"blitter\": \"%s\",\n", gSoftCanvas.isCreated() ? getBlitKernelName(gBlitKernel) : "sdl");
+    fprintf(file, "  \"collision\": \"%s\",\n", gWorld.masks != NULL ? "pixels" : "boxes");
+    fprintf(file, "  \"render_scale\": { \"auto\": %s, \"final\": %.3f, \"lowest\": %.3f, \"changes\": %d },\n", gResolution.isAuto() ? "true" : "false",
+            gScaledTarget.getScale(), gResolution.isAuto() ? RESOLUTION_LEVELS[gResolution.getLowestLevel()] : gScaledTarget.getScale(), gResolution.getChangeCount());
+    if (gCapture.isCapturing()) fprintf(file, "  \"capture\": { \"captured\": %lld, \"dropped\": %lld, \"repeated\": %lld },\n", gCapture.getCaptured(), gCapture.getDropped(), gCapture.getRepeated());
+    else fprintf(file, "  \"capture\": null,\n");
+    fprintf(file, "  \"autopilot\": ");
+    if (gAutopilot != NULL) gAutopilot->writeJson(file);
+    else fprintf(file, "null");
+    fprintf(file, ",\n");
+    fprintf(file, "  \"frames\": %d,\n  \"seconds\": %.4f,\n  \"fps\": %.1f,\n  \"games\": %d,\n  \"best_points\": %lld,\n  \"phases\": ", frames, seconds, frames / seconds, games, bestPoints);
+    gFrameStats.writeJson(file);
+    fprintf(file, "\n}\n");
+    if (file != stdout) fclose(file);
+    return true;
 }
 
 int main( int argc, char* args[] )
 {
+	//FrameBench is this same game built with FRAME_BENCH, which only changes the default
+#ifdef FRAME_BENCH
+	bool benchmark = true;
+#else
+	bool benchmark = false;
+#endif
+	int benchmarkFrames = 3000;
+	const char* benchmarkOutput = NULL;
+	//--trace records every zone of every thread from the start, and writes them as Chrome trace JSON on exit
+	const char* tracePath = NULL;
+	setProfileThreadName( "main" );
+	bool autopilot = false;
+	double autopilotBudget = 4000;
+	int autopilotThreads = 0;
+	const char* capturePath = NULL;
+	int captureBuffers = 8;
+	int broadcastPort = 0;
+	int broadcastBudget = 64;
+	std::vector<std::string> ghostAddresses;
+	const char* replayPath = NULL;
+	int replayLastSeconds = -1;
+	std::string layers = "auto";
+	std::string blitter = "sdl";
+	for( int i = 1; i < argc; i++ )
+	{
+		std::string arg = args[i];
+		if( arg == "--benchmark" ) benchmark = true;
+		else if( arg == "--frames" && i + 1 < argc ) benchmarkFrames = atoi( args[++i] );
+		else if( arg == "--output" && i + 1 < argc ) benchmarkOutput = args[++i];
+		else if( arg == "--record" && i + 1 < argc ) gRecordPath = args[++i];
+		else if( arg == "--replay" && i + 1 < argc ) replayPath = args[++i];
+		else if( arg == "--last" && i + 1 < argc ) replayLastSeconds = atoi( args[++i] );
+		else if( arg == "--vsync" && i + 1 < argc ) gVsync = std::string( args[++i] ) != "off";
+		else if( arg == "--fps-cap" && i + 1 < argc ) gFpsCap = atoi( args[++i] );
+		else if( arg == "--layers" && i + 1 < argc ) layers = args[++i];
+		else if( arg == "--blitter" && i + 1 < argc ) blitter = args[++i];
+		else if( arg == "--rotation-step" && i + 1 < argc ) gRotationStep = atof( args[++i] );
+		else if( arg == "--rotation-cache-kb" && i + 1 < argc ) gRotationCacheKB = atoi( args[++i] );
+		else if( arg == "--texture-budget-mb" && i + 1 < argc ) gTextureBudgetMB = atoi( args[++i] );
+		else if( arg == "--box-collision" ) gPixelCollision = false;
+		else if( arg == "--sprites" && i + 1 < argc ) gSpriteCount = atoi( args[++i] );
+		else if( arg == "--sim-thread" && i + 1 < argc ) gSimThread = std::string( args[++i] ) != "off";
+		else if( arg == "--stall-ms" && i + 1 < argc ) gStallMs = atoi( args[++i] );
+		else if( arg == "--low-latency" ) gLowLatency = true;
+		else if( arg == "--capture" && i + 1 < argc ) capturePath = args[++i];
+		else if( arg == "--capture-buffers" && i + 1 < argc ) captureBuffers = atoi( args[++i] );
+		else if( arg == "--broadcast" && i + 1 < argc ) broadcastPort = atoi( args[++i] );
+		else if( arg == "--broadcast-budget" && i + 1 < argc ) broadcastBudget = atoi( args[++i] );
+		else if( arg == "--ghost" && i + 1 < argc ) ghostAddresses.push_back( args[++i] );
+		else if( arg == "--autopilot" ) autopilot = true;
+		else if( arg == "--autopilot-budget-us" && i + 1 < argc ) autopilotBudget = atof( args[++i] );
+		else if( arg == "--autopilot-threads" && i + 1 < argc ) autopilotThreads = atoi( args[++i] );
+		else if( arg == "--trace" && i + 1 < argc )
+		{
+			tracePath = args[++i];
+			setProfiling( true );
+		}
+		else if( arg == "--render-scale" && i + 1 < argc )
+		{
+			std::string scale = args[++i];
+			gResolution.setAuto( scale == "auto" );
+			if( scale != "auto" ) gRenderScale = std::min( std::max( atof( scale.c_str() ), 0.25 ), 1.0 );
+		}
+		else if( arg == "--draw-budget-ms" && i + 1 < argc ) gResolution.setTarget( atof( args[++i] ) * 1000 );
+		else printf( "Unknown option %s\n", args[i] );
+	}
+	//simd takes the best kernel of this CPU, the others force one to compare them
+	if( blitter != "sdl" )
+	{
+		gSoftBlitter = true;
+		gBlitKernel = getBlitKernel();
+		if( blitter == "scalar" ) gBlitKernel = BLIT_SCALAR;
+		else if( blitter == "sse2" ) gBlitKernel = BLIT_SSE2;
+		else if( blitter == "avx2" ) gBlitKernel = BLIT_AVX2;
+		else if( blitter != "simd" ) printf( "Unknown blitter %s, using simd\n", blitter.c_str() );
+		if( !blitKernelSupported( gBlitKernel ) )
+		{
+			printf( "This CPU can't run the %s blitter\n", getBlitKernelName( gBlitKernel ) );
+			gBlitKernel = getBlitKernel();
+		}
+	}
+	if( autopilot ) gAutopilot = new Autopilot( 150, benchmark ? 0 : autopilotBudget, autopilotThreads );
+	if( broadcastPort > 0 ) gBroadcast.start( broadcastPort, broadcastBudget );
+	for( size_t i = 0; i < ghostAddresses.size(); i++ )
+	{
+		GhostClient* client = new GhostClient();
+		if( client->connect( ghostAddresses[i] ) ) gGhostClients.push_back( client );
+		else delete client;
+	}
+
+	//The frames are paced by the ticks instead of the vsync
+	if( gLowLatency ) gVsync = false;
+	if( benchmark )
+	{
+		//It has to run on machines without a display. SDL_VIDEODRIVER still wins if it is set, for example to offscreen
+		gHeadless = true;
+		SDL_setenv( "SDL_VIDEODRIVER", "dummy", 0 );
+	}
+
 	//Start up SDL and create window
 	if( !init() )
 	{
@@ -333,11 +1112,31 @@ int main( int argc, char* args[] )
 	}
 	else
 	{
+		SDL_RendererInfo info;
+		bool software = SDL_GetRendererInfo( gRenderer, &info ) == 0 && ( info.flags & SDL_RENDERER_SOFTWARE );
+		gDirtyCompositing = layers == "dirty" || ( layers == "auto" && software );
+		gResources.setBudget( (size_t)gTextureBudgetMB * 1024 * 1024 );
+		int outputWidth, outputHeight;
+		if( capturePath != NULL && SDL_GetRendererOutputSize( gRenderer, &outputWidth, &outputHeight ) == 0 )
+		{
+			gCapture.start( capturePath, outputWidth, outputHeight, TICK_RATE, captureBuffers );
+		}
+
 		//Load media
-		if( !loadMedia() )
+		if( !loadMedia() || !buildLayers() )
 		{
 			printf( "Failed to load media!\n" );
 		}
+
+		else if( benchmark )
+		{
+			gWorld.masks = gPixelCollision ? &gPixelMasks : NULL;
+			if( !runBenchmark( benchmarkFrames, benchmarkOutput ) )
+			{
+				close();
+				return 1;
+			}
+		}
 		else
 		{
 			//Main loop flag
@@ -349,22 +1148,65 @@ int main( int argc, char* args[] )
 			//Handler about the state
 			bool pause = true;
 
-            restart();
-            SDL_SetRenderDrawColor(gRenderer,0xFF,0xAE,0xC9,0xFF);
-            SDL_RenderClear( gRenderer );
-            gTextTextureStart.render(gRenderer,SCREEN_WIDTH/2 - gTextTextureStart.getWidth() / 2,SCREEN_HEIGHT/2 - gTextTextureStart.getHeight() / 2);
-            SDL_RenderPresent( gRenderer );
+			//The game of the snapshot that is being drawn, and whether we already asked for a new one
+			int shownGame = 0;
+			bool restartAsked = false;
+			std::chrono::steady_clock::time_point pausedAt = FrameStats::now();
+			std::chrono::steady_clock::time_point lastDraw = pausedAt;
+
+            gSimulation.setRecording(&gReplay, gRecordPath);
+            gSimulation.setAutopilot(gAutopilot);
+            gSimulation.setBroadcast(gBroadcast.isRunning() ? &gBroadcast : NULL);
+            gSimulation.setCollision(gPixelCollision ? &gPixelMasks : NULL);
+            if (replayPath != NULL){
+                if (!gReplay.load(replayPath)){
+                    close();
+                    return 1;
+                }
+                //It is played again with the collision it was recorded with
+                gWorld.masks = gReplay.usesPixelCollision() ? &gPixelMasks : NULL;
+                //Everything before the last seconds is played without drawing it, thousands of times faster
+                int skip = 0;
+                if (replayLastSeconds >= 0) skip = std::max(0, gReplay.getTickCount() - replayLastSeconds * TICK_RATE);
+                int desync = gReplay.play(gWorld, skip);
+                if (desync >= 0) printf("The replay doesn't play the same since tick %d\n", desync);
+                gSimulation.watchReplay(&gReplay, skip, gWorld);
+            }else{
+                SDL_SetRenderDrawColor(gRenderer,0xFF,0xAE,0xC9,0xFF);
+                SDL_RenderClear( gRenderer );
+                gTextAtlas.render(gRenderer, START_TEXT, SCREEN_WIDTH/2 - gTextAtlas.getTextWidth(START_TEXT) / 2, SCREEN_HEIGHT/2 - gTextAtlas.getHeight() / 2, textColor);
+                SDL_RenderPresent( gRenderer );
+            }
+            if (gSimThread) gSimulation.start();
+            int frames = 0;
 
 			//Main loop
 			while( !quit )
 			{
-				//Handle events on queue
+				//With --low-latency we read the keys as late as they can still make it into the next tick
+				bool paced = gLowLatency && !pause;
+				std::chrono::steady_clock::time_point due;
+				if (paced){
+					gSimulation.update();
+					due = gSimulation.getSnapshot().time + TICK_DURATION;
+					waitUntil(due - std::chrono::microseconds(LATE_INPUT_MARGIN_US));
+				}
+				std::chrono::steady_clock::time_point frameStart = FrameStats::now();
+
+				//Handle events on queue. The keys go to the simulation with the time they were pressed
 				while( SDL_PollEvent( &e ) != 0 )
 				{
 					//User requests quit
 					if( e.type == SDL_QUIT )
 					{
 						quit = true;
+					}
+					//Some renderers lose what was drawn in the textures, like our background, when the window changes
+					else if( e.type == SDL_RENDER_TARGETS_RESET )
+					{
+						gBackground.rebuild();
+						gEggRotations.invalidate();
+						gDirty.invalidate();
 					}
 					 else if( e.type == SDL_KEYDOWN )
                     {
@@ -373,124 +1215,144 @@ int main( int argc, char* args[] )
                             case SDLK_ESCAPE:
                             quit = true;
                             break;
-                            
+
                             //Our egg is going to fly!!
                             case SDLK_UP:
-                            flying = MAXIMUN_FRAMES * 4 * 2;
-                            degrees = -45;
+                            {
+                                SimCommand flap = { COMMAND_FLAP, 0, eventTime(e.key.timestamp) };
+                                gSimulation.send(flap);
+                            }
                             break;
-                            
+
                             //Our game is going to start/restart
                             case SDLK_RETURN:
-                            if (pause){
-                                pause = !pause;
-                                restart();
+                            if (pause && !restartAsked){
+                                SimCommand restart = { COMMAND_RESTART, (unsigned int)rand(), eventTime(e.key.timestamp) };
+                                restartAsked = gSimulation.send(restart);
                             }
                         }
                     }
 				}
+				std::chrono::steady_clock::time_point eventsEnd = FrameStats::now();
+
+				//Without its thread, the simulation steps every tick that is due right here
+				if (!gSimThread){
+					if (paced) waitUntil(due);
+					gSimulation.advance(FrameStats::now());
+				}
+				else if (paced){
+					//The other thread steps it right when it is due, we wait for it a tick at most
+					while (gSimulation.getSnapshot().time < due && FrameStats::now() < due + TICK_DURATION){
+						if (!gSimulation.update()) std::this_thread::yield();
+					}
+				}
+				gSimulation.update();
+				const WorldSnapshot& snapshot = gSimulation.getSnapshot();
+				std::chrono::steady_clock::time_point drawTime = FrameStats::now();
+
+				//A new game: everything is drawn again
+				if (snapshot.game != shownGame){
+					shownGame = snapshot.game;
+					restartAsked = false;
+					pause = false;
+					gDirty.invalidate();
+					updatePointsText(snapshot.current.points);
+				}
 
 				if (!pause){
-                    SDL_SetRenderDrawColor(gRenderer,0xFF,0xAE,0xC9,0xFF);
-
-                    //Clear screen
-                    SDL_RenderClear( gRenderer );
-
-                    //This is how we spawn new pipes. We reset the timer, put the pipe at the end of the Screen, select the random free spot and set the next Pipe that we are going to paint
-                    //The max pipes that we are going to allow is 7; so we don't use too much memory
-                    if (timingPipe == 0){
-                        timingPipe = MAX_TIME_PIPE;
-                        pipes[nextPipe].xPosition = SCREEN_WIDTH;
-                        pipes[nextPipe].freeSpotPosition = (rand() % 4) + 1;
-                        pipes[nextPipe].pointCounted = false;
-                        nextPipe = (nextPipe  + 1)% 7;
-                        if (totalPipe < 7) totalPipe++;
-                        }
+                    //While paused nothing is drawn and the loop just waits for a key, so only the played frames are timed
+                    gFrameStats.add(PHASE_EVENTS, std::chrono::duration<double, std::micro>(eventsEnd - frameStart).count());
+                    gFrameStats.add(PHASE_SIMULATION, std::chrono::duration<double, std::micro>(drawTime - eventsEnd).count());
+                    addProfileZone(PHASE_NAMES[PHASE_EVENTS], frameStart, eventsEnd);
+                    addProfileZone(PHASE_NAMES[PHASE_SIMULATION], eventsEnd, drawTime);
+                    if (snapshot.current.points != shownPoints) updatePointsText(snapshot.current.points);
+
+                    //The sprites that aren't part of the world play at the same TICK_RATE, by the time between frames
+                    gSprites.update((float)(std::chrono::duration<double>(drawTime - lastDraw).count() * TICK_RATE));
+                    lastDraw = drawTime;
+                    updateGhosts();
+
+                    //YOU'VE LOST, BABY!
+                    if (snapshot.ended){
+                            pause = true;
+                            pausedAt = drawTime;
+                            renderWorld(snapshot.current, snapshot.current, 1);
+                            renderGameOver(snapshot.current.points);
+                    }
+                    else{
+                        //Between the last two ticks, by how long ago the last one was due. Paced frames show the tick that was just stepped
+                        double alpha = paced ? 1 : std::chrono::duration<double>(drawTime - snapshot.time).count() / TICK_SECONDS;
+                        renderWorld(snapshot.previous, snapshot.current, std::min(std::max(alpha, 0.0), 1.0));
+                    }
 
-                    --timingPipe;
-
-                    //Firstly we draw the sun
-                    gSunTexture.render(gRenderer,0,0);
-
-                    //Now we draw all the pipes.
-                    for (int i = 0; i < totalPipe; i++){
-                        int yPos = 0;
-                        int free = pipes[i].freeSpotPosition;
-                        //Here we are going to count the points. When the pipe past the character position, we flag it as counted and increment the points
-                        if (pipes[i].xPosition < (CHARACTER_X_POS) and !pipes[i].pointCounted){
-                            points++;
-                            pipes[i].pointCounted = true;
-                            std::stringstream ss;
-                            ss << points;
-                            if( !gTextTexturePoints.loadFromRenderedText( "Points: " + ss.str(), textColor, gFont ,gRenderer ) )
-                                {
-                                    printf( "Failed to render text texture of points!\n" );
-                                }
-                        }
-                        //And here we draw all the textures in the pipe
-                        for (int j = 0; j < 10; j++){
-                                    if (j == free) yPos += FREE_SPACE;
-                                    else {
-                                        pipes[i].xPosition = pipes[i].xPosition - PIPE_MOVEMENT;
-                                        if (collisionWithCharacter(pipes[i].xPosition, yPos , 75, 100)) pause = true;
-                                        gPipeTexture.render(gRenderer,pipes[i].xPosition,yPos);
-                                        yPos += gPipeTexture.getHeight();
-                                        }}}
-
-                    gTextTexturePoints.render(gRenderer,SCREEN_WIDTH - (gTextTexturePoints.getWidth() + 20), 10);
-                    //Now we render the floor on top of the pipe
-                    gFloorTexture.render(gRenderer,0,SCREEN_HEIGHT-gFloorTexture.getHeight());
-
-                    //We select the frame of the egg that we're going to paint
-                    SDL_Rect* currentClip = &gSpriteClips[frame / 4];
-                    gSpritedMonigote.render(gRenderer,CHARACTER_X_POS, posY , currentClip, degrees,NULL);
-
-                    //This case is when our egg if falling. We accelerate until reaching the maximum speed (15px), we rotate the animation and we set the position
-                    if (flying < 0 ){
-                        if (flying > -15)
-                            flying = flying * 1.1112;
-                        if (degrees <= 80 ) degrees += 3;
-                        if (posY <= SCREEN_HEIGHT - gFloorTexture.getHeight() - currentClip->h + flying )
-                                posY -= flying;
-                        else {
-                                posY = SCREEN_HEIGHT - gFloorTexture.getHeight() - currentClip->h;
-                                //YOU'VE LOST, BABY!
-                                pause = true;
-                        }}
-
-                    //This case is when we stop flying and start falling
-                    if (flying == 0){
-                        flying = -1;
-                        degrees = 0;}
-
-                    //This case is when we are flying. We rotate the animation, set the frame and fly a little bit
-                    if (flying >0){
-                        degrees = -45;
-                        --flying;
-                        ++frame;
-                        if (posY > CHARACTER_MOVEMENT) posY -= CHARACTER_MOVEMENT;
-                        if (frame/4 >= MAXIMUN_FRAMES){
-                            frame = 0;}}
-                    else
-                        {frame = 0;
+                    //Update screen
+                    finishFrame();
+                    captureFrame(gCapture.getPosition(FrameStats::now()));
+                    {
+                        PhaseTimer timer(gFrameStats, PHASE_PRESENT);
+                        if (gStallMs > 0 && ++frames % 60 == 0) SDL_Delay(gStallMs);
+                        if (gLowLatency){
+                            //Reading a pixel back waits until the GPU has drawn the frame, so the present doesn't queue it behind others
+                            Uint32 pixel;
+                            SDL_Rect first = { 0, 0, 1, 1 };
+                            SDL_RenderReadPixels( gRenderer, &first, SDL_PIXELFORMAT_ARGB8888, &pixel, sizeof(pixel) );
                         }
-
-                    if (pause){
-                            std::stringstream ss;
-                            ss << points;
-                            if( !gTextTexturePoints.loadFromRenderedText( "Congratulations... or maybe not. You've reach " + ss.str() + " points. Press Enter to restart, and Esc to exit", textColor, gFont ,gRenderer ) )
-                                {
-                                    printf( "Failed to render text texture of restart!\n" );
-                                } else{
-                                    gFrameTexture.setAlpha(0xA0);
-                                    gFrameTexture.render(gRenderer, SCREEN_WIDTH/2 - gFrameTexture.getWidth() /2, SCREEN_HEIGHT/2 - gFrameTexture.getHeight() / 2);
-                                    gTextTexturePoints.render(gRenderer,SCREEN_WIDTH/2 - gTextTexturePoints.getWidth() /2, SCREEN_HEIGHT/2);}
+                        SDL_RenderPresent( gRenderer );
                     }
-                    //Update screen
-                    SDL_RenderPresent( gRenderer );			}}
+                    addInputLatency(snapshot.tick, FrameStats::now());
+                    std::chrono::steady_clock::time_point frameEnd = FrameStats::now();
+                    gFrameStats.add(PHASE_FRAME, std::chrono::duration<double, std::micro>(frameEnd - frameStart).count());
+                    addProfileZone(PHASE_NAMES[PHASE_FRAME], frameStart, frameEnd);
+                    waitForFrameCap(frameStart);
+                }
+                else{
+                    //The autopilot starts the first game at once, and every other one a while after losing
+                    if (gAutopilot != NULL && replayPath == NULL && !restartAsked &&
+                        (shownGame == 0 || std::chrono::duration<double>(FrameStats::now() - pausedAt).count() > AUTOPILOT_RESTART_SECONDS)){
+                        SimCommand restart = { COMMAND_RESTART, (unsigned int)rand(), FrameStats::now() };
+                        restartAsked = gSimulation.send(restart);
+                    }
+                    pollGhosts();
+
+                    //Nothing moves, so we don't need to spin
+                    SDL_Delay(1);
+                }
+			}
+
+			//A game left in the middle is saved too
+			gSimulation.stop();
+
+			//How long the frames took while playing, and how steady the ticks were
+			gFrameStats.print(stdout);
+			gSimulation.printStats(stdout);
+			if (gAutopilot != NULL) gAutopilot->printStats(stdout);
+			if (gBroadcast.isRunning()) gBroadcast.printStats(stdout);
+			for (size_t i = 0; i < gGhostClients.size(); i++) gGhostClients[i]->printStats(stdout);
+			if (gResolution.isAuto()) printf("render scale: %.3f at the end, down to %.3f, %d changes\n", gScaledTarget.getScale(),
+			                                 RESOLUTION_LEVELS[gResolution.getLowestLevel()], gResolution.getChangeCount());
+			if (gLatencyStats.getCount(LATENCY_INPUT_TO_PRESENT) > 0){
+				printf("input latency%s:\n", gLowLatency ? " (low latency mode)" : "");
+				gLatencyStats.print(stdout);
+			}
 		}
 	}
-	
+
+	//The frames that are still waiting are written before the numbers are
+	if( gCapture.isCapturing() )
+	{
+		gCapture.stop();
+		gCapture.printStats( stdout );
+	}
+
+	//The workers and the simulation are done, so the rings don't change while they are written
+	if( tracePath != NULL ) writeChromeTrace( tracePath );
+
+	delete gAutopilot;
+	gAutopilot = NULL;
+	gBroadcast.stop();
+	for( size_t i = 0; i < gGhostClients.size(); i++ ) delete gGhostClients[i];
+	gGhostClients.clear();
+
 	//Free resources and close SDL
 	close();
 
@@ -0,0 +1,111 @@
+/** Writes assets.pack: the game atlas already decoded, keyed and in the pixel format of the renderer, and the bytes of the font.
+    With it the game starts without decoding any png. Run it from the folder with the images and the font,
+    on the machine that plays the game, after changing any of them.
+    Usage: AssetPacker
+*/
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdio.h>
+#include "Atlas.h"
+#include "AssetPack.h"
+
+//The format the renderer of this machine likes the most. We ask a hidden window, and use ARGB if it can't tell
+Uint32 nativeFormat()
+{
+    Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+    SDL_Window* window = SDL_CreateWindow( "AssetPacker", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 16, 16, SDL_WINDOW_HIDDEN );
+    if( window == NULL ) return format;
+
+    SDL_Renderer* renderer = SDL_CreateRenderer( window, -1, SDL_RENDERER_ACCELERATED );
+    SDL_RendererInfo info;
+    if( renderer != NULL && SDL_GetRendererInfo( renderer, &info ) == 0 )
+    {
+        //The first format with alpha, which is what the keyed images need
+        for( Uint32 i = 0; i < info.num_texture_formats; i++ )
+        {
+            Uint32 candidate = info.texture_formats[i];
+            if( SDL_ISPIXELFORMAT_ALPHA( candidate ) && SDL_BYTESPERPIXEL( candidate ) == 4 && !SDL_ISPIXELFORMAT_FOURCC( candidate ) )
+            {
+                format = candidate;
+                break;
+            }
+        }
+        printf( "Renderer: %s\n", info.name );
+    }
+    if( renderer != NULL ) SDL_DestroyRenderer( renderer );
+    SDL_DestroyWindow( window );
+    return format;
+}
+
+bool readFile( const char* path, std::vector<char>& bytes )
+{
+    FILE* file = fopen( path, "rb" );
+    if( file == NULL )
+    {
+        printf( "Unable to read %s\n", path );
+        return false;
+    }
+    char buffer[4096];
+    size_t read;
+    while( ( read = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 ) bytes.insert( bytes.end(), buffer, buffer + read );
+    fclose( file );
+    return !bytes.empty();
+}
+
+int main( int argc, char* args[] )
+{
+    if( SDL_Init( SDL_INIT_VIDEO ) < 0 )
+    {
+        printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+        return 1;
+    }
+    int imgFlags = IMG_INIT_PNG;
+    if( !( IMG_Init( imgFlags ) & imgFlags ) )
+    {
+        printf( "SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError() );
+        SDL_Quit();
+        return 1;
+    }
+
+    Uint32 format = nativeFormat();
+    printf( "Pixel format: %s\n", SDL_GetPixelFormatName( format ) );
+
+    std::vector<AssetPackItem> items( 2 );
+    bool success = true;
+
+    //The atlas, with its regions
+    AssetPackItem& atlas = items[0];
+    atlas.name = ATLAS_IMAGE;
+    atlas.surface = NULL;
+    SDL_Surface* keyed = buildGameAtlas( atlas.regions );
+    if( keyed != NULL )
+    {
+        atlas.surface = SDL_ConvertSurfaceFormat( keyed, format, 0 );
+        SDL_FreeSurface( keyed );
+    }
+    if( atlas.surface == NULL )
+    {
+        printf( "Failed to pack the atlas!\n" );
+        success = false;
+    }
+
+    //The font as it is, TTF_OpenFontRW reads it from the pack
+    AssetPackItem& font = items[1];
+    font.name = FONT_FILE;
+    font.surface = NULL;
+    if( !readFile( FONT_FILE, font.bytes ) ) success = false;
+
+    if( success ) success = writeAssetPack( ASSET_PACK, items );
+    if( success )
+    {
+        printf( "%s:\n", ASSET_PACK );
+        printf( "  %-16s %d x %d, %d regions\n", atlas.name.c_str(), atlas.surface->w, atlas.surface->h, (int)atlas.regions.size() );
+        printf( "  %-16s %d bytes\n", font.name.c_str(), (int)font.bytes.size() );
+    }
+
+    if( atlas.surface != NULL ) SDL_FreeSurface( atlas.surface );
+    IMG_Quit();
+    SDL_Quit();
+    return success ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+/** Packs the images of the game in one atlas and writes it next to them, with its manifest.
+    Run it from the folder with the images, after changing any of them.
+    Usage: AtlasPacker
+*/
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdio.h>
+#include "Atlas.h"
+
+int main( int argc, char* args[] )
+{
+    int imgFlags = IMG_INIT_PNG;
+    if( !( IMG_Init( imgFlags ) & imgFlags ) )
+    {
+        printf( "SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError() );
+        return 1;
+    }
+
+    std::vector<AtlasRegion> regions;
+    SDL_Surface* atlas = buildGameAtlas( regions );
+    if( atlas == NULL )
+    {
+        printf( "Failed to pack the atlas!\n" );
+        IMG_Quit();
+        return 1;
+    }
+
+    bool success = true;
+    if( IMG_SavePNG( atlas, ATLAS_IMAGE ) != 0 )
+    {
+        printf( "Unable to save %s! SDL_image Error: %s\n", ATLAS_IMAGE, IMG_GetError() );
+        success = false;
+    }
+    if( !saveAtlasManifest( ATLAS_MANIFEST, regions ) ) success = false;
+
+    if( success )
+    {
+        printf( "%s: %d x %d\n", ATLAS_IMAGE, atlas->w, atlas->h );
+        for( size_t i = 0; i < regions.size(); i++ )
+        {
+            const SDL_Rect& rect = regions[i].rect;
+            printf( "  %-14s %4d %4d %4d %4d\n", regions[i].name.c_str(), rect.x, rect.y, rect.w, rect.h );
+        }
+    }
+
+    SDL_FreeSurface( atlas );
+    IMG_Quit();
+    return success ? 0 : 1;
+}
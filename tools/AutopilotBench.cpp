@@ -0,0 +1,67 @@
+/** Plays headless games with the autopilot on more and more threads, and tells how many nodes per second it searches
+    and how long its decisions take, to know what machine a station needs.
+    Usage: AutopilotBench [ticks] [budget-us] [horizon] [max-threads] [pixels|boxes]
+    It collides with the pixel masks like the game, so it needs the game images in the working directory, or with boxes.
+    Every thread count plays the same seeds. It also counts how often the plan of the previous tick still survives,
+    the first branch that every search tries.
+*/
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include "Autopilot.h"
+#include "Atlas.h"
+#include "CollisionMask.h"
+
+int main( int argc, char* args[] )
+{
+    int ticks = argc > 1 ? atoi(args[1]) : 20000;
+    double budget = argc > 2 ? atof(args[2]) : 4000;
+    int horizon = argc > 3 ? atoi(args[3]) : 150;
+    int maxThreads = argc > 4 ? atoi(args[4]) : (int)std::thread::hardware_concurrency();
+    if (maxThreads < 1) maxThreads = 1;
+    std::string collision = argc > 5 ? args[5] : "pixels";
+    if (collision != "pixels" and collision != "boxes"){
+        printf("The collision is pixels or boxes\n");
+        return 1;
+    }
+
+    PixelMasks masks;
+    if (collision == "pixels"){
+        std::vector<AtlasRegion> regions;
+        SDL_Surface* atlas = buildGameAtlas(regions);
+        bool built = atlas != NULL and buildGameMasks(atlas, regions, masks);
+        if (atlas != NULL) SDL_FreeSurface(atlas);
+        if (!built){
+            printf("The pixel masks can't be made without the game images, boxes can be asked for instead\n");
+            return 1;
+        }
+    }
+
+    printf("%d ticks, %.0f us per tick at most, %d ticks ahead, collision with the %s\n", ticks, budget, horizon, collision.c_str());
+    for (int threads = 1; threads <= maxThreads; threads *= 2){
+        Autopilot autopilot(horizon, budget, threads);
+        World world;
+        if (collision == "pixels") world.masks = &masks;
+        unsigned int seed = 1;
+        world.restart(seed);
+        int bestPoints = 0, deaths = 0;
+        for (int t = 0; t < ticks; t++){
+            WorldInput input = { autopilot.decide(world) };
+            world.step(input);
+            if (world.dead){
+                deaths++;
+                if (world.points > bestPoints) bestPoints = world.points;
+                world.restart(++seed);
+                autopilot.reset();
+            }
+        }
+        if (world.points > bestPoints) bestPoints = world.points;
+        printf("%2d threads: %7.2f M nodes/s, %7.1f us per decision, worst %7.1f us, %lld out of budget, plan kept %5.1f%%, %d deaths, best %d points\n",
+               autopilot.getThreadCount(), autopilot.getNodesPerSecond() / 1e6, autopilot.getSearchSeconds() * 1e6 / autopilot.getDecisions(),
+               autopilot.getWorstMicroseconds(), autopilot.getTimeouts(), 100.0 * autopilot.getCarriedPlans() / autopilot.getDecisions(), deaths, bestPoints);
+    }
+    return 0;
+}
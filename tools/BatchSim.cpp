@@ -0,0 +1,85 @@
+/** Steps a lot of headless worlds at the same time and tells how many ticks per second we get.
+    The first checked worlds are also played with World::step, and every tick both have to end up the same.
+    Usage: BatchSim [worlds] [ticks] [threads] [checked]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "WorldBatch.h"
+
+//A very simple player: it flaps when the egg is under the middle of the hole of the next pipe
+bool wantsToFlap(const WorldBatch& batch, int w){
+    if (batch.flying[w] >= 0) return false;
+
+    int target = SCREEN_HEIGHT / 2;
+    int nearest = SCREEN_WIDTH * 2;
+    for (int i = 0; i < batch.pipeCount[w]; i++){
+        int x = batch.pipeX[batch.pipeSlot(w, i)];
+        if (x + PIPE_COLLISION_WIDTH >= CHARACTER_X_POS and x < nearest){
+            nearest = x;
+            target = batch.pipeFree[batch.pipeSlot(w, i)] * PIPE_TILE_HEIGHT + FREE_SPACE / 2;
+        }
+    }
+    return batch.posY[w] + CHARACTER_SIZE / 2 > target + 30;
+}
+
+int main( int argc, char* args[] )
+{
+    int worlds = argc > 1 ? atoi(args[1]) : 4096;
+    int ticks = argc > 2 ? atoi(args[2]) : 10000;
+    int threads = argc > 3 ? atoi(args[3]) : 0;
+    int checked = argc > 4 ? atoi(args[4]) : 256;
+    if (worlds <= 0 or ticks < 0 or checked < 0){
+        printf("Usage: BatchSim [worlds] [ticks] [threads] [checked], with at least one world\n");
+        return 1;
+    }
+    if (checked > worlds) checked = worlds;
+
+    ThreadPool pool(threads);
+    WorldBatch batch(worlds);
+    std::vector<WorldInput> inputs(worlds);
+    long long games = 0;
+    long long bestPoints = 0;
+
+    //The same worlds stepped one by one with the rules of World, outside the timing of the batch
+    std::vector<World> reference(checked);
+    for (int w = 0; w < checked; w++) reference[w] = batch.getWorld(w);
+    long long mismatches = 0;
+
+    for (int t = 0; t < ticks; t++){
+        pool.parallelFor(worlds, 1024, [&](int begin, int end){
+            for (int w = begin; w < end; w++) inputs[w].flap = wantsToFlap(batch, w);
+        });
+
+        batch.step(&inputs[0], pool);
+
+        for (int w = 0; w < checked; w++){
+            reference[w].step(inputs[w]);
+            World stepped = batch.getWorld(w);
+            if (stepped.checksum() != reference[w].checksum()){
+                if (mismatches == 0) printf("World %d is not the same as World::step at tick %d\n", w, t);
+                mismatches++;
+                //Once is enough to know, they start together again
+                reference[w] = stepped;
+            }
+        }
+
+        //The dead ones start a new game straight away
+        for (int w = 0; w < worlds; w++){
+            if (batch.dead[w]){
+                if (batch.points[w] > bestPoints) bestPoints = batch.points[w];
+                games++;
+                unsigned int seed = batch.seed[w];
+                batch.restart(w, seed);
+                if (w < checked) reference[w].restart(seed);
+            }
+        }
+    }
+
+    printf("worlds: %d, ticks: %d, threads: %d\n", worlds, ticks, pool.getThreadCount());
+    printf("games finished: %lld, best points: %lld\n", games, bestPoints);
+    printf("ticks per second: %.0f\n", batch.getTicksPerSecond());
+    printf("checked against World::step: %d worlds, %lld mismatches\n", checked, mismatches);
+    return mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,237 @@
+/** Checks the kernels of the software blitter against each other and against SDL's own software blits,
+    and then measures how many pixels per second each one draws, SDL included.
+    Usage: BlitBench [rounds]
+    Returns 1 if the kernels don't give exactly the same pixels, or if the color keyed copy doesn't match SDL.
+    The blend and the rotation are compared with SDL too, but SDL picks different blitters and rotation code
+    depending on its version and the CPU, so for them it only reports how far they are.
+*/
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "SoftBlit.h"
+
+const BlitKernel KERNELS[] = { BLIT_SCALAR, BLIT_SSE2, BLIT_AVX2 };
+const int KERNEL_COUNT = 3;
+
+const int CANVAS_WIDTH = 1600;
+const int CANVAS_HEIGHT = 900;
+const Uint32 KEY = 0xFFFF0000;
+
+enum BlitOperation{
+    OPERATION_KEY,
+    OPERATION_BLEND,
+    OPERATION_BLEND_ALPHA,
+    OPERATION_ROTATE,
+    OPERATION_COUNT
+};
+const char* const OPERATION_NAMES[OPERATION_COUNT] = { "color key", "blend", "blend alpha 0xA0", "rotate" };
+
+//An ARGB8888 surface, by its masks: SDL_CreateRGBSurfaceWithFormat needs SDL 2.0.5
+SDL_Surface* createSurface(int width, int height){
+    return SDL_CreateRGBSurface(0, width, height, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+}
+
+//The renderer can keep the copies in a queue until it is flushed, since SDL 2.0.10. Before that it draws them right away
+void flushRenderer(SDL_Renderer* renderer){
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+    SDL_RenderFlush(renderer);
+#else
+    (void)renderer;
+#endif
+}
+
+//Random pixels with every kind of alpha, and some of them with the color of the key
+SDL_Surface* randomImage(int width, int height, bool keyed){
+    SDL_Surface* image = createSurface(width, height);
+    if (image == NULL) return NULL;
+    for (int y = 0; y < height; y++){
+        Uint32* row = (Uint32*)((Uint8*)image->pixels + y * image->pitch);
+        for (int x = 0; x < width; x++){
+            Uint32 pixel = (Uint32)rand() << 16 ^ (Uint32)rand();
+            int kind = rand() % 8;
+            if (kind == 0) pixel &= 0x00FFFFFF;
+            else if (kind == 1) pixel |= 0xFF000000;
+            else if (kind == 2 and keyed) pixel = (pixel & 0xFF000000) | (KEY & 0x00FFFFFF);
+            row[x] = pixel;
+        }
+    }
+    return image;
+}
+
+PixelView viewOf(SDL_Surface* surface){
+    PixelView view = { (uint32_t*)surface->pixels, surface->w, surface->h, surface->pitch / 4 };
+    return view;
+}
+
+void blit(BlitOperation operation, BlitKernel kernel, const PixelView& dst, int x, int y, const PixelView& src, double degrees){
+    switch (operation){
+        case OPERATION_KEY: blitColorKey(dst, x, y, src, KEY, kernel); break;
+        case OPERATION_BLEND: blitBlend(dst, x, y, src, 255, kernel); break;
+        case OPERATION_BLEND_ALPHA: blitBlend(dst, x, y, src, 0xA0, kernel); break;
+        default: blitRotated(dst, x, y, src, degrees, kernel); break;
+    }
+}
+
+//The same with SDL: surface blits for the copies and the software renderer for the rotation
+void blitSDL(BlitOperation operation, SDL_Surface* dst, SDL_Renderer* renderer, int x, int y, SDL_Surface* src, SDL_Texture* texture, double degrees){
+    SDL_Rect rect = { x, y, src->w, src->h };
+    if (operation == OPERATION_ROTATE){
+        SDL_RenderCopyEx(renderer, texture, NULL, &rect, degrees, NULL, SDL_FLIP_NONE);
+        return;
+    }
+    SDL_SetColorKey(src, operation == OPERATION_KEY, KEY);
+    SDL_SetSurfaceBlendMode(src, operation == OPERATION_KEY ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+    SDL_SetSurfaceAlphaMod(src, operation == OPERATION_BLEND_ALPHA ? 0xA0 : 0xFF);
+    SDL_BlitSurface(src, NULL, dst, &rect);
+}
+
+//How many pixels differ between two surfaces, and by how much at most in any channel
+int comparePixels(SDL_Surface* a, SDL_Surface* b, int& maxDifference){
+    int different = 0;
+    maxDifference = 0;
+    for (int y = 0; y < a->h; y++){
+        const Uint32* rowA = (const Uint32*)((const Uint8*)a->pixels + y * a->pitch);
+        const Uint32* rowB = (const Uint32*)((const Uint8*)b->pixels + y * b->pitch);
+        for (int x = 0; x < a->w; x++){
+            if (rowA[x] == rowB[x]) continue;
+            different++;
+            for (int shift = 0; shift < 32; shift += 8){
+                int difference = abs((int)((rowA[x] >> shift) & 0xFF) - (int)((rowB[x] >> shift) & 0xFF));
+                if (difference > maxDifference) maxDifference = difference;
+            }
+        }
+    }
+    return different;
+}
+
+//A spot of the canvas for the i-th blit. Some of them are partly outside, to test the clipping
+void blitPosition(int i, const SDL_Surface* src, int& x, int& y, double& degrees){
+    x = (i * 397) % (CANVAS_WIDTH + src->w) - src->w / 2;
+    y = (i * 211) % (CANVAS_HEIGHT + src->h) - src->h / 2;
+    degrees = (i * 37) % 720 - 360 + 0.25 * (i % 4);
+}
+
+int main( int argc, char* args[] )
+{
+    int rounds = argc > 1 ? atoi(args[1]) : 2000;
+    if (rounds < 1) rounds = 1;
+    if (SDL_Init(0) < 0){
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
+    srand(1);
+
+    //A sprite of the size of the egg, and the background it goes on
+    SDL_Surface* keyedSprite = randomImage(61, 59, true);
+    SDL_Surface* sprite = randomImage(60, 60, false);
+    SDL_Surface* background = randomImage(CANVAS_WIDTH, CANVAS_HEIGHT, false);
+    SDL_Surface* canvas = createSurface(CANVAS_WIDTH, CANVAS_HEIGHT);
+    SDL_Surface* reference = createSurface(CANVAS_WIDTH, CANVAS_HEIGHT);
+    SDL_Surface* sdlCanvas = createSurface(CANVAS_WIDTH, CANVAS_HEIGHT);
+    SDL_Renderer* renderer = sdlCanvas != NULL ? SDL_CreateSoftwareRenderer(sdlCanvas) : NULL;
+    SDL_Texture* texture = renderer != NULL ? SDL_CreateTextureFromSurface(renderer, sprite) : NULL;
+    if (keyedSprite == NULL or sprite == NULL or background == NULL or canvas == NULL or reference == NULL or texture == NULL){
+        printf("Unable to create the images! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    SDL_SetSurfaceBlendMode(background, SDL_BLENDMODE_NONE);
+    PixelView canvasView = viewOf(canvas);
+    PixelView referenceView = viewOf(reference);
+
+    //A few hundred blits of each operation on top of each other, with every kernel and with SDL
+    const int CHECK_BLITS = 300;
+    bool equal = true;
+    for (int o = 0; o < OPERATION_COUNT; o++){
+        BlitOperation operation = (BlitOperation)o;
+        SDL_Surface* src = operation == OPERATION_KEY ? keyedSprite : sprite;
+        SDL_BlitSurface(background, NULL, reference, NULL);
+        SDL_BlitSurface(background, NULL, sdlCanvas, NULL);
+        for (int i = 0; i < CHECK_BLITS; i++){
+            int x, y;
+            double degrees;
+            blitPosition(i, src, x, y, degrees);
+            blit(operation, BLIT_SCALAR, referenceView, x, y, viewOf(src), degrees);
+            blitSDL(operation, sdlCanvas, renderer, x, y, src, texture, degrees);
+        }
+        flushRenderer(renderer);
+
+        for (int k = 1; k < KERNEL_COUNT; k++){
+            if (!blitKernelSupported(KERNELS[k])) continue;
+            SDL_BlitSurface(background, NULL, canvas, NULL);
+            for (int i = 0; i < CHECK_BLITS; i++){
+                int x, y;
+                double degrees;
+                blitPosition(i, src, x, y, degrees);
+                blit(operation, KERNELS[k], canvasView, x, y, viewOf(src), degrees);
+            }
+            int maxDifference;
+            int different = comparePixels(canvas, reference, maxDifference);
+            if (different > 0){
+                printf("MISMATCH %s %s: %d pixels differ from scalar, by up to %d\n", getBlitKernelName(KERNELS[k]), OPERATION_NAMES[o], different, maxDifference);
+                equal = false;
+            }
+        }
+
+        int maxDifference;
+        int different = comparePixels(sdlCanvas, reference, maxDifference);
+        printf("%-17s vs SDL: %d of %d pixels differ, by up to %d\n", OPERATION_NAMES[o], different, CANVAS_WIDTH * CANVAS_HEIGHT, maxDifference);
+        if (operation == OPERATION_KEY and different > 0){
+            printf("MISMATCH the color keyed copy must be the same as SDL's\n");
+            equal = false;
+        }
+    }
+    if (!equal) return 1;
+    printf("Every kernel gives the same pixels\n\n");
+
+    printf("%-17s %10s %10s %10s %10s (Mpixels/s)\n", "operation", "sdl", "scalar", "sse2", "avx2");
+    for (int o = 0; o < OPERATION_COUNT; o++){
+        BlitOperation operation = (BlitOperation)o;
+        SDL_Surface* src = operation == OPERATION_KEY ? keyedSprite : sprite;
+        double pixels = (double)rounds * src->w * src->h;
+        printf("%-17s", OPERATION_NAMES[o]);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++){
+            int x, y;
+            double degrees;
+            blitPosition(i, src, x, y, degrees);
+            blitSDL(operation, sdlCanvas, renderer, x, y, src, texture, degrees);
+        }
+        flushRenderer(renderer);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf(" %10.1f", pixels / seconds / 1e6);
+
+        for (int k = 0; k < KERNEL_COUNT; k++){
+            if (!blitKernelSupported(KERNELS[k])){
+                printf(" %10s", "-");
+                continue;
+            }
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < rounds; i++){
+                int x, y;
+                double degrees;
+                blitPosition(i, src, x, y, degrees);
+                blit(operation, KERNELS[k], canvasView, x, y, viewOf(src), degrees);
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf(" %10.1f", pixels / seconds / 1e6);
+        }
+        printf("\n");
+    }
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(keyedSprite);
+    SDL_FreeSurface(sprite);
+    SDL_FreeSurface(background);
+    SDL_FreeSurface(canvas);
+    SDL_FreeSurface(reference);
+    SDL_FreeSurface(sdlCanvas);
+    SDL_Quit();
+    return 0;
+}
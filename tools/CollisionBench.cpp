@@ -0,0 +1,144 @@
+/** Checks that the segment kernels give the same hit/miss answers as testing every pipe slot with collisionWithCharacter,
+    and then measures how fast each one is.
+    Usage: CollisionBench [scenarios] [rounds]
+    Returns 1 if any kernel disagrees with the slot by slot test.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include "Collision.h"
+
+//The way the game used to test a world: every solid slot of every pipe, one box at a time
+bool slotsHitCharacter(const Pipe* pipes, int totalPipe, int posY){
+    bool collision = false;
+    for (int i = 0; i < totalPipe; i++){
+        int yPos = 0;
+        for (int j = 0; j < PIPE_SLOTS; j++){
+            if (j == pipes[i].freeSpotPosition) yPos += FREE_SPACE;
+            else {
+                if (collisionWithCharacter(posY, pipes[i].xPosition, yPos, PIPE_COLLISION_WIDTH, PIPE_COLLISION_HEIGHT)) collision = true;
+                yPos += PIPE_TILE_HEIGHT;
+            }
+        }
+    }
+    return collision;
+}
+
+//One egg and the pipes around it
+struct Scenario{
+    Pipe pipes[MAX_PIPES];
+    int totalPipe;
+    int posY;
+    SegmentList segments;
+};
+
+const CollisionKernel KERNELS[] = { COLLISION_SCALAR, COLLISION_SSE2, COLLISION_AVX2 };
+const int KERNEL_COUNT = 3;
+
+bool runKernel(CollisionKernel kernel, const SegmentList& segments, int posY){
+    switch (kernel){
+        case COLLISION_AVX2: return segmentsHitCharacterAVX2(segments, posY);
+        case COLLISION_SSE2: return segmentsHitCharacterSSE2(segments, posY);
+        default: return segmentsHitCharacterScalar(segments, posY);
+    }
+}
+
+//Compares one scenario against every supported kernel and tells which one failed, if any
+bool checkScenario(const Scenario& scenario){
+    bool expected = slotsHitCharacter(scenario.pipes, scenario.totalPipe, scenario.posY);
+    for (int k = 0; k < KERNEL_COUNT; k++){
+        if (!collisionKernelSupported(KERNELS[k])) continue;
+        if (runKernel(KERNELS[k], scenario.segments, scenario.posY) != expected){
+            printf("MISMATCH %s: posY %d, pipes %d, first pipe x %d hole %d, expected %d\n", getCollisionKernelName(KERNELS[k]),
+                   scenario.posY, scenario.totalPipe, scenario.pipes[0].xPosition, scenario.pipes[0].freeSpotPosition, expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main( int argc, char* args[] )
+{
+    int scenarioCount = argc > 1 ? atoi(args[1]) : 4096;
+    int rounds = argc > 2 ? atoi(args[2]) : 2000;
+    long long checks = 0;
+    bool equal = true;
+
+    //Every hole, every egg height and every x around the egg for a single pipe, including all the edges
+    Scenario scenario;
+    scenario.totalPipe = 1;
+    for (int free = 1; free <= 4; free++){
+        for (int x = CHARACTER_X_POS - PIPE_COLLISION_WIDTH - 20; x <= CHARACTER_X_POS + CHARACTER_SIZE + 20; x++){
+            scenario.pipes[0].xPosition = x;
+            scenario.pipes[0].freeSpotPosition = free;
+            buildPipeSegments(scenario.pipes, scenario.totalPipe, scenario.segments);
+            for (int posY = -CHARACTER_SIZE - 20; posY <= SCREEN_HEIGHT + 20; posY++){
+                scenario.posY = posY;
+                equal = checkScenario(scenario) and equal;
+                checks++;
+            }
+        }
+    }
+
+    //Random worlds with several pipes, which is what the benchmark below runs
+    std::vector<Scenario> scenarios(scenarioCount);
+    srand(1);
+    for (int s = 0; s < scenarioCount; s++){
+        Scenario& random = scenarios[s];
+        random.totalPipe = rand() % MAX_PIPES + 1;
+        for (int i = 0; i < random.totalPipe; i++){
+            random.pipes[i].xPosition = CHARACTER_X_POS - 400 + rand() % 800;
+            random.pipes[i].freeSpotPosition = rand() % 4 + 1;
+        }
+        random.posY = rand() % (SCREEN_HEIGHT - FLOOR_HEIGHT);
+        buildPipeSegments(random.pipes, random.totalPipe, random.segments);
+        equal = checkScenario(random) and equal;
+        checks++;
+    }
+
+    printf("equivalence: %lld cases, %s\n", checks, equal ? "all kernels match" : "MISMATCH");
+    printf("best kernel: %s\n", getCollisionKernelName(getCollisionKernel()));
+
+    //The benchmark itself. The hits are added up so the compiler can't drop the work
+    long long tests = (long long)scenarioCount * rounds;
+    long long hits = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (int s = 0; s < scenarioCount; s++)
+            hits += slotsHitCharacter(scenarios[s].pipes, scenarios[s].totalPipe, scenarios[s].posY);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-8s %8.2f ns per world, %8.1f M worlds/s (hits %lld)\n", "slots", seconds * 1e9 / tests, tests / seconds / 1e6, hits);
+
+    for (int k = 0; k < KERNEL_COUNT; k++){
+        if (!collisionKernelSupported(KERNELS[k])) continue;
+        hits = 0;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+            for (int s = 0; s < scenarioCount; s++)
+                hits += runKernel(KERNELS[k], scenarios[s].segments, scenarios[s].posY);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-8s %8.2f ns per world, %8.1f M worlds/s (hits %lld)\n", getCollisionKernelName(KERNELS[k]), seconds * 1e9 / tests, tests / seconds / 1e6, hits);
+    }
+
+    //The batch entry point, as WorldBatch uses it
+    std::vector<SegmentList> segments(scenarioCount);
+    std::vector<int> posY(scenarioCount);
+    std::vector<unsigned char> results(scenarioCount);
+    for (int s = 0; s < scenarioCount; s++){
+        segments[s] = scenarios[s].segments;
+        posY[s] = scenarios[s].posY;
+    }
+    hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++){
+        segmentsHitCharacters(&segments[0], &posY[0], scenarioCount, &results[0]);
+        hits += results[r % scenarioCount];
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-8s %8.2f ns per world, %8.1f M worlds/s\n", "batch", seconds * 1e9 / tests, tests / seconds / 1e6);
+
+    return equal ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/** A stand-in for the other side of the ghost broadcast, to try it on one machine:
+      GhostPeer serve [port] [budget]          plays headless games at TICK_RATE and broadcasts them, for a game with --ghost
+      GhostPeer watch [host:port] [seconds]    watches a game with --broadcast and tells what arrives
+      GhostPeer loopback [ticks] [loss] [budget]  both of them in this process over 127.0.0.1, as fast as they can,
+                                                  losing loss percent of the packets, and checks every state that arrives
+      GhostPeer codec [ticks] [budget] [loss]     encodes and decodes without the network, with a budget so small that most
+                                                  new pipes have to wait, and checks that the viewer always catches up
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include "Broadcast.h"
+#include "Autopilot.h"
+
+static void playTick(World& world, unsigned int& seed){
+    WorldInput input = { heuristicFlap(world) };
+    world.step(input);
+    if (world.dead) world.restart(++seed);
+}
+
+static int serve(int port, int budget){
+    GhostServer server;
+    if (!server.start(port, budget)) return 1;
+    World world;
+    unsigned int seed = 1;
+    world.restart(seed);
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    for (unsigned int tick = 1; ; tick++){
+        playTick(world, seed);
+        server.publish(world, tick);
+        if (tick % (60 * TICK_RATE) == 0) server.printStats(stdout);
+        next += std::chrono::microseconds(1000000 / TICK_RATE);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+static int watch(const std::string& address, int seconds){
+    GhostClient client;
+    if (!client.connect(address)) return 1;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < end){
+        client.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(4));
+    }
+    if (client.hasState()){
+        const GhostState& state = client.getState();
+        printf("At tick %u the egg is at %d, %d points, %d pipes\n", state.tick, state.posY, state.points, state.pipeCount);
+    }
+    client.printStats(stdout);
+    return 0;
+}
+
+static int loopback(int ticks, int loss, int budget){
+    GhostServer server;
+    GhostClient client;
+    int port = BROADCAST_PORT + 1;
+    if (!server.start(port, budget) or !client.connect("127.0.0.1:" + std::to_string(port))) return 1;
+    client.setSimulatedLoss(loss);
+
+    World world;
+    unsigned int seed = 1;
+    world.restart(seed);
+    server.publish(world, 1);
+    int exact = 0, behind = 0, wrong = 0;
+    for (unsigned int tick = 2; tick < (unsigned int)ticks + 2; tick++){
+        playTick(world, seed);
+        server.publish(world, tick);
+
+        //Loopback is quick, but not instant
+        for (int tries = 0; tries < 1000 and client.getState().tick != tick; tries++){
+            if (!client.poll()) std::this_thread::yield();
+        }
+        if (client.getState().tick != tick) continue;
+        GhostState expected = makeGhostState(world, tick);
+        if (sameGhostState(client.getState(), expected)) exact++;
+        else{
+            //The egg has to be right anyway, only the pipes can wait for the budget
+            const GhostState& state = client.getState();
+            if (state.posY == expected.posY and state.centidegrees == expected.centidegrees and state.frame == expected.frame and state.points == expected.points) behind++;
+            else wrong++;
+        }
+    }
+    printf("%d ticks, %d%% lost: %d arrived exactly, %d with some pipes still on the way, %d wrong\n", ticks, loss, exact, behind, wrong);
+    server.printStats(stdout);
+    client.printStats(stdout);
+    return wrong > 0 ? 1 : 0;
+}
+
+static int codec(int ticks, int budget, int loss){
+    World world;
+    unsigned int seed = 1;
+    world.restart(seed);
+    srand(1);
+
+    //What the server has seen acknowledged, and what the viewer has: every packet that arrives is acknowledged right away
+    GhostState acked = emptyGhostState();
+    GhostState viewer = emptyGhostState();
+    uint8_t packet[GHOST_MAX_PACKET];
+    int trimmed = 0, overBudget = 0, wrong = 0, behind = 0, longestBehind = 0;
+    long long bytes = 0;
+    for (unsigned int tick = 1; tick <= (unsigned int)ticks; tick++){
+        playTick(world, seed);
+        GhostState current = makeGhostState(world, tick);
+        GhostState sent;
+        int size = encodeGhost(acked, current, packet, budget, sent);
+        bytes += size;
+        if (size > budget) overBudget++;
+        if (!sameGhostState(sent, current)) trimmed++;
+
+        if (rand() % 100 >= loss){
+            GhostState decoded;
+            //The egg has to arrive whole, and the pipes exactly as the server thinks they did
+            if (decodeGhost(packet, size, viewer, decoded) and sameGhostState(decoded, sent)){
+                viewer = decoded;
+                acked = sent;
+            }
+            else wrong++;
+        }
+
+        if (sameGhostState(viewer, current)) behind = 0;
+        else if (++behind > longestBehind) longestBehind = behind;
+    }
+
+    //A pipe comes every MAX_TIME_PIPE ticks, so the viewer has to have all of them well before the next one
+    bool converges = longestBehind < MAX_TIME_PIPE;
+    printf("%d ticks, budget %d, %d%% lost: %.1f bytes per tick, %d over budget, %d trimmed, %d wrong, at most %d ticks behind\n",
+           ticks, budget, loss, (double)bytes / ticks, overBudget, trimmed, wrong, longestBehind);
+    if (trimmed == 0) printf("Nothing was trimmed, a smaller budget tests more\n");
+    if (!converges) printf("The viewer doesn't catch up\n");
+    return wrong > 0 or !converges ? 1 : 0;
+}
+
+int main( int argc, char* args[] )
+{
+    std::string mode = argc > 1 ? args[1] : "loopback";
+    if (mode == "serve") return serve(argc > 2 ? atoi(args[2]) : BROADCAST_PORT, argc > 3 ? atoi(args[3]) : 64);
+    if (mode == "watch") return watch(argc > 2 ? args[2] : "127.0.0.1", argc > 3 ? atoi(args[3]) : 10);
+    if (mode == "loopback") return loopback(argc > 2 ? atoi(args[2]) : 20000, argc > 3 ? atoi(args[3]) : 0, argc > 4 ? atoi(args[4]) : 64);
+    if (mode == "codec") return codec(argc > 2 ? atoi(args[2]) : 20000, argc > 3 ? atoi(args[3]) : 16, argc > 4 ? atoi(args[4]) : 0);
+    printf("Usage: GhostPeer serve [port] [budget] | watch [host:port] [seconds] | loopback [ticks] [loss] [budget] | codec [ticks] [budget] [loss]\n");
+    return 1;
+}
@@ -0,0 +1,194 @@
+/** Checks the pixel collision masks against testing the pixels of the images one by one, and then measures what they cost:
+    one egg against its pipes, and whole batches of worlds stepped with the masks and with the boxes.
+    Usage: MaskBench [scenarios] [worlds] [ticks]
+    It needs the game images (spritedPlayer.png, pipe.png and the rest) in the working directory.
+    Returns 1 if the masks disagree with the pixels.
+*/
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "Atlas.h"
+#include "Collision.h"
+#include "CollisionMask.h"
+#include "WorldBatch.h"
+
+static const double PI = 3.14159265358979323846;
+
+//Bilinear alpha, the same as the rotated egg is drawn
+static double alphaAt(const PixelView& image, double x, double y){
+    int x0 = (int)floor(x), y0 = (int)floor(y);
+    double fx = x - x0, fy = y - y0;
+    double alpha = 0;
+    for (int dy = 0; dy <= 1; dy++){
+        for (int dx = 0; dx <= 1; dx++){
+            int px = x0 + dx, py = y0 + dy;
+            if (px < 0 or py < 0 or px >= image.width or py >= image.height) continue;
+            alpha += (image.pixels[py * image.pitch + px] >> 24) * (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy);
+        }
+    }
+    return alpha;
+}
+
+//Whether an opaque pixel of the egg lands on an opaque pixel of the pipe, going over every screen pixel around the egg
+static bool pixelsTouch(const PixelView& egg, double degrees, int posY, const PixelView& pipe, int pipeX, int freeSpot){
+    double radians = degrees * PI / 180.0;
+    double c = cos(radians), s = sin(radians);
+    double half = CHARACTER_SIZE / 2.0;
+    for (int y = posY - CHARACTER_SIZE; y < posY + 2 * CHARACTER_SIZE; y++){
+        for (int x = CHARACTER_X_POS - CHARACTER_SIZE; x < CHARACTER_X_POS + 2 * CHARACTER_SIZE; x++){
+            double u = x + 0.5 - (CHARACTER_X_POS + half), v = y + 0.5 - (posY + half);
+            if (alphaAt(egg, c * u + s * v + half - 0.5, -s * u + c * v + half - 0.5) < MASK_ALPHA_THRESHOLD) continue;
+
+            //The slot of the pipe column under this pixel
+            if (x < pipeX or x >= pipeX + pipe.width) continue;
+            int yPos = 0;
+            for (int j = 0; j < PIPE_SLOTS; j++){
+                if (j == freeSpot){
+                    yPos += FREE_SPACE;
+                    continue;
+                }
+                if (y >= yPos and y < yPos + pipe.height and (pipe.pixels[(y - yPos) * pipe.pitch + x - pipeX] >> 24) >= MASK_ALPHA_THRESHOLD) return true;
+                yPos += PIPE_TILE_HEIGHT;
+            }
+        }
+    }
+    return false;
+}
+
+//One egg and the pipes around it, as the world has them
+struct Scenario{
+    int x[MAX_PIPES];
+    int free[MAX_PIPES];
+    int totalPipe;
+    int frame;
+    double degrees;
+    int posY;
+    SegmentList segments;
+};
+
+static double randomDegrees(const PixelMasks& masks){
+    return masks.minDegrees + (rand() % masks.angleCount) * masks.step;
+}
+
+int main( int argc, char* args[] )
+{
+    int scenarioCount = argc > 1 ? atoi(args[1]) : 4096;
+    int worldCount = argc > 2 ? atoi(args[2]) : 4096;
+    int ticks = argc > 3 ? atoi(args[3]) : 600;
+
+    std::vector<AtlasRegion> regions;
+    SDL_Surface* atlas = buildGameAtlas(regions);
+    if (atlas == NULL) return 1;
+    PixelMasks masks;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool built = buildGameMasks(atlas, regions, masks);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!built) return 1;
+    printf("masks: %d egg frames at %d angles and 4 pipe columns, %.1f KB, made in %.1f ms\n", masks.eggFrames, masks.angleCount,
+           masks.getMemoryBytes() / 1024.0, seconds * 1000);
+
+    //The reference reads the pixels of the atlas itself
+    SDL_Surface* argb = SDL_ConvertSurfaceFormat(atlas, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(atlas);
+    if (argb == NULL) return 1;
+    PixelView view = { (uint32_t*)argb->pixels, argb->w, argb->h, argb->pitch / 4 };
+    const SDL_Rect& eggRect = findAtlasRegion(regions, "spritedPlayer")->rect;
+    const SDL_Rect& pipeRect = findAtlasRegion(regions, "pipe")->rect;
+    PixelView eggSheet = subView(view, eggRect.x, eggRect.y, eggRect.w, eggRect.h);
+    PixelView pipe = subView(view, pipeRect.x, pipeRect.y, pipeRect.w, pipeRect.h);
+
+    //A single pipe right next to the egg, with every frame and angle. The boxes are counted apart when they don't agree, they are not wrong
+    srand(1);
+    bool equal = true;
+    int checks = 0, boxOnly = 0, pixelsOnly = 0;
+    for (int i = 0; i < 20000; i++){
+        int frame = rand() % masks.eggFrames;
+        double degrees = randomDegrees(masks);
+        int x = CHARACTER_X_POS - PIPE_WIDTH - 10 + rand() % (PIPE_WIDTH + CHARACTER_SIZE + 20);
+        int free = rand() % 4 + 1;
+        int posY = free * PIPE_TILE_HEIGHT - CHARACTER_SIZE - 20 + rand() % (FREE_SPACE + CHARACTER_SIZE);
+
+        PixelView egg = subView(eggSheet, (frame % 2) * CHARACTER_SIZE, (frame / 2) * CHARACTER_SIZE, CHARACTER_SIZE, CHARACTER_SIZE);
+        bool expected = pixelsTouch(egg, degrees, posY, pipe, x, free);
+        bool hit = pixelsHitCharacter(masks, &x, &free, 1, frame, degrees, posY);
+        if (hit != expected){
+            printf("MISMATCH: frame %d, %g degrees, posY %d, pipe x %d hole %d, expected %d\n", frame, degrees, posY, x, free, expected);
+            equal = false;
+        }
+        SegmentList segments;
+        buildPipeSegments(&x, &free, 1, segments);
+        bool box = segmentsHitCharacter(segments, posY);
+        boxOnly += box and !hit;
+        pixelsOnly += hit and !box;
+        checks++;
+    }
+    SDL_FreeSurface(argb);
+    printf("equivalence: %d cases, %s\n", checks, equal ? "the masks match the pixels" : "MISMATCH");
+    printf("against the boxes: %d hit only the boxes, %d hit only the pixels\n", boxOnly, pixelsOnly);
+
+    //Random worlds like the ones of CollisionBench, to compare both tests one egg at a time
+    std::vector<Scenario> scenarios(scenarioCount);
+    for (int s = 0; s < scenarioCount; s++){
+        Scenario& random = scenarios[s];
+        random.totalPipe = rand() % MAX_PIPES + 1;
+        for (int i = 0; i < random.totalPipe; i++){
+            random.x[i] = CHARACTER_X_POS - 400 + rand() % 800;
+            random.free[i] = rand() % 4 + 1;
+        }
+        random.frame = rand() % masks.eggFrames;
+        random.degrees = randomDegrees(masks);
+        random.posY = rand() % (SCREEN_HEIGHT - FLOOR_HEIGHT);
+        buildPipeSegments(random.x, random.free, random.totalPipe, random.segments);
+    }
+
+    int rounds = 200;
+    long long tests = (long long)scenarioCount * rounds;
+    long long hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (int s = 0; s < scenarioCount; s++) hits += segmentsHitCharacter(scenarios[s].segments, scenarios[s].posY);
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-8s %8.2f ns per world, %8.1f M worlds/s (hits %lld)\n", "boxes", seconds * 1e9 / tests, tests / seconds / 1e6, hits);
+
+    hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++){
+        for (int s = 0; s < scenarioCount; s++){
+            const Scenario& scenario = scenarios[s];
+            hits += pixelsHitCharacter(masks, scenario.x, scenario.free, scenario.totalPipe, scenario.frame, scenario.degrees, scenario.posY);
+        }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-8s %8.2f ns per world, %8.1f M worlds/s (hits %lld)\n", "pixels", seconds * 1e9 / tests, tests / seconds / 1e6, hits);
+
+    //Whole ticks of a batch on one thread, with random flaps. A world that dies starts again, so every tick has the same worlds alive
+    std::vector<WorldInput> inputs(worldCount);
+    const char* const MODES[2] = { "boxes", "pixels" };
+    for (int mode = 0; mode < 2; mode++){
+        WorldBatch batch(worldCount, mode == 1 ? &masks : NULL);
+        batch.restartAll(1);
+        srand(2);
+        int deaths = 0;
+        double stepping = 0;
+        for (int t = 0; t < ticks; t++){
+            for (int w = 0; w < worldCount; w++) inputs[w].flap = rand() % 20 == 0;
+            start = std::chrono::steady_clock::now();
+            batch.stepRange(0, worldCount, &inputs[0]);
+            stepping += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (int w = 0; w < worldCount; w++){
+                if (!batch.dead[w]) continue;
+                deaths++;
+                batch.restart(w, t * worldCount + w);
+            }
+        }
+        double perTick = stepping / ticks;
+        printf("batch %-6s %d worlds: %8.1f us per tick (%.1f%% of a tick), %6.1f ns per world, %d deaths\n", MODES[mode], worldCount,
+               perTick * 1e6, perTick * TICK_RATE * 100, perTick * 1e9 / worldCount, deaths);
+    }
+
+    return equal ? 0 : 1;
+}
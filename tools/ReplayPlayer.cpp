@@ -0,0 +1,58 @@
+/** Plays a replay again without drawing anything, as fast as it can, and checks that it plays the same.
+    Usage: ReplayPlayer replay [repetitions]
+    Returns 1 if the replay doesn't play the same, so it can be used to catch changes in the simulation.
+    A replay played with the pixel collision needs spritedPlayer.png and pipe.png (with the rest of the game images) to make the masks.
+*/
+
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include "Replay.h"
+#include "Atlas.h"
+#include "CollisionMask.h"
+
+int main( int argc, char* args[] )
+{
+    if (argc < 2){
+        printf("Usage: ReplayPlayer replay [repetitions]\n");
+        return 1;
+    }
+    int repetitions = argc > 2 ? atoi(args[2]) : 1000;
+    if (repetitions < 1) repetitions = 1;
+
+    Replay replay;
+    if (!replay.load(args[1])) return 1;
+
+    PixelMasks masks;
+    if (replay.usesPixelCollision()){
+        std::vector<AtlasRegion> regions;
+        SDL_Surface* atlas = buildGameAtlas(regions);
+        bool built = atlas != NULL and buildGameMasks(atlas, regions, masks);
+        if (atlas != NULL) SDL_FreeSurface(atlas);
+        if (!built){
+            printf("The replay was played with the pixel collision, and its masks can't be made without the game images\n");
+            return 1;
+        }
+    }
+
+    //Played with the collision it was recorded with
+    World world;
+    if (replay.usesPixelCollision()) world.masks = &masks;
+    int desync = -1;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions and desync < 0; i++) desync = replay.play(world);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("seed: %u, ticks: %d, flaps: %d, collision: %s\n", replay.getSeed(), replay.getTickCount(), replay.getFlapCount(),
+           replay.usesPixelCollision() ? "pixels" : "boxes");
+    if (desync >= 0){
+        printf("The replay doesn't play the same since tick %d (%.2f s into the game)\n", desync, (double)desync / TICK_RATE);
+        return 1;
+    }
+
+    double ticks = (double)replay.getTickCount() * repetitions;
+    printf("points: %d, %s\n", world.points, world.dead ? "dead" : "still alive");
+    printf("played %d times in %.3f s: %.0f ticks per second, %.0f times real time\n", repetitions, seconds, ticks / seconds, ticks / seconds / TICK_RATE);
+    return 0;
+}